@@ -83,13 +83,17 @@ getCheckOptions(const ClangTidyOptions &Options,
 /// \param StoreCheckProfile If provided, and EnableCheckProfile is true,
 /// the profile will not be output to stderr, but will instead be stored
 /// as a JSON file in the specified directory.
+/// \param RemoveIncompatibleErrors If false, the fixes of the returned errors
+/// may overlap; callers merging the errors of several runs call
+/// removeIncompatibleErrors() on the merged list instead.
 std::vector<ClangTidyError>
 runClangTidy(clang::tidy::ClangTidyContext &Context,
              const tooling::CompilationDatabase &Compilations,
              ArrayRef<std::string> InputFiles,
              llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> BaseFS,
              bool ApplyAnyFix, bool EnableCheckProfile = false,
-             llvm::StringRef StoreCheckProfile = StringRef());
+             llvm::StringRef StoreCheckProfile = StringRef(),
+             bool RemoveIncompatibleErrors = true);
 
 /// Controls what kind of fixes clang-tidy is allowed to apply.
 enum FixBehaviour {
@@ -161,7 +161,7 @@ ClangTidyContext::ClangTidyContext(
     std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider,
     bool AllowEnablingAnalyzerAlphaCheckers)
     : DiagEngine(nullptr), OptionsProvider(std::move(OptionsProvider)),
-      Profile(false),
+      Profile(false), MatcherProfile(false),
       AllowEnablingAnalyzerAlphaCheckers(AllowEnablingAnalyzerAlphaCheckers),
       SelfContainedDiags(false) {
   // Before the first translation unit we can get errors related to command-line
@@ -561,7 +561,11 @@ llvm::Regex *ClangTidyDiagnosticConsumer::getHeaderFilter() {
   return HeaderFilter.get();
 }
 
-void ClangTidyDiagnosticConsumer::removeIncompatibleErrors() {
+static void removeDuplicatedDiagnosticsOfAliasCheckers(
+    std::vector<ClangTidyError> &Errors);
+
+void tidy::removeIncompatibleErrors(std::vector<ClangTidyError> &Errors,
+                                    bool GetFixesFromNotes) {
   // Each error is modelled as the set of intervals in which it applies
   // replacements. To detect overlapping replacements, we use a sweep line
   // algorithm over these sets of intervals.
@@ -632,7 +636,7 @@ void ClangTidyDiagnosticConsumer::removeIncompatibleErrors() {
     std::tuple<unsigned, EventType, int, int, unsigned> Priority;
   };
 
-  removeDuplicatedDiagnosticsOfAliasCheckers();
+  removeDuplicatedDiagnosticsOfAliasCheckers(Errors);
 
   // Compute error sizes.
   std::vector<int> Sizes;
@@ -705,24 +709,21 @@ void ClangTidyDiagnosticConsumer::removeIncompatibleErrors() {
   }
 }
 
-namespace {
-struct LessClangTidyError {
-  bool operator()(const ClangTidyError &LHS, const ClangTidyError &RHS) const {
-    const tooling::DiagnosticMessage &M1 = LHS.Message;
-    const tooling::DiagnosticMessage &M2 = RHS.Message;
-
-    return std::tie(M1.FilePath, M1.FileOffset, LHS.DiagnosticName,
-                    M1.Message) <
-           std::tie(M2.FilePath, M2.FileOffset, RHS.DiagnosticName, M2.Message);
-  }
-};
-struct EqualClangTidyError {
-  bool operator()(const ClangTidyError &LHS, const ClangTidyError &RHS) const {
-    LessClangTidyError Less;
-    return !Less(LHS, RHS) && !Less(RHS, LHS);
-  }
-};
-} // end anonymous namespace
+bool LessClangTidyError::operator()(const ClangTidyError &LHS,
+                                    const ClangTidyError &RHS) const {
+  const tooling::DiagnosticMessage &M1 = LHS.Message;
+  const tooling::DiagnosticMessage &M2 = RHS.Message;
+
+  return std::tie(M1.FilePath, M1.FileOffset, LHS.DiagnosticName,
+                  M1.Message) <
+         std::tie(M2.FilePath, M2.FileOffset, RHS.DiagnosticName, M2.Message);
+}
+
+bool EqualClangTidyError::operator()(const ClangTidyError &LHS,
+                                     const ClangTidyError &RHS) const {
+  LessClangTidyError Less;
+  return !Less(LHS, RHS) && !Less(RHS, LHS);
+}
 
 std::vector<ClangTidyError> ClangTidyDiagnosticConsumer::take() {
   finalizeLastError();
@@ -731,7 +732,7 @@ std::vector<ClangTidyError> ClangTidyDiagnosticConsumer::take() {
   Errors.erase(std::unique(Errors.begin(), Errors.end(), EqualClangTidyError()),
                Errors.end());
   if (RemoveIncompatibleErrors)
-    removeIncompatibleErrors();
+    removeIncompatibleErrors(Errors, GetFixesFromNotes);
   return std::move(Errors);
 }
 
@@ -747,7 +748,8 @@ struct LessClangTidyErrorWithoutDiagnosticName {
 };
 } // end anonymous namespace
 
-void ClangTidyDiagnosticConsumer::removeDuplicatedDiagnosticsOfAliasCheckers() {
+static void removeDuplicatedDiagnosticsOfAliasCheckers(
+    std::vector<ClangTidyError> &Errors) {
   using UniqueErrorSet =
       std::set<ClangTidyError *, LessClangTidyErrorWithoutDiagnosticName>;
   UniqueErrorSet UniqueErrors;
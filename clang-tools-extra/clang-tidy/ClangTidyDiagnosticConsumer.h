@@ -41,6 +41,18 @@ struct ClangTidyError : tooling::Diagnostic {
   std::vector<std::string> EnabledDiagnosticAliases;
 };
 
+/// Orders errors by file, offset, check name and message. Errors that are
+/// equivalent in this order are duplicates, e.g. the same diagnostic in a
+/// header reported by several translation units.
+struct LessClangTidyError {
+  bool operator()(const ClangTidyError &LHS, const ClangTidyError &RHS) const;
+};
+
+/// Whether two errors are duplicates according to \c LessClangTidyError.
+struct EqualClangTidyError {
+  bool operator()(const ClangTidyError &LHS, const ClangTidyError &RHS) const;
+};
+
 /// Contains displayed and ignored diagnostic counters for a ClangTidy run.
 struct ClangTidyStats {
   unsigned ErrorsDisplayed = 0;
@@ -167,6 +179,10 @@ public:
   void setEnableProfiling(bool Profile);
   bool getEnableProfiling() const { return Profile; }
 
+  /// Control per-matcher profiling. Only used if profiling is enabled.
+  void setEnableMatcherProfiling(bool Profile) { MatcherProfile = Profile; }
+  bool getEnableMatcherProfiling() const { return MatcherProfile; }
+
   /// Control storage of profile date.
   void setProfileStoragePrefix(StringRef ProfilePrefix);
   llvm::Optional<ClangTidyProfiling::StorageParams>
@@ -229,6 +245,7 @@ private:
   llvm::DenseMap<unsigned, std::string> CheckNamesByDiagnosticID;
 
   bool Profile;
+  bool MatcherProfile;
   std::string ProfilePrefix;
 
   bool AllowEnablingAnalyzerAlphaCheckers;
@@ -246,6 +263,12 @@ private:
 const llvm::StringMap<tooling::Replacements> *
 getFixIt(const tooling::Diagnostic &Diagnostic, bool AnyFix);
 
+/// Merges the duplicated diagnostics of alias checkers in \p Errors and
+/// drops the fixes that overlap with the fix of another error, adding a note
+/// to the error instead. \p GetFixesFromNotes is passed to \c getFixIt.
+void removeIncompatibleErrors(std::vector<ClangTidyError> &Errors,
+                              bool GetFixesFromNotes);
+
 /// A diagnostic consumer that turns each \c Diagnostic into a
 /// \c SourceManager-independent \c ClangTidyError.
 // FIXME: If we move away from unit-tests, this can be moved to a private
@@ -271,8 +294,6 @@ public:
 
 private:
   void finalizeLastError();
-  void removeIncompatibleErrors();
-  void removeDuplicatedDiagnosticsOfAliasCheckers();
 
   /// Returns the \c HeaderFilter constructed for the options set in the
   /// context.
@@ -0,0 +1,650 @@
+//===--- ClangTidyParallel.cpp - clang-tidy -------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ClangTidyParallel.h"
+#include "ClangTidy.h"
+#include "clang/Basic/Version.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/DiagnosticsYaml.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/xxhash.h"
+#include <atomic>
+#include <mutex>
+#include <optional>
+
+using namespace clang::tooling;
+
+namespace clang {
+namespace tidy {
+namespace {
+
+struct CachedDependency {
+  /// What the translation unit observed about \c Path. A cached result is only
+  /// reused if every observation still holds, so adding a file that shadows
+  /// one found later on the include path invalidates it as well.
+  enum DependencyKind {
+    /// The path did not exist.
+    DK_Missing,
+    /// The path existed; \c Hash is its file type. Its contents were not read,
+    /// e.g. for directories on the include path or \c __has_include.
+    DK_Exists,
+    /// The file was read; \c Hash is the hash of its contents.
+    DK_Contents,
+    /// The directory was listed; \c Hash is the hash of its entries.
+    DK_Listing,
+  };
+
+  std::string Path;
+  DependencyKind Kind = DK_Contents;
+  llvm::yaml::Hex64 Hash = 0;
+};
+
+struct CachedError {
+  tooling::Diagnostic Diag;
+  bool IsWarningAsError = false;
+  std::vector<std::string> EnabledDiagnosticAliases;
+};
+
+/// The cached result of running clang-tidy on one translation unit.
+struct CacheEntry {
+  /// Every file lookup, read and directory listing done while processing the
+  /// translation unit, with its result at that time.
+  std::vector<CachedDependency> Dependencies;
+  std::vector<CachedError> Errors;
+  ClangTidyStats Stats;
+};
+
+} // namespace
+} // namespace tidy
+} // namespace clang
+
+LLVM_YAML_IS_SEQUENCE_VECTOR(clang::tidy::CachedDependency)
+LLVM_YAML_IS_SEQUENCE_VECTOR(clang::tidy::CachedError)
+
+namespace llvm {
+namespace yaml {
+
+template <>
+struct ScalarEnumerationTraits<
+    clang::tidy::CachedDependency::DependencyKind> {
+  static void enumeration(IO &IO,
+                          clang::tidy::CachedDependency::DependencyKind &Kind) {
+    IO.enumCase(Kind, "Missing", clang::tidy::CachedDependency::DK_Missing);
+    IO.enumCase(Kind, "Exists", clang::tidy::CachedDependency::DK_Exists);
+    IO.enumCase(Kind, "Contents", clang::tidy::CachedDependency::DK_Contents);
+    IO.enumCase(Kind, "Listing", clang::tidy::CachedDependency::DK_Listing);
+  }
+};
+
+template <> struct MappingTraits<clang::tidy::CachedDependency> {
+  static void mapping(IO &IO, clang::tidy::CachedDependency &D) {
+    IO.mapRequired("Path", D.Path);
+    IO.mapRequired("Kind", D.Kind);
+    IO.mapRequired("Hash", D.Hash);
+  }
+};
+
+template <> struct MappingTraits<clang::tidy::CachedError> {
+  static void mapping(IO &IO, clang::tidy::CachedError &E) {
+    IO.mapRequired("Diagnostic", E.Diag);
+    IO.mapOptional("IsWarningAsError", E.IsWarningAsError, false);
+    IO.mapOptional("EnabledDiagnosticAliases", E.EnabledDiagnosticAliases);
+  }
+};
+
+template <> struct MappingTraits<clang::tidy::CacheEntry> {
+  static void mapping(IO &IO, clang::tidy::CacheEntry &E) {
+    IO.mapRequired("Dependencies", E.Dependencies);
+    IO.mapOptional("Errors", E.Errors);
+    IO.mapOptional("ErrorsDisplayed", E.Stats.ErrorsDisplayed, 0u);
+    IO.mapOptional("ErrorsIgnoredCheckFilter",
+                   E.Stats.ErrorsIgnoredCheckFilter, 0u);
+    IO.mapOptional("ErrorsIgnoredNOLINT", E.Stats.ErrorsIgnoredNOLINT, 0u);
+    IO.mapOptional("ErrorsIgnoredNonUserCode",
+                   E.Stats.ErrorsIgnoredNonUserCode, 0u);
+    IO.mapOptional("ErrorsIgnoredLineFilter", E.Stats.ErrorsIgnoredLineFilter,
+                   0u);
+  }
+};
+
+} // namespace yaml
+} // namespace llvm
+
+namespace clang {
+namespace tidy {
+namespace {
+
+/// Stats, contents and directory listings of files, shared by all workers.
+/// Stats and listings are never invalidated, so that all workers see the same
+/// file system: the inputs are assumed not to change during a run. Contents
+/// are evicted, least recently used first, once their total size exceeds the
+/// limit; buffers handed out keep their contents alive.
+class SharedFileCache {
+public:
+  struct Contents {
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    uint64_t Hash = 0;
+  };
+
+  SharedFileCache(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS,
+                  uint64_t SizeLimit)
+      : FS(std::move(FS)), SizeLimit(SizeLimit) {}
+
+  llvm::ErrorOr<llvm::vfs::Status> status(StringRef AbsPath) {
+    {
+      std::lock_guard<std::mutex> Lock(Mu);
+      auto It = Stats.find(AbsPath);
+      if (It != Stats.end())
+        return It->second;
+    }
+    llvm::ErrorOr<llvm::vfs::Status> Result = FS->status(AbsPath);
+    std::lock_guard<std::mutex> Lock(Mu);
+    return Stats.try_emplace(AbsPath, std::move(Result)).first->second;
+  }
+
+  /// Returns the contents of \p AbsPath, reading it on first access. Read
+  /// failures are not cached.
+  llvm::ErrorOr<std::shared_ptr<const Contents>> contents(StringRef AbsPath) {
+    {
+      std::lock_guard<std::mutex> Lock(Mu);
+      auto It = Files.find(AbsPath);
+      if (It != Files.end()) {
+        It->second.LastUse = ++UseCounter;
+        return It->second.C;
+      }
+    }
+    auto Buffer = FS->getBufferForFile(AbsPath);
+    if (!Buffer)
+      return Buffer.getError();
+    auto C = std::make_shared<Contents>();
+    C->Hash = llvm::xxHash64((*Buffer)->getBuffer());
+    C->Buffer = std::move(*Buffer);
+    std::lock_guard<std::mutex> Lock(Mu);
+    // If another worker read the file concurrently, keep its copy.
+    auto Inserted = Files.try_emplace(AbsPath, FileEntry{C, ++UseCounter});
+    if (!Inserted.second)
+      return Inserted.first->second.C;
+    TotalSize += C->Buffer->getBufferSize();
+    if (TotalSize > SizeLimit)
+      evictUnlocked();
+    return std::shared_ptr<const Contents>(std::move(C));
+  }
+
+  /// Returns a hash of the names and types of the entries of the directory
+  /// \p AbsPath, independent of the order in which they are listed.
+  llvm::ErrorOr<uint64_t> listing(StringRef AbsPath) {
+    {
+      std::lock_guard<std::mutex> Lock(Mu);
+      auto It = Listings.find(AbsPath);
+      if (It != Listings.end())
+        return It->second;
+    }
+    std::error_code EC;
+    std::vector<std::string> Entries;
+    for (llvm::vfs::directory_iterator It = FS->dir_begin(AbsPath, EC), End;
+         !EC && It != End; It.increment(EC))
+      Entries.push_back(
+          (llvm::sys::path::filename(It->path()) + Twine('\0') +
+           Twine(static_cast<unsigned>(It->type())))
+              .str());
+    llvm::ErrorOr<uint64_t> Result = EC;
+    if (!EC) {
+      llvm::sort(Entries);
+      Result = llvm::xxHash64(llvm::join(Entries, StringRef("\0", 1)));
+    }
+    std::lock_guard<std::mutex> Lock(Mu);
+    return Listings.try_emplace(AbsPath, Result).first->second;
+  }
+
+  llvm::vfs::FileSystem &fileSystem() { return *FS; }
+
+private:
+  struct FileEntry {
+    std::shared_ptr<const Contents> C;
+    uint64_t LastUse = 0;
+  };
+
+  /// Drops the least recently used contents until they take at most three
+  /// quarters of the limit, so that evictions are rare.
+  void evictUnlocked() {
+    std::vector<llvm::StringMapEntry<FileEntry> *> ByUse;
+    for (llvm::StringMapEntry<FileEntry> &Entry : Files)
+      ByUse.push_back(&Entry);
+    llvm::sort(ByUse, [](const llvm::StringMapEntry<FileEntry> *L,
+                         const llvm::StringMapEntry<FileEntry> *R) {
+      return L->getValue().LastUse < R->getValue().LastUse;
+    });
+    for (llvm::StringMapEntry<FileEntry> *Entry : ByUse) {
+      if (TotalSize <= SizeLimit / 4 * 3)
+        break;
+      TotalSize -= Entry->getValue().C->Buffer->getBufferSize();
+      Files.erase(Entry->getKey());
+    }
+  }
+
+  llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS;
+  const uint64_t SizeLimit;
+  std::mutex Mu;
+  llvm::StringMap<llvm::ErrorOr<llvm::vfs::Status>> Stats;
+  llvm::StringMap<llvm::ErrorOr<uint64_t>> Listings;
+  llvm::StringMap<FileEntry> Files;
+  uint64_t TotalSize = 0;
+  uint64_t UseCounter = 0;
+};
+
+/// A buffer referring to cached contents, which it keeps alive.
+class CachedBuffer : public llvm::MemoryBuffer {
+public:
+  CachedBuffer(std::shared_ptr<const SharedFileCache::Contents> Contents,
+               const Twine &Name, bool RequiresNullTerminator)
+      : Contents(std::move(Contents)), Name(Name.str()) {
+    const llvm::MemoryBuffer &Buffer = *this->Contents->Buffer;
+    init(Buffer.getBufferStart(), Buffer.getBufferEnd(),
+         RequiresNullTerminator);
+  }
+
+  StringRef getBufferIdentifier() const override { return Name; }
+
+  BufferKind getBufferKind() const override { return MemoryBuffer_Malloc; }
+
+private:
+  std::shared_ptr<const SharedFileCache::Contents> Contents;
+  std::string Name;
+};
+
+class CachedFile : public llvm::vfs::File {
+public:
+  CachedFile(llvm::vfs::Status Stat,
+             std::shared_ptr<const SharedFileCache::Contents> Contents)
+      : Stat(std::move(Stat)), Contents(std::move(Contents)) {}
+
+  llvm::ErrorOr<llvm::vfs::Status> status() override { return Stat; }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    return std::make_unique<CachedBuffer>(Contents, Name,
+                                          RequiresNullTerminator);
+  }
+
+  std::error_code close() override { return {}; }
+
+private:
+  llvm::vfs::Status Stat;
+  std::shared_ptr<const SharedFileCache::Contents> Contents;
+};
+
+/// The file system seen by one worker. It keeps its own working directory,
+/// since changing it on the underlying (real) file system would affect the
+/// whole process, and records the lookups, reads and directory listings done
+/// since the last takeDependencies().
+class WorkerFileSystem : public llvm::vfs::FileSystem {
+public:
+  WorkerFileSystem(SharedFileCache &Cache, std::string WorkingDirectory)
+      : Cache(Cache), WorkingDirectory(std::move(WorkingDirectory)) {}
+
+  llvm::ErrorOr<llvm::vfs::Status> status(const Twine &Path) override {
+    SmallString<256> AbsPath;
+    if (std::error_code EC = absolutePath(Path, AbsPath))
+      return EC;
+    llvm::ErrorOr<llvm::vfs::Status> Result = Cache.status(AbsPath);
+    recordStatus(AbsPath, Result);
+    if (!Result || Result->ExposesExternalVFSPath)
+      return Result;
+    return llvm::vfs::Status::copyWithNewName(*Result, Path);
+  }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+  openFileForRead(const Twine &Path) override {
+    SmallString<256> AbsPath;
+    if (std::error_code EC = absolutePath(Path, AbsPath))
+      return EC;
+    llvm::ErrorOr<llvm::vfs::Status> Stat = Cache.status(AbsPath);
+    recordStatus(AbsPath, Stat);
+    if (!Stat)
+      return Stat.getError();
+    if (Stat->isDirectory())
+      return Cache.fileSystem().openFileForRead(AbsPath);
+    auto Contents = Cache.contents(AbsPath);
+    if (!Contents)
+      return Contents.getError();
+    record(AbsPath, CachedDependency::DK_Contents, (*Contents)->Hash);
+    if (!Stat->ExposesExternalVFSPath)
+      Stat = llvm::vfs::Status::copyWithNewName(*Stat, Path);
+    return std::make_unique<CachedFile>(std::move(*Stat), std::move(*Contents));
+  }
+
+  llvm::vfs::directory_iterator dir_begin(const Twine &Dir,
+                                          std::error_code &EC) override {
+    SmallString<256> AbsPath;
+    if ((EC = absolutePath(Dir, AbsPath)))
+      return {};
+    llvm::ErrorOr<uint64_t> Listing = Cache.listing(AbsPath);
+    if (Listing)
+      Listings[AbsPath] = *Listing;
+    else
+      record(AbsPath, CachedDependency::DK_Missing, 0);
+    return Cache.fileSystem().dir_begin(AbsPath, EC);
+  }
+
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override {
+    SmallString<256> AbsPath;
+    if (std::error_code EC = absolutePath(Path, AbsPath))
+      return EC;
+    llvm::ErrorOr<llvm::vfs::Status> Stat = Cache.status(AbsPath);
+    if (!Stat)
+      return Stat.getError();
+    if (!Stat->isDirectory())
+      return std::make_error_code(std::errc::not_a_directory);
+    WorkingDirectory = std::string(AbsPath);
+    return {};
+  }
+
+  llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+    return WorkingDirectory;
+  }
+
+  std::error_code getRealPath(const Twine &Path,
+                              SmallVectorImpl<char> &Output) const override {
+    SmallString<256> AbsPath;
+    if (std::error_code EC = absolutePath(Path, AbsPath))
+      return EC;
+    return Cache.fileSystem().getRealPath(AbsPath, Output);
+  }
+
+  std::error_code isLocal(const Twine &Path, bool &Result) override {
+    SmallString<256> AbsPath;
+    if (std::error_code EC = absolutePath(Path, AbsPath))
+      return EC;
+    return Cache.fileSystem().isLocal(AbsPath, Result);
+  }
+
+  std::vector<CachedDependency> takeDependencies() {
+    std::vector<CachedDependency> Result;
+    Result.reserve(Lookups.size() + Listings.size());
+    for (const auto &Entry : Lookups)
+      Result.push_back(Entry.getValue());
+    for (const auto &Entry : Listings)
+      Result.push_back({Entry.getKey().str(), CachedDependency::DK_Listing,
+                        Entry.getValue()});
+    llvm::sort(Result, [](const CachedDependency &L, const CachedDependency &R) {
+      return std::tie(L.Path, L.Kind) < std::tie(R.Path, R.Kind);
+    });
+    Lookups.clear();
+    Listings.clear();
+    return Result;
+  }
+
+private:
+  std::error_code absolutePath(const Twine &Path,
+                               SmallVectorImpl<char> &Result) const {
+    Path.toVector(Result);
+    if (std::error_code EC = makeAbsolute(Result))
+      return EC;
+    llvm::sys::path::remove_dots(Result, /*remove_dot_dot=*/false);
+    return {};
+  }
+
+  void recordStatus(StringRef AbsPath,
+                    const llvm::ErrorOr<llvm::vfs::Status> &Stat) {
+    if (Stat)
+      record(AbsPath, CachedDependency::DK_Exists,
+             static_cast<uint64_t>(Stat->getType()));
+    else
+      record(AbsPath, CachedDependency::DK_Missing, 0);
+  }
+
+  /// Records a lookup of \p AbsPath. Reading a file supersedes finding it,
+  /// which supersedes not finding it.
+  void record(StringRef AbsPath, CachedDependency::DependencyKind Kind,
+              uint64_t Hash) {
+    auto Inserted = Lookups.try_emplace(AbsPath);
+    CachedDependency &Dep = Inserted.first->getValue();
+    if (!Inserted.second && Dep.Kind >= Kind)
+      return;
+    Dep.Path = std::string(AbsPath);
+    Dep.Kind = Kind;
+    Dep.Hash = Hash;
+  }
+
+  SharedFileCache &Cache;
+  std::string WorkingDirectory;
+  llvm::StringMap<CachedDependency> Lookups;
+  llvm::StringMap<uint64_t> Listings;
+};
+
+struct TranslationUnitResult {
+  std::vector<ClangTidyError> Errors;
+  ClangTidyStats Stats;
+  bool Cached = false;
+};
+
+void addStats(ClangTidyStats &To, const ClangTidyStats &From) {
+  To.ErrorsDisplayed += From.ErrorsDisplayed;
+  To.ErrorsIgnoredCheckFilter += From.ErrorsIgnoredCheckFilter;
+  To.ErrorsIgnoredNOLINT += From.ErrorsIgnoredNOLINT;
+  To.ErrorsIgnoredNonUserCode += From.ErrorsIgnoredNonUserCode;
+  To.ErrorsIgnoredLineFilter += From.ErrorsIgnoredLineFilter;
+}
+
+ClangTidyStats subtractStats(const ClangTidyStats &After,
+                             const ClangTidyStats &Before) {
+  ClangTidyStats Result;
+  Result.ErrorsDisplayed = After.ErrorsDisplayed - Before.ErrorsDisplayed;
+  Result.ErrorsIgnoredCheckFilter =
+      After.ErrorsIgnoredCheckFilter - Before.ErrorsIgnoredCheckFilter;
+  Result.ErrorsIgnoredNOLINT =
+      After.ErrorsIgnoredNOLINT - Before.ErrorsIgnoredNOLINT;
+  Result.ErrorsIgnoredNonUserCode =
+      After.ErrorsIgnoredNonUserCode - Before.ErrorsIgnoredNonUserCode;
+  Result.ErrorsIgnoredLineFilter =
+      After.ErrorsIgnoredLineFilter - Before.ErrorsIgnoredLineFilter;
+  return Result;
+}
+
+/// Computes the part of the cache key that does not depend on file contents:
+/// everything that may change the diagnostics produced for \p AbsFile.
+std::string cacheKey(const ClangTidyContext &Context,
+                     const CompilationDatabase &Compilations,
+                     StringRef AbsFile, const ParallelRunOptions &Opts) {
+  std::string Key;
+  llvm::raw_string_ostream OS(Key);
+  OS << getClangFullVersion() << '\0' << AbsFile << '\0';
+  for (const CompileCommand &Cmd : Compilations.getCompileCommands(AbsFile)) {
+    OS << Cmd.Directory << '\0';
+    for (const std::string &Arg : Cmd.CommandLine)
+      OS << Arg << '\0';
+  }
+  OS << configurationAsText(Context.getOptionsForFile(AbsFile)) << '\0';
+  for (const FileFilter &Filter : Context.getGlobalOptions().LineFilter) {
+    OS << Filter.Name << '\0';
+    for (const FileFilter::LineRange &Range : Filter.LineRanges)
+      OS << Range.first << '-' << Range.second << '\0';
+  }
+  OS << Context.canEnableAnalyzerAlphaCheckers() << Opts.ApplyAnyFix;
+  OS.flush();
+  return llvm::utohexstr(llvm::xxHash64(Key), /*LowerCase=*/true);
+}
+
+/// Whether \p Dep still describes the file system.
+bool isUpToDate(const CachedDependency &Dep, SharedFileCache &Files) {
+  switch (Dep.Kind) {
+  case CachedDependency::DK_Missing:
+    return !Files.status(Dep.Path);
+  case CachedDependency::DK_Exists: {
+    auto Stat = Files.status(Dep.Path);
+    return Stat && static_cast<uint64_t>(Stat->getType()) == Dep.Hash;
+  }
+  case CachedDependency::DK_Contents: {
+    auto Contents = Files.contents(Dep.Path);
+    return Contents && (*Contents)->Hash == Dep.Hash;
+  }
+  case CachedDependency::DK_Listing: {
+    auto Listing = Files.listing(Dep.Path);
+    return Listing && *Listing == Dep.Hash;
+  }
+  }
+  llvm_unreachable("Unknown dependency kind");
+}
+
+std::optional<TranslationUnitResult>
+readCacheEntry(StringRef EntryPath, SharedFileCache &Files) {
+  auto Buffer = llvm::MemoryBuffer::getFile(EntryPath);
+  if (!Buffer)
+    return std::nullopt;
+  CacheEntry Entry;
+  llvm::yaml::Input YIn((*Buffer)->getBuffer());
+  YIn >> Entry;
+  if (YIn.error())
+    return std::nullopt;
+  for (const CachedDependency &Dep : Entry.Dependencies)
+    if (!isUpToDate(Dep, Files))
+      return std::nullopt;
+
+  TranslationUnitResult Result;
+  Result.Cached = true;
+  Result.Stats = Entry.Stats;
+  for (CachedError &Cached : Entry.Errors) {
+    ClangTidyError Error(Cached.Diag.DiagnosticName, Cached.Diag.DiagLevel,
+                         Cached.Diag.BuildDirectory, Cached.IsWarningAsError);
+    static_cast<tooling::Diagnostic &>(Error) = std::move(Cached.Diag);
+    Error.EnabledDiagnosticAliases = std::move(Cached.EnabledDiagnosticAliases);
+    Result.Errors.push_back(std::move(Error));
+  }
+  return Result;
+}
+
+void writeCacheEntry(StringRef EntryPath,
+                     std::vector<CachedDependency> Dependencies,
+                     const TranslationUnitResult &Result) {
+  CacheEntry Entry;
+  Entry.Dependencies = std::move(Dependencies);
+  Entry.Stats = Result.Stats;
+  for (const ClangTidyError &Error : Result.Errors)
+    Entry.Errors.push_back(
+        {Error, Error.IsWarningAsError, Error.EnabledDiagnosticAliases});
+
+  std::string TempPathModel = (EntryPath + "-%%%%%%%%.tmp").str();
+  if (llvm::Error Err = llvm::writeFileAtomically(
+          TempPathModel, EntryPath, [&](llvm::raw_ostream &OS) {
+            llvm::yaml::Output YOut(OS);
+            YOut << Entry;
+            return llvm::Error::success();
+          }))
+    llvm::errs() << "Failed to write clang-tidy cache entry " << EntryPath
+                 << ": " << llvm::toString(std::move(Err)) << "\n";
+}
+
+} // namespace
+
+ParallelRunResult runClangTidyParallel(
+    llvm::function_ref<std::unique_ptr<ClangTidyContext>()> CreateContext,
+    const CompilationDatabase &Compilations, ArrayRef<std::string> InputFiles,
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> BaseFS,
+    const ParallelRunOptions &Opts) {
+  ParallelRunResult Result;
+  if (InputFiles.empty())
+    return Result;
+
+  auto InitialWorkingDir = BaseFS->getCurrentWorkingDirectory();
+  if (!InitialWorkingDir)
+    llvm::report_fatal_error("Cannot get current working path.");
+
+  // Results are not cached while profiling, as a cache hit has no profile.
+  bool UseCache = !Opts.CacheDirectory.empty() && !Opts.EnableCheckProfile;
+  if (UseCache) {
+    if (std::error_code EC =
+            llvm::sys::fs::create_directories(Opts.CacheDirectory)) {
+      llvm::errs() << "Cannot create cache directory " << Opts.CacheDirectory
+                   << ": " << EC.message() << "\n";
+      UseCache = false;
+    }
+  }
+
+  llvm::ThreadPoolStrategy Strategy = llvm::hardware_concurrency(Opts.Jobs);
+  unsigned Jobs = std::min<size_t>(
+      std::max(Strategy.compute_thread_count(), 1u), InputFiles.size());
+  std::vector<std::unique_ptr<ClangTidyContext>> Contexts;
+  for (unsigned I = 0; I < Jobs; ++I)
+    Contexts.push_back(CreateContext());
+
+  SharedFileCache Files(BaseFS, Opts.FileCacheSizeLimit);
+  std::vector<TranslationUnitResult> PerFile(InputFiles.size());
+  std::atomic<size_t> NextFile = 0;
+
+  auto RunWorker = [&](ClangTidyContext &Context) {
+    llvm::IntrusiveRefCntPtr<WorkerFileSystem> FS(
+        new WorkerFileSystem(Files, *InitialWorkingDir));
+    for (size_t I = NextFile++; I < InputFiles.size(); I = NextFile++) {
+      const std::string &File = InputFiles[I];
+      SmallString<256> EntryPath;
+      if (UseCache) {
+        auto AbsFile = getAbsolutePath(*FS, File);
+        if (AbsFile) {
+          EntryPath = Opts.CacheDirectory;
+          llvm::sys::path::append(
+              EntryPath,
+              cacheKey(Context, Compilations, *AbsFile, Opts) + ".yaml");
+          if (auto Cached = readCacheEntry(EntryPath, Files)) {
+            PerFile[I] = std::move(*Cached);
+            continue;
+          }
+        } else {
+          llvm::consumeError(AbsFile.takeError());
+        }
+      }
+
+      ClangTidyStats Before = Context.getStats();
+      FS->takeDependencies();
+      TranslationUnitResult &R = PerFile[I];
+      R.Errors = runClangTidy(
+          Context, Compilations, File,
+          llvm::makeIntrusiveRefCnt<llvm::vfs::OverlayFileSystem>(FS),
+          Opts.ApplyAnyFix, Opts.EnableCheckProfile, Opts.StoreCheckProfile,
+          /*RemoveIncompatibleErrors=*/false);
+      R.Stats = subtractStats(Context.getStats(), Before);
+      if (!EntryPath.empty())
+        writeCacheEntry(EntryPath, FS->takeDependencies(), R);
+    }
+  };
+
+  {
+    llvm::ThreadPool Pool(llvm::hardware_concurrency(Jobs));
+    for (std::unique_ptr<ClangTidyContext> &Context : Contexts)
+      Pool.async([&RunWorker, &Context] { RunWorker(*Context); });
+    Pool.wait();
+  }
+
+  for (TranslationUnitResult &R : PerFile) {
+    std::move(R.Errors.begin(), R.Errors.end(),
+              std::back_inserter(Result.Errors));
+    addStats(Result.Stats, R.Stats);
+    if (R.Cached)
+      ++Result.CachedTranslationUnits;
+  }
+  // The same diagnostic in a header is reported by every translation unit
+  // that includes it; keep one copy, as a serial run does. Fixes from
+  // different translation units may overlap, so conflicts are only resolved
+  // on the merged list.
+  llvm::stable_sort(Result.Errors, LessClangTidyError());
+  Result.Errors.erase(std::unique(Result.Errors.begin(), Result.Errors.end(),
+                                  EqualClangTidyError()),
+                      Result.Errors.end());
+  removeIncompatibleErrors(Result.Errors, Opts.ApplyAnyFix);
+  return Result;
+}
+
+} // end namespace tidy
+} // end namespace clang
@@ -0,0 +1,76 @@
+//===--- ClangTidyParallel.h - clang-tidy -----------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Runs clang-tidy over many translation units in a single process. Workers
+// share a cache of file contents and stats, so headers included by many
+// translation units are read from disk once, and per-translation-unit results
+// can be persisted in a cache directory and reused by later runs.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDYPARALLEL_H
+#define LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDYPARALLEL_H
+
+#include "ClangTidyDiagnosticConsumer.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace tooling {
+class CompilationDatabase;
+} // namespace tooling
+
+namespace tidy {
+
+struct ParallelRunOptions {
+  /// Number of worker threads. 0 uses all hardware threads.
+  unsigned Jobs = 0;
+  /// If not empty, results of each translation unit are stored in this
+  /// directory and reused while the translation unit, the files it read, its
+  /// compile command and its clang-tidy configuration stay the same, and the
+  /// files it looked up but did not find are still missing.
+  std::string CacheDirectory;
+  /// Maximum total size of the file contents kept in memory for the workers.
+  uint64_t FileCacheSizeLimit = uint64_t(1) << 30;
+  bool ApplyAnyFix = false;
+  bool EnableCheckProfile = false;
+  std::string StoreCheckProfile;
+};
+
+struct ParallelRunResult {
+  /// Errors of all translation units, sorted and with duplicates (e.g. the
+  /// same warning in a header included by several files) removed.
+  std::vector<ClangTidyError> Errors;
+  /// Sum of the statistics of all translation units.
+  ClangTidyStats Stats;
+  /// Number of translation units whose results were read from the cache.
+  unsigned CachedTranslationUnits = 0;
+};
+
+/// Runs clang-tidy checks on \p InputFiles using a pool of worker threads.
+///
+/// ClangTidyContext is not thread-safe, so \p CreateContext is called once per
+/// worker, on the calling thread, before any work starts. The contexts must
+/// share the same configuration.
+///
+/// \p BaseFS is only accessed with absolute paths and never has its working
+/// directory changed, so it may be the real file system.
+ParallelRunResult runClangTidyParallel(
+    llvm::function_ref<std::unique_ptr<ClangTidyContext>()> CreateContext,
+    const tooling::CompilationDatabase &Compilations,
+    ArrayRef<std::string> InputFiles,
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> BaseFS,
+    const ParallelRunOptions &Opts);
+
+} // end namespace tidy
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLS_EXTRA_CLANG_TIDY_CLANGTIDYPARALLEL_H
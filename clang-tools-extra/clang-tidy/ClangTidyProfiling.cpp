@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "ClangTidyProfiling.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
@@ -38,6 +39,8 @@ ClangTidyProfiling::StorageParams::StorageParams(llvm::StringRef ProfilePrefix,
 
 void ClangTidyProfiling::printUserFriendlyTable(llvm::raw_ostream &OS) {
   TG->print(OS);
+  if (MatcherTG)
+    MatcherTG->print(OS);
   OS.flush();
 }
 
@@ -46,7 +49,17 @@ void ClangTidyProfiling::printAsJSON(llvm::raw_ostream &OS) {
   OS << "\"file\": \"" << Storage->SourceFilename << "\",\n";
   OS << "\"timestamp\": \"" << Storage->Timestamp << "\",\n";
   OS << "\"profile\": {\n";
-  TG->printJSONValues(OS, "");
+  const char *Delim = TG->printJSONValues(OS, "");
+  if (MatcherTG) {
+    Delim = MatcherTG->printJSONValues(OS, Delim);
+    for (const auto &Entry : MatcherRecords) {
+      OS << Delim << "\t\"count.clang-tidy-matchers." << Entry.getKey()
+         << ".invocations\": " << Entry.getValue().Invocations;
+      Delim = ",\n";
+      OS << Delim << "\t\"count.clang-tidy-matchers." << Entry.getKey()
+         << ".matches\": " << Entry.getValue().Matches;
+    }
+  }
   OS << "\n}\n";
   OS << "}\n";
   OS.flush();
@@ -74,11 +87,27 @@ void ClangTidyProfiling::storeProfileData() {
   printAsJSON(OS);
 }
 
+ClangTidyProfiling::ClangTidyProfiling() = default;
+
 ClangTidyProfiling::ClangTidyProfiling(llvm::Optional<StorageParams> Storage)
     : Storage(std::move(Storage)) {}
 
 ClangTidyProfiling::~ClangTidyProfiling() {
   TG.emplace("clang-tidy", "clang-tidy checks profiling", Records);
+  if (!MatcherRecords.empty()) {
+    // Match counts are part of the timer names in the table, and separate
+    // values in JSON.
+    llvm::StringMap<llvm::TimeRecord> MatcherTimes;
+    for (const auto &Entry : MatcherRecords) {
+      std::string Name = Entry.getKey().str();
+      if (!Storage)
+        Name += " (" + std::to_string(Entry.getValue().Matches) + "/" +
+                std::to_string(Entry.getValue().Invocations) + " matched)";
+      MatcherTimes[Name] = Entry.getValue().Time;
+    }
+    MatcherTG.emplace("clang-tidy-matchers", "clang-tidy matchers profiling",
+                      MatcherTimes);
+  }
 
   if (!Storage)
     printUserFriendlyTable(llvm::errs());
@@ -20,6 +20,10 @@ class raw_ostream;
 } // namespace llvm
 
 namespace clang {
+namespace ast_matchers {
+struct MatcherProfileRecord;
+} // namespace ast_matchers
+
 namespace tidy {
 
 class ClangTidyProfiling {
@@ -36,6 +40,7 @@ public:
 
 private:
   llvm::Optional<llvm::TimerGroup> TG;
+  llvm::Optional<llvm::TimerGroup> MatcherTG;
 
   llvm::Optional<StorageParams> Storage;
 
@@ -47,7 +52,10 @@ private:
 public:
   llvm::StringMap<llvm::TimeRecord> Records;
 
-  ClangTidyProfiling() = default;
+  /// Per-matcher records, only filled if matcher profiling is enabled.
+  llvm::StringMap<ast_matchers::MatcherProfileRecord> MatcherRecords;
+
+  ClangTidyProfiling();
 
   ClangTidyProfiling(llvm::Optional<StorageParams> Storage);
 
@@ -17,6 +17,7 @@
 #include "ClangTidyMain.h"
 #include "../ClangTidy.h"
 #include "../ClangTidyForceLinker.h"
+#include "../ClangTidyParallel.h"
 #include "../GlobList.h"
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "llvm/ADT/StringSet.h"
@@ -207,6 +208,15 @@ report to stderr.
                                         cl::init(false),
                                         cl::cat(ClangTidyCategory));
 
+static cl::opt<bool> EnableMatcherProfile("enable-matcher-profile",
+                                          cl::desc(R"(
+Additionally attribute time and match counts to
+each AST matcher registered by a check. Implies
+-enable-check-profile.
+)"),
+                                          cl::init(false),
+                                          cl::cat(ClangTidyCategory));
+
 static cl::opt<std::string> StoreCheckProfile("store-check-profile",
                                               cl::desc(R"(
 By default reports are printed in tabulated
@@ -241,6 +251,26 @@ options are specified.
                            cl::init(false),
                            cl::cat(ClangTidyCategory));
 
+static cl::opt<unsigned> Jobs("j", cl::desc(R"(
+Number of translation units to analyze in
+parallel, in a single process. 0 uses all
+hardware threads. Files read by several
+translation units are loaded only once, and a
+warning in a header included by several of them
+is reported once.
+)"),
+                              cl::init(1), cl::cat(ClangTidyCategory));
+
+static cl::opt<std::string> CacheDir("cache-dir", cl::desc(R"(
+Directory in which to store the results of each
+translation unit. Results are reused by later
+runs as long as the translation unit, the files
+it reads or looks up, its compile command and
+its clang-tidy configuration are unchanged.
+)"),
+                                     cl::value_desc("directory"),
+                                     cl::cat(ClangTidyCategory));
+
 static cl::opt<std::string> VfsOverlay("vfsoverlay", cl::desc(R"(
 Overlay the virtual filesystem described by file
 over the real file system.
@@ -596,11 +626,43 @@ int clangTidyMain(int argc, const char **argv) {
   llvm::InitializeAllTargetMCs();
   llvm::InitializeAllAsmParsers();
 
+  const bool EnableProfile = EnableCheckProfile || EnableMatcherProfile;
   ClangTidyContext Context(std::move(OwningOptionsProvider),
                            AllowEnablingAnalyzerAlphaCheckers);
-  std::vector<ClangTidyError> Errors =
-      runClangTidy(Context, OptionsParser->getCompilations(), PathList, BaseFS,
-                   FixNotes, EnableCheckProfile, ProfilePrefix);
+  Context.setEnableMatcherProfiling(EnableMatcherProfile);
+  std::vector<ClangTidyError> Errors;
+  ClangTidyStats Stats;
+  if (Jobs != 1 || !CacheDir.empty()) {
+    ParallelRunOptions RunOpts;
+    RunOpts.Jobs = Jobs;
+    RunOpts.CacheDirectory = std::string(MakeAbsolute(CacheDir));
+    RunOpts.ApplyAnyFix = FixNotes;
+    RunOpts.EnableCheckProfile = EnableProfile;
+    RunOpts.StoreCheckProfile = std::string(ProfilePrefix);
+    ParallelRunResult Result = runClangTidyParallel(
+        [&] {
+          auto WorkerContext = std::make_unique<ClangTidyContext>(
+              createOptionsProvider(BaseFS),
+              AllowEnablingAnalyzerAlphaCheckers);
+          WorkerContext->setEnableMatcherProfiling(EnableMatcherProfile);
+          return WorkerContext;
+        },
+        OptionsParser->getCompilations(), PathList, BaseFS, RunOpts);
+    Errors = std::move(Result.Errors);
+    Stats = Result.Stats;
+    // The errors were collected by the worker contexts. Leave this context on
+    // the last file, as a serial run does, so that handleErrors() reads the
+    // options of an input file rather than those of an empty path.
+    Context.setCurrentFile(MakeAbsolute(PathList.back()));
+    if (!Quiet && !CacheDir.empty())
+      llvm::errs() << "Reused cached results for "
+                   << Result.CachedTranslationUnits << " of " << PathList.size()
+                   << " translation units.\n";
+  } else {
+    Errors = runClangTidy(Context, OptionsParser->getCompilations(), PathList,
+                          BaseFS, FixNotes, EnableProfile, ProfilePrefix);
+    Stats = Context.getStats();
+  }
   bool FoundErrors = llvm::any_of(Errors, [](const ClangTidyError &E) {
     return E.DiagLevel == ClangTidyError::Error;
   });
@@ -628,7 +690,7 @@ int clangTidyMain(int argc, const char **argv) {
   }
 
   if (!Quiet) {
-    printStats(Context.getStats());
+    printStats(Stats);
     if (DisableFixes && Behaviour != FB_NoFix)
       llvm::errs()
           << "Found compiler errors, but -fix-errors was not specified.\n"
@@ -107,6 +107,10 @@ public:
     /// This throttler controls which preambles may be built at a given time.
     clangd::PreambleThrottler *PreambleThrottler = nullptr;
 
+    /// Share one preamble between open files in the same directory that start
+    /// with the same includes and are compiled with the same flags.
+    bool SharePreambles = false;
+
     /// If true, ClangdServer builds a dynamic in-memory index for symbols in
     /// opened files and uses the index to augment code completion results.
     bool BuildDynamicSymbolIndex = false;
@@ -114,6 +118,9 @@ public:
     /// on background threads. The index is stored in the project root.
     bool BackgroundIndex = false;
     llvm::ThreadPriority BackgroundIndexPriority = llvm::ThreadPriority::Low;
+    /// If set, background index shards are also stored in this directory,
+    /// keyed by file contents, and reused by other checkouts and projects.
+    std::string BackgroundIndexSharedCache;
 
     /// If set, use this index to augment code completion results.
     SymbolIndex *StaticIndex = nullptr;
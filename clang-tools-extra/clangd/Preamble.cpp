@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "Preamble.h"
+#include "CompileCommands.h"
 #include "Compiler.h"
 #include "Config.h"
 #include "Headers.h"
@@ -31,6 +32,7 @@
 #include "clang/Tooling/CompilationDatabase.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
@@ -54,11 +56,31 @@ namespace clangd {
 namespace {
 constexpr llvm::StringLiteral PreamblePatchHeaderName = "__preamble_patch__.h";
 
+// Returns the arguments of \p Cmd that can affect its preamble, i.e. all of
+// them except for the main file and the outputs.
+std::vector<std::string>
+preambleCommandLine(const tooling::CompileCommand &Cmd) {
+  static const ArgStripper *OutputStripper = [] {
+    auto *Stripper = new ArgStripper;
+    for (llvm::StringRef Arg : {"-o", "-MF", "-MT", "-MQ", "-MJ"})
+      Stripper->strip(Arg);
+    return Stripper;
+  }();
+  std::vector<std::string> Args = Cmd.CommandLine;
+  OutputStripper->process(Args);
+  llvm::erase_value(Args, Cmd.Filename);
+  return Args;
+}
+
 bool compileCommandsAreEqual(const tooling::CompileCommand &LHS,
                              const tooling::CompileCommand &RHS) {
   // We don't check for Output, it should not matter to clangd.
-  return LHS.Directory == RHS.Directory && LHS.Filename == RHS.Filename &&
-         llvm::makeArrayRef(LHS.CommandLine).equals(RHS.CommandLine);
+  if (LHS.Directory != RHS.Directory)
+    return false;
+  if (LHS.Filename == RHS.Filename)
+    return llvm::makeArrayRef(LHS.CommandLine).equals(RHS.CommandLine);
+  // A preamble shared with another file, see sharedPreambleKey().
+  return preambleCommandLine(LHS) == preambleCommandLine(RHS);
 }
 
 class CppFilePreambleCallbacks : public PreambleCallbacks {
@@ -588,7 +610,28 @@ bool isPreambleCompatible(const PreambleData &Preamble,
   auto VFS = Inputs.TFS->view(Inputs.CompileCommand.Directory);
   return compileCommandsAreEqual(Inputs.CompileCommand,
                                  Preamble.CompileCommand) &&
-         Preamble.Preamble.CanReuse(CI, *ContentsBuffer, Bounds, *VFS);
+         Preamble.Preamble->CanReuse(CI, *ContentsBuffer, Bounds, *VFS);
+}
+
+std::string sharedPreambleKey(PathRef FileName, const ParseInputs &Inputs,
+                              const CompilerInvocation &CI) {
+  auto Bounds = ComputePreambleBounds(
+      *CI.getLangOpts(), llvm::MemoryBufferRef(Inputs.Contents, FileName), 0);
+  auto Args = preambleCommandLine(Inputs.CompileCommand);
+  llvm::hash_code Hash = llvm::hash_combine(
+      llvm::StringRef(Inputs.Contents).take_front(Bounds.Size),
+      Bounds.PreambleEndsAtStartOfLine, Inputs.CompileCommand.Directory,
+      llvm::hash_combine_range(Args.begin(), Args.end()));
+  // Quoted includes are resolved relative to the main file, so only files in
+  // the same directory may share a preamble.
+  return llvm::formatv("{0}:{1:x16}", llvm::sys::path::parent_path(FileName),
+                       static_cast<uint64_t>(static_cast<size_t>(Hash)));
+}
+
+bool isPreambleShareable(const PreambleData &Preamble) {
+  // Include guards are detected on the whole file, not the preamble region.
+  return Preamble.Diags.empty() && Preamble.Macros.Names.empty() &&
+         Preamble.Marks.empty() && !Preamble.MainIsIncludeGuarded;
 }
 
 void escapeBackslashAndQuotes(llvm::StringRef Text, llvm::raw_ostream &OS) {
@@ -622,7 +665,7 @@ PreamblePatch PreamblePatch::create(llvm::StringRef FileName,
   //   there's nothing to do but generate an empty patch.
   auto BaselineScan = scanPreamble(
       // Contents needs to be null-terminated.
-      Baseline.Preamble.getContents().str(), Modified.CompileCommand);
+      Baseline.Preamble->getContents().str(), Modified.CompileCommand);
   if (!BaselineScan) {
     elog("Failed to scan baseline of {0}: {1}", FileName,
          BaselineScan.takeError());
@@ -746,7 +789,7 @@ std::vector<Inclusion> PreamblePatch::preambleIncludes() const {
 PreamblePatch PreamblePatch::unmodified(const PreambleData &Preamble) {
   PreamblePatch PP;
   PP.PreambleIncludes = Preamble.Includes.MainFileIncludes;
-  PP.ModifiedBounds = Preamble.Preamble.getBounds();
+  PP.ModifiedBounds = Preamble.Preamble->getBounds();
   return PP;
 }
 
@@ -46,13 +46,18 @@ namespace clangd {
 ///
 /// As we must avoid re-parsing the preamble, any information that can only
 /// be obtained during parsing must be eagerly captured and stored here.
+///
+/// A file reusing the preamble of another file (see sharedPreambleKey()) gets
+/// a copy with its own Version and CompileCommand. The copies share the
+/// PrecompiledPreamble and the StatCache.
 struct PreambleData {
-  PreambleData(PrecompiledPreamble Preamble) : Preamble(std::move(Preamble)) {}
+  PreambleData(PrecompiledPreamble Preamble)
+      : Preamble(std::make_shared<PrecompiledPreamble>(std::move(Preamble))) {}
 
   // Version of the ParseInputs this preamble was built from.
   std::string Version;
   tooling::CompileCommand CompileCommand;
-  PrecompiledPreamble Preamble;
+  std::shared_ptr<const PrecompiledPreamble> Preamble;
   std::vector<Diag> Diags;
   // Processes like code completions and go-to-definitions will need #include
   // information, and their compile action skips preamble range.
@@ -65,7 +70,7 @@ struct PreambleData {
   std::vector<PragmaMark> Marks;
   // Cache of FS operations performed when building the preamble.
   // When reusing a preamble, this cache can be consumed to save IO.
-  std::unique_ptr<PreambleFileStatusCache> StatCache;
+  std::shared_ptr<const PreambleFileStatusCache> StatCache;
   CanonicalIncludes CanonIncludes;
   // Whether there was a (possibly-incomplete) include-guard on the main file.
   // We need to propagate this information "by hand" to subsequent parses.
@@ -111,6 +116,20 @@ bool isPreambleCompatible(const PreambleData &Preamble,
                           const ParseInputs &Inputs, PathRef FileName,
                           const CompilerInvocation &CI);
 
+/// Returns a key under which preambles for \p Inputs can be shared between
+/// files. Files get the same key when they live in the same directory, their
+/// preamble regions are identical and their compile commands only differ in
+/// the name of the main file and of the outputs. A preamble found under the
+/// key must still be checked with isPreambleCompatible().
+std::string sharedPreambleKey(PathRef FileName, const ParseInputs &Inputs,
+                              const CompilerInvocation &CI);
+
+/// Returns true if \p Preamble holds nothing specific to the file it was built
+/// for, so that other files with the same sharedPreambleKey() may use it.
+/// Preambles with diagnostics, macros or pragma marks in the main file are not
+/// shareable, as those point into the main file of the original build.
+bool isPreambleShareable(const PreambleData &Preamble);
+
 /// Stores information required to parse a TU using a (possibly stale) Baseline
 /// preamble. Later on this information can be injected into the main file by
 /// updating compiler invocation with \c apply. This injected section
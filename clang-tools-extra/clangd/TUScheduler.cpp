@@ -341,6 +341,36 @@ public:
   }
 };
 
+/// Preambles built for open files, keyed by sharedPreambleKey().
+/// A file whose key matches can reuse the preamble of another file instead of
+/// building an identical one. Entries are weak: a preamble lives as long as
+/// some ASTWorker still uses it, the cache never keeps one alive on its own.
+class TUScheduler::SharedPreambleCache {
+  mutable std::mutex Mu;
+  llvm::StringMap<std::weak_ptr<const PreambleData>> Preambles; // GUARDED_BY(Mu)
+
+public:
+  /// Returns the live preamble stored under \p Key, or null if there is none.
+  std::shared_ptr<const PreambleData> get(llvm::StringRef Key) const {
+    std::lock_guard<std::mutex> Lock(Mu);
+    auto It = Preambles.find(Key);
+    if (It == Preambles.end())
+      return nullptr;
+    return It->second.lock();
+  }
+
+  void put(llvm::StringRef Key, std::shared_ptr<const PreambleData> Preamble) {
+    std::lock_guard<std::mutex> Lock(Mu);
+    // Forget the preambles no file uses anymore.
+    for (auto It = Preambles.begin(), End = Preambles.end(); It != End;) {
+      auto Current = It++;
+      if (Current->second.expired())
+        Preambles.erase(Current);
+    }
+    Preambles[Key] = std::move(Preamble);
+  }
+};
+
 namespace {
 
 bool isReliable(const tooling::CompileCommand &Cmd) {
@@ -426,11 +456,12 @@ public:
                  bool StorePreambleInMemory, bool RunSync,
                  PreambleThrottler *Throttler, SynchronizedTUStatus &Status,
                  TUScheduler::HeaderIncluderCache &HeaderIncluders,
+                 TUScheduler::SharedPreambleCache *SharedPreambles,
                  ASTWorker &AW)
       : FileName(FileName), Callbacks(Callbacks),
         StoreInMemory(StorePreambleInMemory), RunSync(RunSync),
         Throttler(Throttler), Status(Status), ASTPeer(AW),
-        HeaderIncluders(HeaderIncluders) {}
+        HeaderIncluders(HeaderIncluders), SharedPreambles(SharedPreambles) {}
 
   /// It isn't guaranteed that each requested version will be built. If there
   /// are multiple update requests while building a preamble, only the last one
@@ -440,7 +471,11 @@ public:
     Request Req = {std::move(CI), std::move(PI), std::move(CIDiags), WantDiags,
                    Context::current().clone()};
     if (RunSync) {
-      build(std::move(Req));
+      auto Shared = sharedPreambleFor(Req);
+      if (Shared &&
+          !isPreambleCompatible(*Shared, Req.Inputs, FileName, *Req.CI))
+        Shared.reset();
+      build(std::move(Req), std::move(Shared));
       Status.update([](TUStatus &Status) {
         Status.PreambleActivity = PreambleAction::Idle;
       });
@@ -465,6 +500,10 @@ public:
   void run() {
     while (true) {
       llvm::Optional<PreambleThrottlerRequest> Throttle;
+      // A preamble of another file the request may reuse instead of building
+      // one. Reusing builds nothing, so the throttler is only acquired when
+      // there is no such preamble.
+      std::shared_ptr<const PreambleData> Shared;
       {
         std::unique_lock<std::mutex> Lock(Mutex);
         assert(!CurrentReq && "Already processing a request?");
@@ -473,18 +512,9 @@ public:
         if (Done)
           break;
 
-        {
-          Throttle.emplace(FileName, Throttler, ReqCV);
-          llvm::Optional<trace::Span> Tracer;
-          // If acquire succeeded synchronously, avoid status jitter.
-          if (!Throttle->satisfied()) {
-            Tracer.emplace("PreambleThrottle");
-            Status.update([&](TUStatus &Status) {
-              Status.PreambleActivity = PreambleAction::Queued;
-            });
-          }
-          ReqCV.wait(Lock, [&] { return Throttle->satisfied() || Done; });
-        }
+        Shared = sharedPreambleFor(*NextReq);
+        if (!Shared)
+          waitForThrottler(Throttle, Lock);
         if (Done)
           break;
         // While waiting for the throttler, the request may have been updated!
@@ -500,8 +530,20 @@ public:
         // Preamble tasks are always scheduled by ASTWorker tasks, and we
         // reuse the context/config that was created at that level.
 
+        // The shared preamble was only looked up by key. If it can't be
+        // reused after all, we build one and need the throttler for that.
+        bool Stopped = false;
+        if (Shared && !isPreambleCompatible(*Shared, CurrentReq->Inputs,
+                                            FileName, *CurrentReq->CI)) {
+          Shared.reset();
+          std::unique_lock<std::mutex> Lock(Mutex);
+          waitForThrottler(Throttle, Lock);
+          Stopped = Done;
+        }
+
         // Build the preamble and let the waiters know about it.
-        build(std::move(*CurrentReq));
+        if (!Stopped)
+          build(std::move(*CurrentReq), std::move(Shared));
       }
       // Releasing the throttle before destroying the request assists testing.
       Throttle.reset();
@@ -557,9 +599,38 @@ private:
     return Done;
   }
 
-  /// Builds a preamble for \p Req, might reuse LatestBuild if possible.
-  /// Notifies ASTWorker after build finishes.
-  void build(Request Req);
+  /// Builds a preamble for \p Req, might reuse LatestBuild or \p Shared if
+  /// possible. \p Shared is a preamble of another file that was checked to be
+  /// compatible with \p Req, or null. Notifies ASTWorker after build finishes.
+  void build(Request Req, std::shared_ptr<const PreambleData> Shared);
+
+  /// Returns a preamble built for another file that might be reused for \p
+  /// Req, or null. It still needs to be checked with isPreambleCompatible().
+  std::shared_ptr<const PreambleData>
+  sharedPreambleFor(const Request &Req) const {
+    if (!SharedPreambles || Req.Inputs.ForceRebuild)
+      return nullptr;
+    auto Shared =
+        SharedPreambles->get(sharedPreambleKey(FileName, Req.Inputs, *Req.CI));
+    // build() checks LatestBuild anyway.
+    return Shared == LatestBuild ? nullptr : Shared;
+  }
+
+  /// Waits until \p Throttle is satisfied or stop() is called, the caller
+  /// must check Done afterwards.
+  void waitForThrottler(llvm::Optional<PreambleThrottlerRequest> &Throttle,
+                        std::unique_lock<std::mutex> &Lock) {
+    Throttle.emplace(FileName, Throttler, ReqCV);
+    llvm::Optional<trace::Span> Tracer;
+    // If acquire succeeded synchronously, avoid status jitter.
+    if (!Throttle->satisfied()) {
+      Tracer.emplace("PreambleThrottle");
+      Status.update([&](TUStatus &Status) {
+        Status.PreambleActivity = PreambleAction::Queued;
+      });
+    }
+    ReqCV.wait(Lock, [&] { return Throttle->satisfied() || Done; });
+  }
 
   mutable std::mutex Mutex;
   bool Done = false;                  /* GUARDED_BY(Mutex) */
@@ -580,6 +651,7 @@ private:
   SynchronizedTUStatus &Status;
   ASTWorker &ASTPeer;
   TUScheduler::HeaderIncluderCache &HeaderIncluders;
+  TUScheduler::SharedPreambleCache *SharedPreambles;
 };
 
 class ASTWorkerHandle;
@@ -599,6 +671,7 @@ class ASTWorker {
   ASTWorker(PathRef FileName, const GlobalCompilationDatabase &CDB,
             TUScheduler::ASTCache &LRUCache,
             TUScheduler::HeaderIncluderCache &HeaderIncluders,
+            TUScheduler::SharedPreambleCache *SharedPreambles,
             Semaphore &Barrier, bool RunSync, const TUScheduler::Options &Opts,
             ParsingCallbacks &Callbacks);
 
@@ -608,10 +681,12 @@ public:
   /// is null, all requests will be processed on the calling thread
   /// synchronously instead. \p Barrier is acquired when processing each
   /// request, it is used to limit the number of actively running threads.
+  /// \p SharedPreambles is null unless preambles are shared between files.
   static ASTWorkerHandle
   create(PathRef FileName, const GlobalCompilationDatabase &CDB,
          TUScheduler::ASTCache &IdleASTs,
          TUScheduler::HeaderIncluderCache &HeaderIncluders,
+         TUScheduler::SharedPreambleCache *SharedPreambles,
          AsyncTaskRunner *Tasks, Semaphore &Barrier,
          const TUScheduler::Options &Opts, ParsingCallbacks &Callbacks);
   ~ASTWorker();
@@ -809,12 +884,13 @@ ASTWorkerHandle
 ASTWorker::create(PathRef FileName, const GlobalCompilationDatabase &CDB,
                   TUScheduler::ASTCache &IdleASTs,
                   TUScheduler::HeaderIncluderCache &HeaderIncluders,
+                  TUScheduler::SharedPreambleCache *SharedPreambles,
                   AsyncTaskRunner *Tasks, Semaphore &Barrier,
                   const TUScheduler::Options &Opts,
                   ParsingCallbacks &Callbacks) {
-  std::shared_ptr<ASTWorker> Worker(
-      new ASTWorker(FileName, CDB, IdleASTs, HeaderIncluders, Barrier,
-                    /*RunSync=*/!Tasks, Opts, Callbacks));
+  std::shared_ptr<ASTWorker> Worker(new ASTWorker(
+      FileName, CDB, IdleASTs, HeaderIncluders, SharedPreambles, Barrier,
+      /*RunSync=*/!Tasks, Opts, Callbacks));
   if (Tasks) {
     Tasks->runAsync("ASTWorker:" + llvm::sys::path::filename(FileName),
                     [Worker]() { Worker->run(); });
@@ -828,6 +904,7 @@ ASTWorker::create(PathRef FileName, const GlobalCompilationDatabase &CDB,
 ASTWorker::ASTWorker(PathRef FileName, const GlobalCompilationDatabase &CDB,
                      TUScheduler::ASTCache &LRUCache,
                      TUScheduler::HeaderIncluderCache &HeaderIncluders,
+                     TUScheduler::SharedPreambleCache *SharedPreambles,
                      Semaphore &Barrier, bool RunSync,
                      const TUScheduler::Options &Opts,
                      ParsingCallbacks &Callbacks)
@@ -836,7 +913,8 @@ ASTWorker::ASTWorker(PathRef FileName, const GlobalCompilationDatabase &CDB,
       ContextProvider(Opts.ContextProvider), CDB(CDB), Callbacks(Callbacks),
       Barrier(Barrier), Done(false), Status(FileName, Callbacks),
       PreamblePeer(FileName, Callbacks, Opts.StorePreamblesInMemory, RunSync,
-                   Opts.PreambleThrottler, Status, HeaderIncluders, *this) {
+                   Opts.PreambleThrottler, Status, HeaderIncluders,
+                   SharedPreambles, *this) {
   // Set a fallback command because compile command can be accessed before
   // `Inputs` is initialized. Other fields are only used after initialization
   // from client inputs.
@@ -1032,7 +1110,8 @@ static void crashDumpParseInputs(llvm::raw_ostream &OS,
   crashDumpFileContents(OS, FileInputs.Contents);
 }
 
-void PreambleThread::build(Request Req) {
+void PreambleThread::build(Request Req,
+                           std::shared_ptr<const PreambleData> Shared) {
   assert(Req.CI && "Got preamble request with null compiler invocation");
   const ParseInputs &Inputs = Req.Inputs;
   bool ReusedPreamble = false;
@@ -1062,24 +1141,41 @@ void PreambleThread::build(Request Req) {
          FileName, Inputs.Version, LatestBuild->Version);
   }
 
-  ThreadCrashReporter ScopedReporter([&Inputs]() {
-    llvm::errs() << "Signalled while building preamble\n";
-    crashDumpParseInputs(llvm::errs(), Inputs);
-  });
+  if (Shared) {
+    vlog("Sharing preamble of {0} with version {1} of {2}",
+         Shared->CompileCommand.Filename, Inputs.Version, FileName);
+    // The copy shares the PrecompiledPreamble but describes this file. There
+    // is no preamble AST to call onPreambleAST() with. Its symbols all come
+    // from headers, which were indexed when the preamble was built.
+    auto Copy = std::make_shared<PreambleData>(*Shared);
+    Copy->Version = Inputs.Version;
+    Copy->CompileCommand = Inputs.CompileCommand;
+    LatestBuild = std::move(Copy);
+  } else {
+    ThreadCrashReporter ScopedReporter([&Inputs]() {
+      llvm::errs() << "Signalled while building preamble\n";
+      crashDumpParseInputs(llvm::errs(), Inputs);
+    });
 
-  PreambleBuildStats Stats;
-  bool IsFirstPreamble = !LatestBuild;
-  LatestBuild = clang::clangd::buildPreamble(
-      FileName, *Req.CI, Inputs, StoreInMemory,
-      [&](ASTContext &Ctx, Preprocessor &PP,
-          const CanonicalIncludes &CanonIncludes) {
-        Callbacks.onPreambleAST(FileName, Inputs.Version, *Req.CI, Ctx, PP,
-                                CanonIncludes);
-      },
-      &Stats);
-  if (!LatestBuild)
-    return;
-  reportPreambleBuild(Stats, IsFirstPreamble);
+    PreambleBuildStats Stats;
+    bool IsFirstPreamble = !LatestBuild;
+    LatestBuild = clang::clangd::buildPreamble(
+        FileName, *Req.CI, Inputs, StoreInMemory,
+        [&](ASTContext &Ctx, Preprocessor &PP,
+            const CanonicalIncludes &CanonIncludes) {
+          Callbacks.onPreambleAST(FileName, Inputs.Version, *Req.CI, Ctx, PP,
+                                  CanonIncludes);
+        },
+        &Stats);
+    if (!LatestBuild)
+      return;
+    reportPreambleBuild(Stats, IsFirstPreamble);
+  }
+  // Also offer copies, so the preamble stays findable when the file that
+  // built it is closed.
+  if (SharedPreambles && isPreambleShareable(*LatestBuild))
+    SharedPreambles->put(sharedPreambleKey(FileName, Inputs, *Req.CI),
+                         LatestBuild);
   if (isReliable(LatestBuild->CompileCommand))
     HeaderIncluders.update(FileName, LatestBuild->Includes.allHeaders());
 }
@@ -1271,7 +1367,7 @@ TUScheduler::FileStats ASTWorker::stats() const {
   // only, so this should be fine.
   Result.UsedBytesAST = IdleASTs.getUsedBytes(this);
   if (auto Preamble = getPossiblyStalePreamble())
-    Result.UsedBytesPreamble = Preamble->Preamble.getSize();
+    Result.UsedBytesPreamble = Preamble->Preamble->getSize();
   return Result;
 }
 
@@ -1613,6 +1709,8 @@ TUScheduler::TUScheduler(const GlobalCompilationDatabase &CDB,
       IdleASTs(
           std::make_unique<ASTCache>(Opts.RetentionPolicy.MaxRetainedASTs)),
       HeaderIncluders(std::make_unique<HeaderIncluderCache>()) {
+  if (Opts.SharePreambles)
+    SharedPreambles = std::make_unique<SharedPreambleCache>();
   // Avoid null checks everywhere.
   if (!Opts.ContextProvider) {
     this->Opts.ContextProvider = [](llvm::StringRef) {
@@ -1654,7 +1752,7 @@ bool TUScheduler::update(PathRef File, ParseInputs Inputs,
   if (!FD) {
     // Create a new worker to process the AST-related tasks.
     ASTWorkerHandle Worker = ASTWorker::create(
-        File, CDB, *IdleASTs, *HeaderIncluders,
+        File, CDB, *IdleASTs, *HeaderIncluders, SharedPreambles.get(),
         WorkerThreads ? &*WorkerThreads : nullptr, Barrier, Opts, *Callbacks);
     FD = std::unique_ptr<FileData>(
         new FileData{Inputs.Contents, std::move(Worker)});
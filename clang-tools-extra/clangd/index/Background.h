@@ -51,6 +51,15 @@ public:
   virtual std::unique_ptr<IndexFileIn>
   loadShard(llvm::StringRef ShardIdentifier) const = 0;
 
+  // Like loadShard(), for a main file that is going to be indexed with Cmd.
+  // Storages that key shards by content can use the command to find a shard
+  // built with the same flags. By default, the command is ignored.
+  virtual std::unique_ptr<IndexFileIn>
+  loadShardForCommand(llvm::StringRef ShardIdentifier,
+                      const tooling::CompileCommand &Cmd) const {
+    return loadShard(ShardIdentifier);
+  }
+
   // The factory provides storage for each File.
   // It keeps ownership of the storage instances, and should manage caching
   // itself. Factory must be threadsafe and never returns nullptr.
@@ -60,8 +69,15 @@ public:
   // CDBDirectory + ".cache/clangd/index/" as the folder to save shards.
   // CDBDirectory is the first directory containing a CDB in parent directories
   // of a file, or user cache directory if none was found, e.g. stdlib headers.
+  //
+  // If SharedDirectory is set, shards are also saved there keyed by the
+  // contents of the file (and the compile command, for main files) rather
+  // than by its path. Paths under the project root are stored relative to it,
+  // so other checkouts and worktrees of the project, other projects and other
+  // clangd instances can reuse the shards instead of indexing the same files.
   static Factory createDiskBackedStorageFactory(
-      std::function<llvm::Optional<ProjectInfo>(PathRef)> GetProjectInfo);
+      std::function<llvm::Optional<ProjectInfo>(PathRef)> GetProjectInfo,
+      llvm::StringRef SharedDirectory = "");
 };
 
 // A priority queue of tasks which can be run on (external) worker threads.
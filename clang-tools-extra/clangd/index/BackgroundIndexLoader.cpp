@@ -25,8 +25,9 @@ namespace {
 /// inverse dependency mapping.
 class BackgroundIndexLoader {
 public:
-  BackgroundIndexLoader(BackgroundIndexStorage::Factory &IndexStorageFactory)
-      : IndexStorageFactory(IndexStorageFactory) {}
+  BackgroundIndexLoader(BackgroundIndexStorage::Factory &IndexStorageFactory,
+                        const GlobalCompilationDatabase &CDB)
+      : IndexStorageFactory(IndexStorageFactory), CDB(CDB) {}
   /// Load the shards for \p MainFile and all of its dependencies.
   void load(PathRef MainFile);
 
@@ -44,6 +45,7 @@ private:
   llvm::StringMap<LoadedShard> LoadedShards;
 
   BackgroundIndexStorage::Factory &IndexStorageFactory;
+  const GlobalCompilationDatabase &CDB;
 };
 
 std::pair<const LoadedShard &, std::vector<Path>>
@@ -58,7 +60,12 @@ BackgroundIndexLoader::loadShard(PathRef StartSourceFile, PathRef DependentTU) {
   LS.AbsolutePath = StartSourceFile.str();
   LS.DependentTU = std::string(DependentTU);
   BackgroundIndexStorage *Storage = IndexStorageFactory(LS.AbsolutePath);
-  auto Shard = Storage->loadShard(StartSourceFile);
+  // Main files are indexed with their own command, let the storage know.
+  llvm::Optional<tooling::CompileCommand> Cmd;
+  if (StartSourceFile == DependentTU)
+    Cmd = CDB.getCompileCommand(StartSourceFile);
+  auto Shard = Cmd ? Storage->loadShardForCommand(StartSourceFile, *Cmd)
+                   : Storage->loadShard(StartSourceFile);
   if (!Shard || !Shard->Sources) {
     vlog("Failed to load shard: {0}", StartSourceFile);
     return {LS, Edges};
@@ -120,7 +127,7 @@ std::vector<LoadedShard>
 loadIndexShards(llvm::ArrayRef<Path> MainFiles,
                 BackgroundIndexStorage::Factory &IndexStorageFactory,
                 const GlobalCompilationDatabase &CDB) {
-  BackgroundIndexLoader Loader(IndexStorageFactory);
+  BackgroundIndexLoader Loader(IndexStorageFactory, CDB);
   for (llvm::StringRef MainFile : MainFiles) {
     assert(llvm::sys::path::is_absolute(MainFile));
     Loader.load(MainFile);
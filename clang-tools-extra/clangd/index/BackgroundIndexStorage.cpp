@@ -7,17 +7,22 @@
 //===----------------------------------------------------------------------===//
 
 #include "GlobalCompilationDatabase.h"
+#include "SourceCode.h"
+#include "URI.h"
 #include "index/Background.h"
 #include "support/Logger.h"
 #include "support/Path.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/LockFileManager.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/StringSaver.h"
 #include <functional>
 
 namespace clang {
@@ -33,45 +38,309 @@ std::string getShardPathFromFilePath(llvm::StringRef ShardRoot,
   return std::string(ShardRootSS.str());
 }
 
+std::unique_ptr<IndexFileIn> readShard(llvm::StringRef ShardPath,
+                                       llvm::StringRef ShardIdentifier) {
+  auto Buffer = llvm::MemoryBuffer::getFile(ShardPath);
+  if (!Buffer)
+    return nullptr;
+  if (auto I =
+          readIndexFile(Buffer->get()->getBuffer(), SymbolOrigin::Background))
+    return std::make_unique<IndexFileIn>(std::move(*I));
+  else
+    elog("Error while reading shard {0}: {1}", ShardIdentifier, I.takeError());
+  return nullptr;
+}
+
+llvm::Error writeShard(llvm::StringRef ShardPath, const IndexFileOut &Shard) {
+  return llvm::writeFileAtomically((ShardPath + ".tmp.%%%%%%%%").str(),
+                                   ShardPath,
+                                   [&Shard](llvm::raw_ostream &OS) {
+                                     OS << Shard;
+                                     return llvm::Error::success();
+                                   });
+}
+
+// Moves the paths and URIs in shards from one project root to another.
+// Shards in the shared storage are relative to a placeholder root, so that
+// they can be used by any checkout of a project.
+class Relocation {
+  std::string FromPath, ToPath;
+  std::string FromURI, ToURI;
+
+  // Replaces From with To at the start of S, if it is followed by a separator.
+  static void replacePrefix(llvm::StringRef &S, llvm::StringRef From,
+                            llvm::StringRef To, llvm::StringSaver &Saver) {
+    if (From.empty() || !S.startswith(From) ||
+        (S.size() > From.size() &&
+         !llvm::sys::path::is_separator(S[From.size()])))
+      return;
+    S = Saver.save(To + S.drop_front(From.size()));
+  }
+
+public:
+  Relocation(llvm::StringRef FromRoot, llvm::StringRef ToRoot)
+      : FromPath(FromRoot.rtrim("/\\")), ToPath(ToRoot.rtrim("/\\")),
+        FromURI(URI::createFile(FromPath).toString()),
+        ToURI(URI::createFile(ToPath).toString()) {}
+
+  Relocation reverse() const {
+    Relocation R = *this;
+    std::swap(R.FromPath, R.ToPath);
+    std::swap(R.FromURI, R.ToURI);
+    return R;
+  }
+
+  tooling::CompileCommand operator()(tooling::CompileCommand Cmd) const {
+    // Paths are also embedded in flags, e.g. -I/path/to/root/include.
+    auto Relocate = [&](std::string &S) {
+      std::string Result;
+      llvm::StringRef Rest = S;
+      for (size_t Pos; (Pos = Rest.find(FromPath)) != llvm::StringRef::npos;) {
+        size_t End = Pos + FromPath.size();
+        bool AtSeparator = End == Rest.size() ||
+                           llvm::sys::path::is_separator(Rest[End]);
+        Result += Rest.take_front(AtSeparator ? Pos : End);
+        if (AtSeparator)
+          Result += ToPath;
+        Rest = Rest.drop_front(End);
+      }
+      Result += Rest;
+      S = std::move(Result);
+    };
+    if (FromPath.empty())
+      return Cmd;
+    Relocate(Cmd.Directory);
+    Relocate(Cmd.Filename);
+    for (std::string &Arg : Cmd.CommandLine)
+      Relocate(Arg);
+    return Cmd;
+  }
+
+  IndexFileIn operator()(const IndexFileOut &Shard) const {
+    llvm::BumpPtrAllocator Arena;
+    llvm::StringSaver Saver(Arena);
+    auto RelocateURI = [&](llvm::StringRef &S) {
+      replacePrefix(S, FromURI, ToURI, Saver);
+    };
+
+    IndexFileIn Result;
+    if (Shard.Symbols) {
+      SymbolSlab::Builder Symbols;
+      for (Symbol Sym : *Shard.Symbols) {
+        visitStrings(Sym, RelocateURI);
+        Symbols.insert(Sym);
+      }
+      Result.Symbols = std::move(Symbols).build();
+    }
+    if (Shard.Refs) {
+      RefSlab::Builder Refs;
+      for (const auto &SymRefs : *Shard.Refs)
+        for (Ref R : SymRefs.second) {
+          llvm::StringRef File = R.Location.FileURI;
+          RelocateURI(File);
+          R.Location.FileURI = File.data();
+          Refs.insert(SymRefs.first, R);
+        }
+      Result.Refs = std::move(Refs).build();
+    }
+    if (Shard.Relations) {
+      RelationSlab::Builder Relations;
+      for (const auto &R : *Shard.Relations)
+        Relations.insert(R);
+      Result.Relations = std::move(Relations).build();
+    }
+    if (Shard.Sources) {
+      // As in readIndexFile(), strings point at the keys of the map.
+      Result.Sources.emplace();
+      auto Intern = [&](llvm::StringRef Key) {
+        RelocateURI(Key);
+        return Result.Sources->try_emplace(Key).first;
+      };
+      for (const auto &Source : *Shard.Sources) {
+        auto Entry = Intern(Source.getKey());
+        IncludeGraphNode &IGN = Entry->getValue();
+        IGN = Source.getValue();
+        IGN.URI = Entry->getKey();
+        for (auto &Include : IGN.DirectIncludes)
+          Include = Intern(Include)->getKey();
+      }
+    }
+    if (Shard.Cmd)
+      Result.Cmd = (*this)(*Shard.Cmd);
+    return Result;
+  }
+};
+
+// Shards shared by all projects and clangd instances, keyed by the contents of
+// the file they were built for (and the compile command, for main files).
+// Multiple processes may use the same directory: shards are written
+// atomically, and concurrent writers of the same shard are serialized through
+// a lock file.
+class ContentAddressedShardStore {
+  std::string Root;
+
+public:
+  ContentAddressedShardStore(llvm::StringRef Directory) : Root(Directory) {
+    if (auto EC = llvm::sys::fs::create_directories(Root))
+      elog("Failed to create directory {0} for shared index storage: {1}",
+           Root, EC.message());
+  }
+
+  // Placeholder for the project root in the stored shards.
+  static constexpr llvm::StringLiteral ProjectRoot = "/$clangd-project-root";
+
+  // The key of the shard for a file with Digest. Cmd is set for main files,
+  // and must be relative to ProjectRoot.
+  static std::string key(const FileDigest &Digest,
+                         const tooling::CompileCommand *Cmd) {
+    std::string Key = llvm::toHex(Digest);
+    if (Cmd) {
+      std::string Flags = Cmd->Directory;
+      for (const std::string &Arg : Cmd->CommandLine) {
+        Flags.push_back('\0');
+        Flags += Arg;
+      }
+      Key += "." + llvm::toHex(digest(Flags));
+    }
+    return Key;
+  }
+
+  std::unique_ptr<IndexFileIn> load(llvm::StringRef Key) const {
+    return readShard(path(Key), Key);
+  }
+
+  llvm::Error store(llvm::StringRef Key, const IndexFileOut &Shard) const {
+    std::string ShardPath = path(Key);
+    if (auto EC = llvm::sys::fs::create_directories(
+            llvm::sys::path::parent_path(ShardPath)))
+      return llvm::errorCodeToError(EC);
+    llvm::LockFileManager Lock(ShardPath);
+    switch (Lock) {
+    case llvm::LockFileManager::LFS_Error:
+      return error("failed to lock {0}: {1}", ShardPath,
+                   Lock.getErrorMessage());
+    case llvm::LockFileManager::LFS_Shared:
+      // Another process is writing a shard for the same contents.
+      return llvm::Error::success();
+    case llvm::LockFileManager::LFS_Owned:
+      return writeShard(ShardPath, Shard);
+    }
+    llvm_unreachable("unhandled LockFileState");
+  }
+
+private:
+  // Shards are spread over subdirectories to keep directories small.
+  std::string path(llvm::StringRef Key) const {
+    llvm::SmallString<128> Path(Root);
+    llvm::sys::path::append(Path, Key.take_front(2), Key + ".idx");
+    return std::string(Path.str());
+  }
+};
+
 // Uses disk as a storage for index shards.
 class DiskBackedIndexStorage : public BackgroundIndexStorage {
   std::string DiskShardRoot;
+  std::shared_ptr<const ContentAddressedShardStore> Shared;
+  // Moves paths from the project root to the placeholder used in Shared.
+  llvm::Optional<Relocation> ToShared;
 
 public:
   // Creates `DiskShardRoot` and any parents during construction.
-  DiskBackedIndexStorage(llvm::StringRef Directory) : DiskShardRoot(Directory) {
+  DiskBackedIndexStorage(
+      llvm::StringRef Directory,
+      std::shared_ptr<const ContentAddressedShardStore> Shared = nullptr,
+      llvm::StringRef SourceRoot = "")
+      : DiskShardRoot(Directory), Shared(std::move(Shared)) {
     std::error_code OK;
     std::error_code EC = llvm::sys::fs::create_directories(DiskShardRoot);
     if (EC != OK) {
       elog("Failed to create directory {0} for index storage: {1}",
            DiskShardRoot, EC.message());
     }
+    if (!SourceRoot.empty())
+      ToShared.emplace(SourceRoot, ContentAddressedShardStore::ProjectRoot);
   }
 
   std::unique_ptr<IndexFileIn>
   loadShard(llvm::StringRef ShardIdentifier) const override {
-    const std::string ShardPath =
-        getShardPathFromFilePath(DiskShardRoot, ShardIdentifier);
-    auto Buffer = llvm::MemoryBuffer::getFile(ShardPath);
-    if (!Buffer)
-      return nullptr;
-    if (auto I =
-            readIndexFile(Buffer->get()->getBuffer(), SymbolOrigin::Background))
-      return std::make_unique<IndexFileIn>(std::move(*I));
-    else
-      elog("Error while reading shard {0}: {1}", ShardIdentifier,
-           I.takeError());
-    return nullptr;
+    return loadShard(ShardIdentifier, nullptr);
+  }
+
+  std::unique_ptr<IndexFileIn>
+  loadShardForCommand(llvm::StringRef ShardIdentifier,
+                      const tooling::CompileCommand &Cmd) const override {
+    return loadShard(ShardIdentifier, &Cmd);
   }
 
   llvm::Error storeShard(llvm::StringRef ShardIdentifier,
                          IndexFileOut Shard) const override {
     auto ShardPath = getShardPathFromFilePath(DiskShardRoot, ShardIdentifier);
-    return llvm::writeFileAtomically(ShardPath + ".tmp.%%%%%%%%", ShardPath,
-                                     [&Shard](llvm::raw_ostream &OS) {
-                                       OS << Shard;
-                                       return llvm::Error::success();
-                                     });
+    if (auto Err = writeShard(ShardPath, Shard))
+      return Err;
+    if (Shared)
+      storeSharedShard(ShardIdentifier, Shard);
+    return llvm::Error::success();
+  }
+
+private:
+  std::unique_ptr<IndexFileIn>
+  loadShard(llvm::StringRef ShardIdentifier,
+            const tooling::CompileCommand *Cmd) const {
+    auto Shard = readShard(
+        getShardPathFromFilePath(DiskShardRoot, ShardIdentifier),
+        ShardIdentifier);
+    if (!Shared)
+      return Shard;
+    // The shard for the current contents may be in the shared storage, e.g.
+    // after switching branches or in a new worktree.
+    auto Content = llvm::MemoryBuffer::getFile(ShardIdentifier);
+    if (!Content)
+      return Shard;
+    FileDigest Digest = digest(Content->get()->getBuffer());
+    if (Shard && shardDigest(*Shard, ShardIdentifier) == Digest)
+      return Shard;
+    llvm::Optional<tooling::CompileCommand> SharedCmd;
+    if (Cmd)
+      SharedCmd = ToShared ? (*ToShared)(*Cmd) : *Cmd;
+    auto SharedShard = Shared->load(ContentAddressedShardStore::key(
+        Digest, SharedCmd ? &*SharedCmd : nullptr));
+    if (!SharedShard)
+      return Shard;
+    vlog("Loaded shared shard for {0}", ShardIdentifier);
+    if (!ToShared)
+      return SharedShard;
+    return std::make_unique<IndexFileIn>(
+        ToShared->reverse()(IndexFileOut(*SharedShard)));
+  }
+
+  void storeSharedShard(llvm::StringRef ShardIdentifier,
+                        const IndexFileOut &Shard) const {
+    auto Digest = shardDigest(Shard, ShardIdentifier);
+    if (!Digest)
+      return;
+    IndexFileIn Relocated;
+    IndexFileOut SharedShard = Shard;
+    if (ToShared) {
+      Relocated = (*ToShared)(Shard);
+      SharedShard = IndexFileOut(Relocated);
+      SharedShard.Format = Shard.Format;
+    }
+    std::string Key =
+        ContentAddressedShardStore::key(*Digest, SharedShard.Cmd);
+    if (auto Err = Shared->store(Key, SharedShard))
+      elog("Failed to write shared shard for {0}: {1}", ShardIdentifier,
+           std::move(Err));
+  }
+
+  // Returns the digest of the file the shard was built for.
+  static llvm::Optional<FileDigest>
+  shardDigest(const IndexFileOut &Shard, llvm::StringRef ShardIdentifier) {
+    if (!Shard.Sources)
+      return std::nullopt;
+    auto It = Shard.Sources->find(URI::createFile(ShardIdentifier).toString());
+    if (It == Shard.Sources->end())
+      return std::nullopt;
+    return It->getValue().Digest;
   }
 };
 
@@ -98,39 +367,47 @@ public:
 class DiskBackedIndexStorageManager {
 public:
   DiskBackedIndexStorageManager(
-      std::function<llvm::Optional<ProjectInfo>(PathRef)> GetProjectInfo)
+      std::function<llvm::Optional<ProjectInfo>(PathRef)> GetProjectInfo,
+      llvm::StringRef SharedDirectory)
       : IndexStorageMapMu(std::make_unique<std::mutex>()),
         GetProjectInfo(std::move(GetProjectInfo)) {
     llvm::SmallString<128> FallbackDir;
     if (llvm::sys::path::cache_directory(FallbackDir))
       llvm::sys::path::append(FallbackDir, "clangd", "index");
     this->FallbackDir = FallbackDir.str().str();
+    if (!SharedDirectory.empty())
+      Shared = std::make_shared<ContentAddressedShardStore>(SharedDirectory);
   }
 
   // Creates or fetches to storage from cache for the specified project.
   BackgroundIndexStorage *operator()(PathRef File) {
     std::lock_guard<std::mutex> Lock(*IndexStorageMapMu);
     llvm::SmallString<128> StorageDir(FallbackDir);
+    std::string SourceRoot;
     if (auto PI = GetProjectInfo(File)) {
       StorageDir = PI->SourceRoot;
+      SourceRoot = PI->SourceRoot;
       llvm::sys::path::append(StorageDir, ".cache", "clangd", "index");
     }
     auto &IndexStorage = IndexStorageMap[StorageDir];
     if (!IndexStorage)
-      IndexStorage = create(StorageDir);
+      IndexStorage = create(StorageDir, SourceRoot);
     return IndexStorage.get();
   }
 
 private:
-  std::unique_ptr<BackgroundIndexStorage> create(PathRef CDBDirectory) {
+  std::unique_ptr<BackgroundIndexStorage> create(PathRef CDBDirectory,
+                                                 PathRef SourceRoot) {
     if (CDBDirectory.empty()) {
       elog("Tried to create storage for empty directory!");
       return std::make_unique<NullStorage>();
     }
-    return std::make_unique<DiskBackedIndexStorage>(CDBDirectory);
+    return std::make_unique<DiskBackedIndexStorage>(CDBDirectory, Shared,
+                                                    SourceRoot);
   }
 
   Path FallbackDir;
+  std::shared_ptr<const ContentAddressedShardStore> Shared;
 
   llvm::StringMap<std::unique_ptr<BackgroundIndexStorage>> IndexStorageMap;
   std::unique_ptr<std::mutex> IndexStorageMapMu;
@@ -142,8 +419,10 @@ private:
 
 BackgroundIndexStorage::Factory
 BackgroundIndexStorage::createDiskBackedStorageFactory(
-    std::function<llvm::Optional<ProjectInfo>(PathRef)> GetProjectInfo) {
-  return DiskBackedIndexStorageManager(std::move(GetProjectInfo));
+    std::function<llvm::Optional<ProjectInfo>(PathRef)> GetProjectInfo,
+    llvm::StringRef SharedDirectory) {
+  return DiskBackedIndexStorageManager(std::move(GetProjectInfo),
+                                       SharedDirectory);
 }
 
 } // namespace clangd
@@ -24,15 +24,18 @@
 #include "support/Logger.h"
 #include "support/MemoryTree.h"
 #include "support/Path.h"
+#include "support/Trace.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/Index/IndexingAction.h"
 #include "clang/Index/IndexingOptions.h"
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include <algorithm>
 #include <memory>
 #include <tuple>
@@ -238,6 +241,189 @@ SlabTuple indexHeaderSymbols(llvm::StringRef Version, ASTContext &AST,
                       /*CollectMainFileRefs=*/false);
 }
 
+namespace {
+// Preamble updates add segments to the preamble index, which make queries
+// slower. Compact them once there are more than this.
+constexpr size_t MaxPreambleSegments = 8;
+
+// The segments of the preamble index, newest first. A segment is
+// authoritative for the files it indexes, everything older segments have from
+// those files is stale and dropped. Unlike MergedIndex, symbols are never
+// merged across segments: a doc comment or definition removed by a later
+// preamble must not come back from an older segment.
+class IndexSegments : public SymbolIndex {
+public:
+  explicit IndexSegments(std::vector<std::shared_ptr<SymbolIndex>> Segments)
+      : Segments(std::move(Segments)) {}
+
+  bool
+  fuzzyFind(const FuzzyFindRequest &Req,
+            llvm::function_ref<void(const Symbol &)> Callback) const override {
+    trace::Span Tracer("IndexSegments fuzzyFind");
+    bool More = false;
+    llvm::DenseSet<SymbolID> Reported;
+    forEachSegment([&](const SymbolIndex &Segment, const NewerFiles &Newer) {
+      // Each segment reports up to Req.Limit symbols that no newer segment
+      // shadows. The segment applies the limit before we drop the shadowed
+      // ones, so query it again with a larger limit if some were dropped.
+      FuzzyFindRequest SegmentReq = Req;
+      llvm::DenseSet<SymbolID> FromSegment;
+      while (true) {
+        bool Dropped = false, Trimmed = false;
+        bool SegmentMore = Segment.fuzzyFind(SegmentReq, [&](const Symbol &S) {
+          if (FromSegment.contains(S.ID))
+            return; // Reported by an earlier query of this segment.
+          if (Newer.shadows(S) || Reported.contains(S.ID)) {
+            Dropped = true;
+            return;
+          }
+          if (Req.Limit && FromSegment.size() == *Req.Limit) {
+            Trimmed = true;
+            return;
+          }
+          FromSegment.insert(S.ID);
+          Reported.insert(S.ID);
+          Callback(S);
+        });
+        if (Req.Limit && SegmentMore && Dropped &&
+            FromSegment.size() < *Req.Limit) {
+          SegmentReq.Limit = *SegmentReq.Limit * 2;
+          continue;
+        }
+        More |= SegmentMore || Trimmed;
+        break;
+      }
+    });
+    return More;
+  }
+
+  void lookup(const LookupRequest &Req,
+              llvm::function_ref<void(const Symbol &)> Callback) const override {
+    trace::Span Tracer("IndexSegments lookup");
+    LookupRequest Remaining = Req;
+    forEachSegment([&](const SymbolIndex &Segment, const NewerFiles &Newer) {
+      if (Remaining.IDs.empty())
+        return;
+      Segment.lookup(LookupRequest(Remaining), [&](const Symbol &S) {
+        if (!Newer.shadows(S) && Remaining.IDs.erase(S.ID))
+          Callback(S);
+      });
+    });
+  }
+
+  bool refs(const RefsRequest &Req,
+            llvm::function_ref<void(const Ref &)> Callback) const override {
+    trace::Span Tracer("IndexSegments refs");
+    bool More = false;
+    uint32_t Remaining =
+        Req.Limit.value_or(std::numeric_limits<uint32_t>::max());
+    forEachSegment([&](const SymbolIndex &Segment, const NewerFiles &Newer) {
+      More |= Segment.refs(Req, [&](const Ref &R) {
+        if (Newer.contains(R.Location.FileURI, IndexContents::References))
+          return;
+        if (Remaining == 0) {
+          More = true;
+          return;
+        }
+        --Remaining;
+        Callback(R);
+      });
+    });
+    return More;
+  }
+
+  void relations(const RelationsRequest &Req,
+                 llvm::function_ref<void(const SymbolID &, const Symbol &)>
+                     Callback) const override {
+    trace::Span Tracer("IndexSegments relations");
+    uint32_t Remaining =
+        Req.Limit.value_or(std::numeric_limits<uint32_t>::max());
+    llvm::DenseSet<std::pair<SymbolID, SymbolID>> Reported;
+    forEachSegment([&](const SymbolIndex &Segment, const NewerFiles &Newer) {
+      if (Remaining == 0)
+        return;
+      // Relations are stored with the file of their subject. Skip the
+      // subjects whose file a newer segment indexes.
+      RelationsRequest SegmentReq = Req;
+      if (!Newer.empty()) {
+        Segment.lookup(LookupRequest{Req.Subjects}, [&](const Symbol &S) {
+          if (Newer.shadows(S))
+            SegmentReq.Subjects.erase(S.ID);
+        });
+        if (SegmentReq.Subjects.empty())
+          return;
+      }
+      Segment.relations(
+          SegmentReq, [&](const SymbolID &Subject, const Symbol &Object) {
+            if (Remaining > 0 && Reported.insert({Subject, Object.ID}).second) {
+              --Remaining;
+              Callback(Subject, Object);
+            }
+          });
+    });
+  }
+
+  llvm::unique_function<IndexContents(llvm::StringRef) const>
+  indexedFiles() const override {
+    NewerFiles All;
+    for (const auto &Segment : Segments)
+      All.add(Segment->indexedFiles());
+    return [All(std::move(All))](llvm::StringRef FileURI) {
+      return All(FileURI);
+    };
+  }
+
+  size_t estimateMemoryUsage() const override {
+    size_t Bytes = 0;
+    for (const auto &Segment : Segments)
+      Bytes += Segment->estimateMemoryUsage();
+    return Bytes;
+  }
+
+private:
+  // The files indexed by the segments newer than the one being queried.
+  class NewerFiles {
+  public:
+    void add(IndexedFiles Files) { this->Files.push_back(std::move(Files)); }
+    bool empty() const { return Files.empty(); }
+
+    IndexContents operator()(llvm::StringRef FileURI) const {
+      IndexContents Contents = IndexContents::None;
+      for (const auto &IndexesFile : Files)
+        Contents = Contents | IndexesFile(FileURI);
+      return Contents;
+    }
+
+    bool contains(llvm::StringRef FileURI, IndexContents Kind) const {
+      return ((*this)(FileURI) & Kind) != IndexContents::None;
+    }
+
+    // Whether a newer segment indexes the declaration or definition of \p S,
+    // so that it has the up to date version of the symbol, if any.
+    bool shadows(const Symbol &S) const {
+      return contains(S.CanonicalDeclaration.FileURI, IndexContents::Symbols) ||
+             (S.Definition &&
+              contains(S.Definition.FileURI, IndexContents::Symbols));
+    }
+
+  private:
+    std::vector<IndexedFiles> Files;
+  };
+
+  // Calls \p F with each segment, newest first, and the files indexed by the
+  // segments before it.
+  template <typename Func> void forEachSegment(Func F) const {
+    NewerFiles Newer;
+    for (const auto &Segment : Segments) {
+      F(*Segment, Newer);
+      Newer.add(Segment->indexedFiles());
+    }
+  }
+
+  std::vector<std::shared_ptr<SymbolIndex>> Segments;
+};
+} // namespace
+
 FileSymbols::FileSymbols(IndexContents IdxContents)
     : IdxContents(IdxContents) {}
 
@@ -269,24 +455,47 @@ void FileSymbols::update(llvm::StringRef Key,
 std::unique_ptr<SymbolIndex>
 FileSymbols::buildIndex(IndexType Type, DuplicateHandling DuplicateHandle,
                         size_t *Version) {
+  return buildIndexForKeys(Type, DuplicateHandle, /*Keys=*/nullptr, Version);
+}
+
+std::unique_ptr<SymbolIndex>
+FileSymbols::buildIndex(IndexType Type, DuplicateHandling DuplicateHandle,
+                        const llvm::StringSet<> &Keys, size_t *Version) {
+  return buildIndexForKeys(Type, DuplicateHandle, &Keys, Version);
+}
+
+std::unique_ptr<SymbolIndex>
+FileSymbols::buildIndexForKeys(IndexType Type,
+                               DuplicateHandling DuplicateHandle,
+                               const llvm::StringSet<> *Keys,
+                               size_t *Version) {
   std::vector<std::shared_ptr<SymbolSlab>> SymbolSlabs;
   std::vector<std::shared_ptr<RefSlab>> RefSlabs;
   std::vector<std::shared_ptr<RelationSlab>> RelationSlabs;
   llvm::StringSet<> Files;
   std::vector<RefSlab *> MainFileRefs;
+  auto Selected = [&](llvm::StringRef Key) {
+    return !Keys || Keys->contains(Key);
+  };
   {
     std::lock_guard<std::mutex> Lock(Mutex);
     for (const auto &FileAndSymbols : SymbolsSnapshot) {
+      if (!Selected(FileAndSymbols.first()))
+        continue;
       SymbolSlabs.push_back(FileAndSymbols.second);
       Files.insert(FileAndSymbols.first());
     }
     for (const auto &FileAndRefs : RefsSnapshot) {
+      if (!Selected(FileAndRefs.first()))
+        continue;
       RefSlabs.push_back(FileAndRefs.second.Slab);
       Files.insert(FileAndRefs.first());
       if (FileAndRefs.second.CountReferences)
         MainFileRefs.push_back(RefSlabs.back().get());
     }
     for (const auto &FileAndRelations : RelationsSnapshot) {
+      if (!Selected(FileAndRelations.first()))
+        continue;
       Files.insert(FileAndRelations.first());
       RelationSlabs.push_back(FileAndRelations.second);
     }
@@ -427,7 +636,9 @@ FileIndex::FileIndex()
 
 void FileIndex::updatePreamble(IndexFileIn IF) {
   FileShardedIndex ShardedIndex(std::move(IF));
+  llvm::StringSet<> Keys;
   for (auto Uri : ShardedIndex.getAllSources()) {
+    Keys.insert(Uri);
     auto IF = ShardedIndex.getShard(Uri);
     // We are using the key received from ShardedIndex, so it should always
     // exist.
@@ -438,22 +649,61 @@ void FileIndex::updatePreamble(IndexFileIn IF) {
         std::make_unique<RelationSlab>(std::move(*IF->Relations)),
         /*CountReferences=*/false);
   }
+  if (Keys.empty())
+    return;
+  // Only index the shards of this update, older segments have the rest.
   size_t IndexVersion = 0;
-  auto NewIndex = PreambleSymbols.buildIndex(
-      IndexType::Heavy, DuplicateHandling::PickOne, &IndexVersion);
+  std::shared_ptr<SymbolIndex> NewSegment = PreambleSymbols.buildIndex(
+      IndexType::Heavy, DuplicateHandling::PickOne, Keys, &IndexVersion);
   {
     std::lock_guard<std::mutex> Lock(UpdateIndexMu);
-    if (IndexVersion <= PreambleIndexVersion) {
-      // We lost the race, some other thread built a later version.
+    if (IndexVersion <= PreambleCompactedVersion) {
+      // We lost the race, a compaction already covers this update.
       return;
     }
-    PreambleIndexVersion = IndexVersion;
-    PreambleIndex.reset(std::move(NewIndex));
-    vlog(
-        "Build dynamic index for header symbols with estimated memory usage of "
-        "{0} bytes",
-        PreambleIndex.estimateMemoryUsage());
+    // Updates may finish out of order, keep the newest segments first.
+    auto It = llvm::partition_point(
+        PreambleSegments,
+        [&](const PreambleSegment &S) { return S.Version > IndexVersion; });
+    PreambleSegments.insert(It, {IndexVersion, std::move(NewSegment)});
+    publishPreambleSegments();
+    if (PreambleSegments.size() > MaxPreambleSegments &&
+        !PreambleCompactionPending) {
+      PreambleCompactionPending = true;
+      Compactions.runAsync("Compact preamble index",
+                           [this] { compactPreambleIndex(); });
+    }
+  }
+}
+
+void FileIndex::compactPreambleIndex() {
+  size_t IndexVersion = 0;
+  std::shared_ptr<SymbolIndex> Compacted = PreambleSymbols.buildIndex(
+      IndexType::Heavy, DuplicateHandling::PickOne, &IndexVersion);
+  std::lock_guard<std::mutex> Lock(UpdateIndexMu);
+  PreambleCompactionPending = false;
+  // Segments for later updates stay on top of the compacted index.
+  llvm::erase_if(PreambleSegments, [&](const PreambleSegment &S) {
+    return S.Version <= IndexVersion;
+  });
+  PreambleSegments.push_back({IndexVersion, std::move(Compacted)});
+  PreambleCompactedVersion = IndexVersion;
+  publishPreambleSegments();
+}
+
+void FileIndex::publishPreambleSegments() {
+  assert(!PreambleSegments.empty());
+  if (PreambleSegments.size() == 1) {
+    PreambleIndex.reset(PreambleSegments.front().Index);
+  } else {
+    std::vector<std::shared_ptr<SymbolIndex>> Segments;
+    for (const auto &Segment : PreambleSegments)
+      Segments.push_back(Segment.Index);
+    PreambleIndex.reset(std::make_shared<IndexSegments>(std::move(Segments)));
   }
+  vlog("Build dynamic index for header symbols with estimated memory usage of "
+       "{0} bytes in {1} segments",
+       PreambleIndex.estimateMemoryUsage(), PreambleSegments.size());
 }
 
 void FileIndex::updatePreamble(PathRef Path, llvm::StringRef Version,
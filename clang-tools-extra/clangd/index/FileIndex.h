@@ -25,11 +25,13 @@
 #include "index/Symbol.h"
 #include "support/MemoryTree.h"
 #include "support/Path.h"
+#include "support/Threading.h"
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include <memory>
 #include <vector>
 
@@ -86,10 +88,21 @@ public:
   buildIndex(IndexType,
              DuplicateHandling DuplicateHandle = DuplicateHandling::PickOne,
              size_t *Version = nullptr);
+  /// Like above, but the index only covers the slabs of \p Keys. Use it to
+  /// index what an update changed and layer the result on top of an index of
+  /// the other keys. Symbol::References only counts the refs in \p Keys.
+  std::unique_ptr<SymbolIndex>
+  buildIndex(IndexType, DuplicateHandling DuplicateHandle,
+             const llvm::StringSet<> &Keys, size_t *Version = nullptr);
 
   void profile(MemoryTree &MT) const;
 
 private:
+  // Covers all keys if Keys is null.
+  std::unique_ptr<SymbolIndex> buildIndexForKeys(IndexType, DuplicateHandling,
+                                                 const llvm::StringSet<> *Keys,
+                                                 size_t *Version);
+
   IndexContents IdxContents;
 
   struct RefSlabAndCountReferences {
@@ -123,6 +136,11 @@ public:
   void profile(MemoryTree &MT) const;
 
 private:
+  // Publishes PreambleSegments in PreambleIndex. Needs UpdateIndexMu.
+  void publishPreambleSegments();
+  // Replaces the preamble segments by a single index for all files.
+  void compactPreambleIndex();
+
   // Contains information from each file's preamble only. Symbols and relations
   // are sharded per declaration file to deduplicate multiple symbols and reduce
   // memory usage.
@@ -134,6 +152,16 @@ private:
   // different PP states will be missing.
   FileSymbols PreambleSymbols;
   SwapIndex PreambleIndex;
+  // PreambleIndex stacks index segments, sorted by FileSymbols version with
+  // the newest first. Each preamble update adds a segment for the files it
+  // changed, which hides what older segments know about those files. Once
+  // there are too many segments, they are compacted into one on a background
+  // thread.
+  struct PreambleSegment {
+    size_t Version;
+    std::shared_ptr<SymbolIndex> Index;
+  };
+  std::vector<PreambleSegment> PreambleSegments; // GUARDED_BY(UpdateIndexMu)
 
   // Contains information from each file's main AST.
   // These are updated frequently (on file change), but are relatively small.
@@ -148,7 +176,13 @@ private:
   // versions to ensure that we don't overwrite newer indexes with older ones.
   std::mutex UpdateIndexMu;
   unsigned MainIndexVersion = 0;
-  unsigned PreambleIndexVersion = 0;
+  // Version of the last compaction, older segments are no longer needed.
+  size_t PreambleCompactedVersion = 0;
+  bool PreambleCompactionPending = false;
+
+  // Runs the preamble index compactions. Declared last, so that running tasks
+  // finish before the rest of the index is destroyed.
+  AsyncTaskRunner Compactions;
 };
 
 using SlabTuple = std::tuple<SymbolSlab, RefSlab, RelationSlab>;
@@ -449,6 +449,9 @@ readCompileCommand(Reader CmdReader, llvm::ArrayRef<llvm::StringRef> Strings) {
 // A file is a RIFF chunk with type 'CdIx'.
 // It contains the sections:
 //   - meta: version number
+//   - dexp: (optional) Dex posting lists, see Dex::writePostingLists().
+//           This is the first chunk after meta so that its data is 4-aligned
+//           in the file and the posting lists can be used in place.
 //   - srcs: information related to include graph
 //   - stri: string table
 //   - symb: symbols
@@ -535,6 +538,8 @@ llvm::Expected<IndexFileIn> readRIFF(llvm::StringRef Data,
       return error("malformed or truncated relations");
     Result.Relations = std::move(Relations).build();
   }
+  if (Chunks.count("dexp"))
+    Result.PostingLists = Chunks.lookup("dexp");
   if (Chunks.count("cmdl")) {
     Reader CmdReader(Chunks.lookup("cmdl"));
     InternedCompileCommand Cmd =
@@ -569,6 +574,16 @@ void writeRIFF(const IndexFileOut &Data, llvm::raw_ostream &OS) {
   }
   RIFF.Chunks.push_back({riff::fourCC("meta"), Meta});
 
+  std::string PostingListsSection;
+  if (Data.PostingLists) {
+    {
+      llvm::raw_string_ostream PostingListsOS(PostingListsSection);
+      dex::Dex(*Data.Symbols, RefSlab(), RelationSlab())
+          .writePostingLists(PostingListsOS);
+    }
+    RIFF.Chunks.push_back({riff::fourCC("dexp"), PostingListsSection});
+  }
+
   StringTableOut Strings;
   std::vector<Symbol> Symbols;
   for (const auto &Sym : *Data.Symbols) {
@@ -711,19 +726,23 @@ std::unique_ptr<SymbolIndex> loadIndex(llvm::StringRef SymbolFilename,
     elog("Can't open {0}: {1}", SymbolFilename, Buffer.getError().message());
     return nullptr;
   }
+  // Saved posting lists point into the file, keep it alive with the index.
+  std::shared_ptr<llvm::MemoryBuffer> File = std::move(*Buffer);
 
   SymbolSlab Symbols;
   RefSlab Refs;
   RelationSlab Relations;
+  llvm::Optional<llvm::StringRef> PostingLists;
   {
     trace::Span Tracer("ParseIndex");
-    if (auto I = readIndexFile(Buffer->get()->getBuffer(), Origin)) {
+    if (auto I = readIndexFile(File->getBuffer(), Origin)) {
       if (I->Symbols)
         Symbols = std::move(*I->Symbols);
       if (I->Refs)
         Refs = std::move(*I->Refs);
       if (I->Relations)
         Relations = std::move(*I->Relations);
+      PostingLists = I->PostingLists;
     } else {
       elog("Bad index file: {0}", I.takeError());
       return nullptr;
@@ -735,10 +754,17 @@ std::unique_ptr<SymbolIndex> loadIndex(llvm::StringRef SymbolFilename,
   size_t NumRelations = Relations.size();
 
   trace::Span Tracer("BuildIndex");
-  auto Index = UseDex ? dex::Dex::build(std::move(Symbols), std::move(Refs),
-                                        std::move(Relations))
-                      : MemIndex::build(std::move(Symbols), std::move(Refs),
-                                        std::move(Relations));
+  std::unique_ptr<SymbolIndex> Index;
+  if (!UseDex)
+    Index = MemIndex::build(std::move(Symbols), std::move(Refs),
+                            std::move(Relations));
+  else if (PostingLists)
+    Index = dex::Dex::build(std::move(Symbols), std::move(Refs),
+                            std::move(Relations), *PostingLists,
+                            std::move(File));
+  else
+    Index = dex::Dex::build(std::move(Symbols), std::move(Refs),
+                            std::move(Relations));
   vlog("Loaded {0} from {1} with estimated memory usage {2} bytes\n"
        "  - number of symbols: {3}\n"
        "  - number of refs: {4}\n"
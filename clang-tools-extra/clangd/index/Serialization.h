@@ -12,6 +12,7 @@
 //  - metadata such as version info
 //  - a string table (which is compressed)
 //  - lists of encoded symbols
+//  - optionally, Dex posting lists for the symbols
 //
 // The format has a simple versioning scheme: the format version number is
 // written in the file and non-current versions are rejected when reading.
@@ -47,6 +48,8 @@ struct IndexFileIn {
   llvm::Optional<IncludeGraph> Sources;
   // This contains only the Directory and CommandLine.
   llvm::Optional<tooling::CompileCommand> Cmd;
+  // Dex posting lists for Symbols, pointing into the file data.
+  llvm::Optional<llvm::StringRef> PostingLists;
 };
 // Parse an index file. The input must be a RIFF or YAML file.
 llvm::Expected<IndexFileIn> readIndexFile(llvm::StringRef, SymbolOrigin);
@@ -58,7 +61,9 @@ struct IndexFileOut {
   const RelationSlab *Relations = nullptr;
   // Keys are URIs of the source files.
   const IncludeGraph *Sources = nullptr;
-  // TODO: Support serializing Dex posting lists.
+  // Whether to also write the Dex posting lists for Symbols, so that loadIndex()
+  // doesn't have to build them. Only supported by the RIFF format.
+  bool PostingLists = false;
   IndexFileFormat Format = IndexFileFormat::RIFF;
   const tooling::CompileCommand *Cmd = nullptr;
 
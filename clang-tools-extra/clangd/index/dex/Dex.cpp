@@ -20,10 +20,15 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/ADT/bit.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/ScopedPrinter.h"
 #include <algorithm>
+#include <cstring>
 #include <queue>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -41,8 +46,23 @@ std::unique_ptr<SymbolIndex> Dex::build(SymbolSlab Symbols, RefSlab Refs,
                                 Size);
 }
 
+std::unique_ptr<SymbolIndex> Dex::build(SymbolSlab Symbols, RefSlab Refs,
+                                        RelationSlab Rels,
+                                        llvm::StringRef PostingLists,
+                                        std::shared_ptr<void> Storage) {
+  auto Size = Symbols.bytes() + Refs.bytes();
+  auto Data = std::make_tuple(std::move(Symbols), std::move(Refs),
+                              std::move(Storage));
+  return std::make_unique<Dex>(std::get<0>(Data), std::get<1>(Data), Rels,
+                               PostingLists, std::move(Data), Size);
+}
+
 namespace {
 
+// Bump this when the layout written by writePostingLists() changes, or when
+// the way posting lists are built changes (e.g. new token kinds).
+constexpr uint32_t PostingListsVersion = 1;
+
 // Mark symbols which are can be used for code completion.
 const Token RestrictedForCodeCompletion =
     Token(Token::Kind::Sentinel, "Restricted For Code Completion");
@@ -148,6 +168,163 @@ void Dex::buildIndex() {
   InvertedIndex = std::move(Builder).build();
 }
 
+// Saved posting lists are stored as (all integers are little-endian):
+//   uint32 PostingListsVersion
+//   uint32 NumSymbols
+//   uint32 NumChunks
+//   uint32 NumTokens
+//   SymbolID[NumSymbols]    -- 8 raw bytes each, in DocID order
+//   uint32[NumSymbols]      -- bits of the symbol quality, in DocID order
+//   Chunk[NumChunks]        -- 32 bytes each, the Head is stored as uint32
+//   Token[NumTokens]        -- uint8 Kind, uint32 DataSize, uint32 NumChunks,
+//                              DataSize bytes; its chunks follow the chunks of
+//                              the previous token.
+// The header is 16 bytes and every other field before the chunks is a
+// multiple of 4 bytes, so the chunks can be used in place if the data itself
+// is 4-aligned.
+void Dex::writePostingLists(llvm::raw_ostream &OS) const {
+  using namespace llvm::support;
+  // Sort the tokens to get a deterministic output.
+  std::vector<const std::pair<Token, PostingList> *> Tokens;
+  Tokens.reserve(InvertedIndex.size());
+  size_t NumChunks = 0;
+  for (const auto &E : InvertedIndex) {
+    Tokens.push_back(&E);
+    NumChunks += E.second.chunks().size();
+  }
+  llvm::sort(Tokens, [](const auto *L, const auto *R) {
+    return std::make_pair(L->first.kind(), L->first.data()) <
+           std::make_pair(R->first.kind(), R->first.data());
+  });
+
+  endian::write<uint32_t>(OS, PostingListsVersion, little);
+  endian::write<uint32_t>(OS, Symbols.size(), little);
+  endian::write<uint32_t>(OS, NumChunks, little);
+  endian::write<uint32_t>(OS, Tokens.size(), little);
+  for (const Symbol *Sym : Symbols)
+    OS << Sym->ID.raw();
+  for (float Quality : SymbolQuality)
+    endian::write<uint32_t>(OS, llvm::bit_cast<uint32_t>(Quality), little);
+  for (const auto *E : Tokens)
+    for (const Chunk &C : E->second.chunks()) {
+      endian::write<uint32_t>(OS, C.Head, little);
+      OS.write(reinterpret_cast<const char *>(C.Payload.data()),
+               C.Payload.size());
+    }
+  for (const auto *E : Tokens) {
+    OS.write(static_cast<uint8_t>(E->first.kind()));
+    endian::write<uint32_t>(OS, E->first.data().size(), little);
+    endian::write<uint32_t>(OS, E->second.chunks().size(), little);
+    OS << E->first.data();
+  }
+}
+
+bool Dex::loadPostingLists(llvm::StringRef Data) {
+  using namespace llvm::support;
+  constexpr size_t HeaderSize = 4 * sizeof(uint32_t);
+  if (Data.size() < HeaderSize)
+    return false;
+  auto Read32 = [&](size_t Offset) {
+    return endian::read32le(Data.data() + Offset);
+  };
+  if (Read32(0) != PostingListsVersion)
+    return false;
+  uint64_t NumSymbols = Read32(4), NumChunks = Read32(8),
+           NumTokens = Read32(12);
+  if (NumSymbols != Symbols.size())
+    return false;
+  uint64_t ChunksOffset =
+      HeaderSize + NumSymbols * (SymbolID::RawSize + sizeof(uint32_t));
+  uint64_t TokensOffset = ChunksOffset + NumChunks * sizeof(Chunk);
+  if (TokensOffset > Data.size())
+    return false;
+
+  // Build everything aside, so that nothing is left half-done on failure.
+  llvm::DenseMap<SymbolID, const Symbol *> Lookup;
+  for (const Symbol *Sym : Symbols)
+    Lookup[Sym->ID] = Sym;
+  std::vector<const Symbol *> Ordered(NumSymbols);
+  std::vector<float> Quality(NumSymbols);
+  for (size_t I = 0; I < NumSymbols; ++I) {
+    auto It = Lookup.find(SymbolID::fromRaw(
+        Data.substr(HeaderSize + I * SymbolID::RawSize, SymbolID::RawSize)));
+    if (It == Lookup.end() || !It->second)
+      return false;
+    Ordered[I] = It->second;
+    // Each symbol must appear once.
+    It->second = nullptr;
+    Quality[I] = llvm::bit_cast<float>(Read32(
+        HeaderSize + NumSymbols * SymbolID::RawSize + I * sizeof(uint32_t)));
+  }
+
+  // Chunks can be used in place if their in-memory representation matches
+  // the serialized one.
+  llvm::ArrayRef<Chunk> Chunks;
+  std::vector<Chunk> Copied;
+  const char *ChunksData = Data.data() + ChunksOffset;
+  if (endian::system_endianness() == little &&
+      reinterpret_cast<uintptr_t>(ChunksData) % alignof(Chunk) == 0) {
+    Chunks = llvm::makeArrayRef(reinterpret_cast<const Chunk *>(ChunksData),
+                                NumChunks);
+  } else {
+    Copied.resize(NumChunks);
+    for (size_t I = 0; I < NumChunks; ++I) {
+      const char *P = ChunksData + I * sizeof(Chunk);
+      Copied[I].Head = endian::read32le(P);
+      std::memcpy(Copied[I].Payload.data(), P + sizeof(uint32_t),
+                  Chunk::PayloadSize);
+    }
+    Chunks = Copied;
+  }
+
+  llvm::DenseMap<Token, PostingList> Index(NumTokens);
+  size_t Offset = TokensOffset, ChunkIndex = 0;
+  constexpr size_t TokenHeaderSize = 1 + 2 * sizeof(uint32_t);
+  for (size_t I = 0; I < NumTokens; ++I) {
+    if (Data.size() - Offset < TokenHeaderSize)
+      return false;
+    uint8_t Kind = Data[Offset];
+    uint32_t DataSize = Read32(Offset + 1);
+    uint32_t TokenChunks = Read32(Offset + 5);
+    Offset += TokenHeaderSize;
+    if (Kind > static_cast<uint8_t>(Token::Kind::Sentinel) ||
+        Data.size() - Offset < DataSize || TokenChunks == 0 ||
+        NumChunks - ChunkIndex < TokenChunks)
+      return false;
+    auto ListChunks = Chunks.slice(ChunkIndex, TokenChunks);
+    // The iterators rely on DocIDs strictly increasing across all chunks of
+    // the list, and every DocID must refer to a symbol.
+    int64_t Previous = -1;
+    for (const Chunk &C : ListChunks) {
+      auto IDs = C.tryDecompress();
+      if (!IDs)
+        return false;
+      for (DocID ID : *IDs) {
+        if (ID <= Previous || ID >= NumSymbols)
+          return false;
+        Previous = ID;
+      }
+    }
+    Token Tok(static_cast<Token::Kind>(Kind), Data.substr(Offset, DataSize));
+    if (!Index.try_emplace(std::move(Tok), PostingList(ListChunks)).second)
+      return false;
+    Offset += DataSize;
+    ChunkIndex += TokenChunks;
+  }
+  if (Offset != Data.size() || ChunkIndex != NumChunks)
+    return false;
+
+  this->Corpus = dex::Corpus(NumSymbols);
+  for (const Symbol *Sym : Ordered)
+    LookupTable[Sym->ID] = Sym;
+  Symbols = std::move(Ordered);
+  SymbolQuality = std::move(Quality);
+  InvertedIndex = std::move(Index);
+  // Moving the vector keeps its buffer, so the posting lists stay valid.
+  LoadedChunks = std::move(Copied);
+  return true;
+}
+
 std::unique_ptr<Iterator> Dex::iterator(const Token &Tok) const {
   auto It = InvertedIndex.find(Tok);
   return It == InvertedIndex.end() ? Corpus.none()
@@ -346,6 +523,7 @@ size_t Dex::estimateMemoryUsage() const {
   Bytes += SymbolQuality.size() * sizeof(float);
   Bytes += LookupTable.getMemorySize();
   Bytes += InvertedIndex.getMemorySize();
+  Bytes += LoadedChunks.capacity() * sizeof(Chunk);
   for (const auto &TokenToPostingList : InvertedIndex)
     Bytes += TokenToPostingList.second.bytes();
   Bytes += Refs.getMemorySize();
@@ -38,14 +38,7 @@ public:
   template <typename SymbolRange, typename RefsRange, typename RelationsRange>
   Dex(SymbolRange &&Symbols, RefsRange &&Refs, RelationsRange &&Relations)
       : Corpus(0) {
-    for (auto &&Sym : Symbols)
-      this->Symbols.push_back(&Sym);
-    for (auto &&Ref : Refs)
-      this->Refs.try_emplace(Ref.first, Ref.second);
-    for (auto &&Rel : Relations)
-      this->Relations[std::make_pair(Rel.Subject,
-                                     static_cast<uint8_t>(Rel.Predicate))]
-          .push_back(Rel.Object);
+    addData(Symbols, Refs, Relations);
     buildIndex();
   }
   // Symbols and Refs are owned by BackingData, Index takes ownership.
@@ -72,8 +65,38 @@ public:
     this->IdxContents = IdxContents;
   }
 
+  // Symbols and Refs are owned by BackingData, Index takes ownership.
+  // PostingLists were saved by writePostingLists() for the same symbols. They
+  // are used in place instead of building the posting lists, so BackingData
+  // must keep them alive too. If they are unusable, e.g. because they were
+  // written by a different version, the posting lists are built as usual.
+  template <typename SymbolRange, typename RefsRange, typename RelationsRange,
+            typename Payload>
+  Dex(SymbolRange &&Symbols, RefsRange &&Refs, RelationsRange &&Relations,
+      llvm::StringRef PostingLists, Payload &&BackingData,
+      size_t BackingDataSize)
+      : Corpus(0) {
+    addData(Symbols, Refs, Relations);
+    if (!loadPostingLists(PostingLists))
+      buildIndex();
+    KeepAlive = std::shared_ptr<void>(
+        std::make_shared<Payload>(std::move(BackingData)), nullptr);
+    this->BackingDataSize = BackingDataSize;
+  }
+
   /// Builds an index from slabs. The index takes ownership of the slab.
   static std::unique_ptr<SymbolIndex> build(SymbolSlab, RefSlab, RelationSlab);
+  /// Builds an index from slabs, reusing the posting lists saved along with
+  /// the symbols. The index takes ownership of the slabs and of \p Storage,
+  /// which must keep \p PostingLists alive.
+  static std::unique_ptr<SymbolIndex> build(SymbolSlab, RefSlab, RelationSlab,
+                                            llvm::StringRef PostingLists,
+                                            std::shared_ptr<void> Storage);
+
+  /// Writes the symbol order and the posting lists of this index, so that
+  /// they can be stored along with the symbols and used in place when the
+  /// symbols are loaded again.
+  void writePostingLists(llvm::raw_ostream &OS) const;
 
   bool
   fuzzyFind(const FuzzyFindRequest &Req,
@@ -95,7 +118,21 @@ public:
   size_t estimateMemoryUsage() const override;
 
 private:
+  template <typename SymbolRange, typename RefsRange, typename RelationsRange>
+  void addData(SymbolRange &&Symbols, RefsRange &&Refs,
+               RelationsRange &&Relations) {
+    for (auto &&Sym : Symbols)
+      this->Symbols.push_back(&Sym);
+    for (auto &&Ref : Refs)
+      this->Refs.try_emplace(Ref.first, Ref.second);
+    for (auto &&Rel : Relations)
+      this->Relations[std::make_pair(Rel.Subject,
+                                     static_cast<uint8_t>(Rel.Predicate))]
+          .push_back(Rel.Object);
+  }
+
   void buildIndex();
+  bool loadPostingLists(llvm::StringRef Data);
   std::unique_ptr<Iterator> iterator(const Token &Tok) const;
   std::unique_ptr<Iterator>
   createFileProximityIterator(llvm::ArrayRef<std::string> ProximityPaths) const;
@@ -114,6 +151,8 @@ private:
   /// std. Inverted index is used to retrieve posting lists which are processed
   /// during the fuzzyFind process.
   llvm::DenseMap<Token, PostingList> InvertedIndex;
+  /// Chunks of loaded posting lists that couldn't be used in place.
+  std::vector<Chunk> LoadedChunks;
   dex::Corpus Corpus;
   llvm::DenseMap<SymbolID, llvm::ArrayRef<Ref>> Refs;
   static_assert(sizeof(RelationKind) == sizeof(uint8_t),
@@ -181,41 +181,58 @@ std::vector<Chunk> encodeStream(llvm::ArrayRef<DocID> Documents) {
 }
 
 /// Reads variable length DocID from the buffer and updates the buffer size. If
-/// the stream is terminated, return std::nullopt.
-llvm::Optional<DocID> readVByte(llvm::ArrayRef<uint8_t> &Bytes) {
-  if (Bytes.front() == 0 || Bytes.empty())
+/// the stream is terminated, return std::nullopt. Sets \p Malformed and
+/// returns std::nullopt if the encoding is truncated or doesn't fit a DocID.
+llvm::Optional<DocID> readVByte(llvm::ArrayRef<uint8_t> &Bytes,
+                                bool &Malformed) {
+  if (Bytes.empty() || Bytes.front() == 0)
     return std::nullopt;
+  // A DocID takes at most 5 bytes, the last one holds its 4 highest bits.
+  constexpr size_t MaxLength = 5;
   DocID Result = 0;
-  bool HasNextByte = true;
-  for (size_t Length = 0; HasNextByte && !Bytes.empty(); ++Length) {
-    assert(Length <= 5 && "Malformed VByte encoding sequence.");
-    // Write meaningful bits to the correct place in the document decoding.
-    Result |= (Bytes.front() & 0x7f) << (BitsPerEncodingByte * Length);
-    if ((Bytes.front() & 0x80) == 0)
-      HasNextByte = false;
+  for (size_t Length = 0; !Bytes.empty() && Length < MaxLength; ++Length) {
+    uint8_t Byte = Bytes.front();
     Bytes = Bytes.drop_front();
+    if (Length == MaxLength - 1 && (Byte & 0x70))
+      break;
+    // Write meaningful bits to the correct place in the document decoding.
+    Result |= static_cast<DocID>(Byte & 0x7f) << (BitsPerEncodingByte * Length);
+    if ((Byte & 0x80) == 0)
+      return Result;
   }
-  return Result;
+  Malformed = true;
+  return std::nullopt;
 }
 
 } // namespace
 
-llvm::SmallVector<DocID, Chunk::PayloadSize + 1> Chunk::decompress() const {
+llvm::Optional<llvm::SmallVector<DocID, Chunk::PayloadSize + 1>>
+Chunk::tryDecompress() const {
   llvm::SmallVector<DocID, Chunk::PayloadSize + 1> Result{Head};
   llvm::ArrayRef<uint8_t> Bytes(Payload);
+  bool Malformed = false;
   DocID Delta;
   for (DocID Current = Head; !Bytes.empty(); Current += Delta) {
-    auto MaybeDelta = readVByte(Bytes);
+    auto MaybeDelta = readVByte(Bytes, Malformed);
     if (!MaybeDelta)
       break;
     Delta = *MaybeDelta;
     Result.push_back(Current + Delta);
   }
-  return llvm::SmallVector<DocID, Chunk::PayloadSize + 1>{Result};
+  if (Malformed)
+    return std::nullopt;
+  return Result;
+}
+
+llvm::SmallVector<DocID, Chunk::PayloadSize + 1> Chunk::decompress() const {
+  auto Result = tryDecompress();
+  assert(Result && "Malformed VByte encoding sequence.");
+  return Result ? std::move(*Result)
+                : llvm::SmallVector<DocID, Chunk::PayloadSize + 1>{Head};
 }
 
 PostingList::PostingList(llvm::ArrayRef<DocID> Documents)
-    : Chunks(encodeStream(Documents)) {}
+    : Storage(encodeStream(Documents)), Chunks(Storage) {}
 
 std::unique_ptr<Iterator> PostingList::iterator(const Token *Tok) const {
   return std::make_unique<ChunkIterator>(Tok, Chunks);
@@ -25,6 +25,7 @@
 
 #include "Iterator.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 #include <cstdint>
 #include <vector>
@@ -44,6 +45,10 @@ struct Chunk {
   static constexpr size_t PayloadSize = 32 - sizeof(DocID);
 
   llvm::SmallVector<DocID, PayloadSize + 1> decompress() const;
+  /// Like decompress(), but returns std::nullopt if the payload is not a valid
+  /// encoding, e.g. for a chunk read from a file.
+  llvm::Optional<llvm::SmallVector<DocID, PayloadSize + 1>>
+  tryDecompress() const;
 
   /// The first element of decompressed Chunk.
   DocID Head;
@@ -59,6 +64,13 @@ static_assert(sizeof(Chunk) == 32, "Chunk should take 32 bytes of memory.");
 class PostingList {
 public:
   explicit PostingList(llvm::ArrayRef<DocID> Documents);
+  /// Creates a posting list over chunks that were encoded before, e.g. the
+  /// ones saved in an index file. The chunks are used in place, so they must
+  /// outlive the posting list.
+  explicit PostingList(llvm::ArrayRef<Chunk> Chunks) : Chunks(Chunks) {}
+
+  PostingList(PostingList &&) = default;
+  PostingList &operator=(PostingList &&) = default;
 
   /// Constructs DocumentIterator over given posting list. DocumentIterator will
   /// go through the chunks and decompress them on-the-fly when necessary.
@@ -66,10 +78,15 @@ public:
   std::unique_ptr<Iterator> iterator(const Token *Tok = nullptr) const;
 
   /// Returns in-memory size of external storage.
-  size_t bytes() const { return Chunks.capacity() * sizeof(Chunk); }
+  size_t bytes() const { return Storage.capacity() * sizeof(Chunk); }
+
+  /// The encoded posting list.
+  llvm::ArrayRef<Chunk> chunks() const { return Chunks; }
 
 private:
-  const std::vector<Chunk> Chunks;
+  /// Owns the chunks, unless they are stored elsewhere.
+  std::vector<Chunk> Storage;
+  llvm::ArrayRef<Chunk> Chunks;
 };
 
 } // namespace dex
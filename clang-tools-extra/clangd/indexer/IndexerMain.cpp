@@ -162,6 +162,8 @@ int main(int argc, const char **argv) {
   // Emit collected data.
   clang::clangd::IndexFileOut Out(Data);
   Out.Format = clang::clangd::Format;
+  // Static indexes are loaded much more often than they are written.
+  Out.PostingLists = true;
   llvm::outs() << Out;
   return 0;
 }
@@ -168,6 +168,15 @@ opt<bool> EnableBackgroundIndex{
     init(true),
 };
 
+opt<std::string> BackgroundIndexSharedCache{
+    "background-index-shared-cache",
+    cat(Features),
+    desc("Also store background index shards in this directory, keyed by file "
+         "contents. Other checkouts of a project, and other clangd instances "
+         "using the same directory, reuse them instead of indexing again."),
+    init(""),
+};
+
 opt<llvm::ThreadPriority> BackgroundIndexPriority{
     "background-index-priority",
     cat(Features),
@@ -403,6 +412,14 @@ opt<PCHStorageFlag> PCHStorage{
     init(PCHStorageFlag::Disk),
 };
 
+opt<bool> SharePreambles{
+    "share-preambles",
+    cat(Misc),
+    desc("Let open files in the same directory share a preamble when they "
+         "start with the same includes and use the same compile flags"),
+    init(false),
+};
+
 opt<bool> Sync{
     "sync",
     cat(Misc),
@@ -871,6 +888,7 @@ clangd accepts flags on the commandline, and in the CLANGD_FLAGS environment var
     Opts.StorePreamblesInMemory = false;
     break;
   }
+  Opts.SharePreambles = SharePreambles;
   if (!ResourceDir.empty())
     Opts.ResourceDir = ResourceDir;
   Opts.BuildDynamicSymbolIndex = true;
@@ -893,6 +911,7 @@ clangd accepts flags on the commandline, and in the CLANGD_FLAGS environment var
 #endif
   Opts.BackgroundIndex = EnableBackgroundIndex;
   Opts.BackgroundIndexPriority = BackgroundIndexPriority;
+  Opts.BackgroundIndexSharedCache = BackgroundIndexSharedCache;
   Opts.ReferencesLimit = ReferencesLimit;
   Opts.Rename.LimitFiles = RenameFileLimit;
   auto PAI = createProjectAwareIndex(loadExternalIndex, Sync);
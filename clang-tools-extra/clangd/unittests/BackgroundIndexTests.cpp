@@ -10,6 +10,8 @@
 #include "clang/Tooling/ArgumentsAdjusters.h"
 #include "clang/Tooling/CompilationDatabase.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ScopedPrinter.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -908,5 +910,79 @@ TEST(BackgroundIndex, Profile) {
               UnorderedElementsAre(Pair("slabs", _), Pair("index", _)));
 }
 
+TEST(BackgroundIndexStorage, SharedCache) {
+  llvm::SmallString<256> TempDir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("SharedCache", TempDir));
+  ASSERT_FALSE(llvm::sys::fs::real_path(TempDir.str(), TempDir));
+  auto CleanDir = llvm::make_scope_exit(
+      [&] { llvm::sys::fs::remove_directories(TempDir); });
+  // Two checkouts of the same project.
+  std::string A = (TempDir + "/a").str(), B = (TempDir + "/b").str();
+  for (llvm::StringRef Root : {A, B}) {
+    ASSERT_FALSE(llvm::sys::fs::create_directories(Root));
+    std::error_code EC;
+    llvm::raw_fd_ostream(Root.str() + "/foo.cc", EC) << "int foo;";
+    ASSERT_FALSE(EC);
+  }
+  auto Factory = BackgroundIndexStorage::createDiskBackedStorageFactory(
+      [&](PathRef File) {
+        return ProjectInfo{File.startswith(A) ? A : B};
+      },
+      (TempDir + "/shared").str());
+  auto CommandFor = [](llvm::StringRef Root) {
+    return tooling::CompileCommand(Root, Root.str() + "/foo.cc",
+                                   {"clang", "-I" + Root.str() + "/include",
+                                    Root.str() + "/foo.cc"},
+                                   "");
+  };
+
+  std::string FileA = A + "/foo.cc", FileB = B + "/foo.cc";
+  std::string URIA = URI::create(FileA).toString();
+  SymbolSlab::Builder Symbols;
+  Symbol Foo;
+  Foo.ID = SymbolID("foo");
+  Foo.Name = "foo";
+  Foo.CanonicalDeclaration.FileURI = URIA.c_str();
+  Symbols.insert(Foo);
+  SymbolSlab Slab = std::move(Symbols).build();
+  IncludeGraph Sources;
+  auto &Node = Sources[URIA];
+  Node.URI = URIA;
+  Node.Digest = digest("int foo;");
+  Node.Flags = IncludeGraphNode::SourceFlag::IsTU;
+  tooling::CompileCommand CmdA = CommandFor(A);
+  IndexFileOut Shard;
+  Shard.Symbols = &Slab;
+  Shard.Sources = &Sources;
+  Shard.Cmd = &CmdA;
+  ASSERT_FALSE(Factory(FileA)->storeShard(FileA, Shard));
+
+  // The other checkout finds the shard, with its own paths.
+  auto Loaded = Factory(FileB)->loadShardForCommand(FileB, CommandFor(B));
+  ASSERT_TRUE(Loaded);
+  std::string URIB = URI::create(FileB).toString();
+  ASSERT_TRUE(Loaded->Symbols);
+  EXPECT_EQ(llvm::StringRef(
+                Loaded->Symbols->find(Foo.ID)->CanonicalDeclaration.FileURI),
+            URIB);
+  ASSERT_TRUE(Loaded->Sources);
+  EXPECT_THAT(Loaded->Sources->keys(), ElementsAre(URIB));
+  ASSERT_TRUE(Loaded->Cmd);
+  EXPECT_EQ(Loaded->Cmd->CommandLine, CommandFor(B).CommandLine);
+
+  // Shards of main files are only reused for the same flags.
+  auto OtherCmd = CommandFor(B);
+  OtherCmd.CommandLine.insert(OtherCmd.CommandLine.begin() + 1, "-DFOO");
+  EXPECT_FALSE(Factory(FileB)->loadShardForCommand(FileB, OtherCmd));
+
+  // Or for the same contents.
+  {
+    std::error_code EC;
+    llvm::raw_fd_ostream(FileB, EC) << "int bar;";
+    ASSERT_FALSE(EC);
+  }
+  EXPECT_FALSE(Factory(FileB)->loadShardForCommand(FileB, CommandFor(B)));
+}
+
 } // namespace clangd
 } // namespace clang
@@ -14,6 +14,7 @@
 #include "index/dex/Iterator.h"
 #include "index/dex/Token.h"
 #include "index/dex/Trigram.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/ScopedPrinter.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -510,6 +511,70 @@ TEST(Dex, FuzzyFind) {
                                    "other::A"));
 }
 
+TEST(DexTest, SavedPostingLists) {
+  std::vector<std::string> Names = {"ns::ABC", "ns::BCD", "::ABC",
+                                    "ns::nested::ABC", "other::ABC",
+                                    "other::A"};
+  std::string Saved;
+  {
+    llvm::raw_string_ostream OS(Saved);
+    Dex(generateSymbols(Names), RefSlab(), RelationSlab())
+        .writePostingLists(OS);
+  }
+  auto Built = Dex::build(generateSymbols(Names), RefSlab(), RelationSlab());
+  // Saved data at an odd offset can't be used in place, so it is copied.
+  std::string Misaligned = " " + Saved;
+  // Truncated data is rejected, the posting lists are built instead.
+  std::string Truncated = Saved.substr(0, Saved.size() - 1);
+  for (llvm::StringRef Data :
+       {llvm::StringRef(Saved), llvm::StringRef(Misaligned).drop_front(),
+        llvm::StringRef(Truncated), llvm::StringRef()}) {
+    auto Loaded = Dex::build(generateSymbols(Names), RefSlab(), RelationSlab(),
+                             Data, nullptr);
+    FuzzyFindRequest Req;
+    Req.Query = "ABC";
+    Req.Scopes = {"ns::", "ns::nested::"};
+    EXPECT_THAT(match(*Loaded, Req),
+                UnorderedElementsAre("ns::ABC", "ns::nested::ABC"));
+    Req.Query = "";
+    Req.Scopes = {};
+    Req.AnyScope = true;
+    EXPECT_EQ(match(*Loaded, Req), match(*Built, Req));
+  }
+}
+
+TEST(DexTest, SavedPostingListsOutOfRange) {
+  // All symbols share the global scope, so its posting list spans several
+  // chunks.
+  constexpr uint32_t NumSymbols = 101;
+  std::string Saved;
+  {
+    llvm::raw_string_ostream OS(Saved);
+    Dex(generateNumSymbols(0, NumSymbols - 1), RefSlab(), RelationSlab())
+        .writePostingLists(OS);
+  }
+  auto Built = Dex::build(generateNumSymbols(0, NumSymbols - 1), RefSlab(),
+                          RelationSlab());
+  FuzzyFindRequest Req;
+  Req.Scopes = {""};
+  const auto Expected = match(*Built, Req);
+  ASSERT_EQ(Expected.size(), NumSymbols);
+
+  uint32_t NumChunks = llvm::support::endian::read32le(Saved.data() + 8);
+  size_t ChunksOffset = 16 + NumSymbols * (SymbolID::RawSize + 4);
+  ASSERT_GT(NumChunks, 1u);
+  // A DocID past the symbols is rejected in any chunk, not only in the last
+  // chunk of a list.
+  for (uint32_t I = 0; I < NumChunks; ++I) {
+    std::string Corrupt = Saved;
+    llvm::support::endian::write32le(&Corrupt[ChunksOffset + I * sizeof(Chunk)],
+                                     NumSymbols);
+    auto Loaded = Dex::build(generateNumSymbols(0, NumSymbols - 1), RefSlab(),
+                             RelationSlab(), Corrupt, nullptr);
+    EXPECT_EQ(match(*Loaded, Req), Expected) << "chunk " << I;
+  }
+}
+
 TEST(DexTest, DexLimitedNumMatches) {
   auto I = Dex::build(generateNumSymbols(0, 100), RefSlab(), RelationSlab());
   FuzzyFindRequest Req;
@@ -162,6 +162,22 @@ TEST(FileSymbolsTest, SnapshotAliveAfterRemove) {
   EXPECT_THAT(getRefs(*Symbols, ID), refsAre({fileURI("f1.cc")}));
 }
 
+TEST(FileSymbolsTest, BuildIndexForKeys) {
+  FileSymbols FS(IndexContents::All);
+  FS.update("f1", numSlab(1, 3), nullptr, nullptr, false);
+  FS.update("f2", numSlab(3, 5), nullptr, nullptr, false);
+  llvm::StringSet<> Keys;
+  Keys.insert("f2");
+  for (auto Type : {IndexType::Light, IndexType::Heavy}) {
+    auto Idx = FS.buildIndex(Type, DuplicateHandling::PickOne, Keys);
+    EXPECT_THAT(runFuzzyFind(*Idx, ""),
+                UnorderedElementsAre(qName("3"), qName("4"), qName("5")));
+    auto Files = Idx->indexedFiles();
+    EXPECT_EQ(Files("f1"), IndexContents::None);
+    EXPECT_EQ(Files("f2"), IndexContents::All);
+  }
+}
+
 // Adds Basename.cpp, which includes Basename.h, which contains Code.
 void update(FileIndex &M, llvm::StringRef Basename, llvm::StringRef Code) {
   TestTU File;
@@ -547,6 +563,111 @@ TEST(FileIndexTest, StalePreambleSymbolsDeleted) {
   EXPECT_THAT(runFuzzyFind(M, ""), UnorderedElementsAre(qName("b")));
 }
 
+TEST(FileIndexTest, PreambleSegments) {
+  FileIndex M;
+  const char *Headers[] = {"file:///a.h", "file:///b.h", "file:///c.h"};
+  // Enough updates to get the segments compacted at least once.
+  for (unsigned I = 0; I < 20; ++I) {
+    std::string Name = "s" + std::to_string(I);
+    auto Sym = symbol(Name);
+    Sym.CanonicalDeclaration.FileURI = Headers[I % std::size(Headers)];
+    SymbolSlab::Builder B;
+    B.insert(Sym);
+    IndexFileIn IF;
+    IF.Symbols.emplace(std::move(B).build());
+    M.updatePreamble(std::move(IF));
+    // Only the latest symbol of each header is still around.
+    EXPECT_THAT(runFuzzyFind(M, ""),
+                ::testing::SizeIs(std::min<size_t>(I + 1, std::size(Headers))));
+    EXPECT_THAT(runFuzzyFind(M, ""), Contains(qName(Name)));
+  }
+  EXPECT_THAT(runFuzzyFind(M, ""),
+              UnorderedElementsAre(qName("s17"), qName("s18"), qName("s19")));
+}
+
+TEST(FileIndexTest, PreambleSegmentsShadowOlderOnes) {
+  FileIndex M;
+  auto Update = [&](llvm::ArrayRef<Symbol> Symbols,
+                    llvm::ArrayRef<Relation> Relations) {
+    SymbolSlab::Builder SB;
+    for (const auto &Sym : Symbols)
+      SB.insert(Sym);
+    RelationSlab::Builder RB;
+    for (const auto &Rel : Relations)
+      RB.insert(Rel);
+    IndexFileIn IF;
+    IF.Symbols.emplace(std::move(SB).build());
+    IF.Relations.emplace(std::move(RB).build());
+    M.updatePreamble(std::move(IF));
+  };
+  auto Base = symbol("Base");
+  Base.CanonicalDeclaration.FileURI = "file:///a.h";
+  auto Derived = symbol("Derived");
+  Derived.CanonicalDeclaration.FileURI = "file:///a.h";
+  auto Other = symbol("Other");
+  Other.CanonicalDeclaration.FileURI = "file:///b.h";
+  auto Documented = Base;
+  Documented.Documentation = "doc";
+  Documented.Definition.FileURI = "file:///a.h";
+
+  Update({Documented, Derived},
+         {Relation{Base.ID, RelationKind::BaseOf, Derived.ID}});
+  Update({Other}, {});
+  // a.h loses the doc comment, the definition and the relation.
+  Update({Base, Derived}, {});
+
+  LookupRequest Req;
+  Req.IDs.insert(Base.ID);
+  unsigned Found = 0;
+  M.lookup(Req, [&](const Symbol &Sym) {
+    ++Found;
+    EXPECT_EQ(Sym.Documentation, "");
+    EXPECT_FALSE(Sym.Definition);
+  });
+  EXPECT_EQ(Found, 1u);
+  EXPECT_THAT(runFuzzyFind(M, ""),
+              UnorderedElementsAre(AllOf(qName("Base"), defURI("")),
+                                   qName("Derived"), qName("Other")));
+
+  RelationsRequest RelReq;
+  RelReq.Subjects.insert(Base.ID);
+  RelReq.Predicate = RelationKind::BaseOf;
+  unsigned Relations = 0;
+  M.relations(RelReq, [&](const SymbolID &, const Symbol &) { ++Relations; });
+  EXPECT_EQ(Relations, 0u);
+}
+
+TEST(FileIndexTest, PreambleSegmentsLimit) {
+  FileIndex M;
+  auto Update = [&](llvm::ArrayRef<Symbol> Symbols) {
+    SymbolSlab::Builder B;
+    for (const auto &Sym : Symbols)
+      B.insert(Sym);
+    IndexFileIn IF;
+    IF.Symbols.emplace(std::move(B).build());
+    M.updatePreamble(std::move(IF));
+  };
+  // The best matches of the older segment are all from a.h.
+  std::vector<Symbol> Old;
+  for (unsigned I = 0; I < 5; ++I) {
+    Old.push_back(symbol("foo" + std::to_string(I)));
+    Old.back().CanonicalDeclaration.FileURI = "file:///a.h";
+  }
+  Old.push_back(symbol("barFoo"));
+  Old.back().CanonicalDeclaration.FileURI = "file:///c.h";
+  Update(Old);
+  auto Fresh = symbol("foo");
+  Fresh.CanonicalDeclaration.FileURI = "file:///a.h";
+  Update({Fresh});
+
+  FuzzyFindRequest Req;
+  Req.Query = "foo";
+  Req.AnyScope = true;
+  Req.Limit = 2;
+  EXPECT_THAT(runFuzzyFind(M, Req),
+              UnorderedElementsAre(qName("foo"), qName("barFoo")));
+}
+
 // Verifies that concurrent calls to updateMain don't "lose" any updates.
 TEST(FileIndexTest, Threadsafety) {
   FileIndex M;
@@ -13,7 +13,9 @@
 #include "clang/Tooling/CompilationDatabase.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/Compression.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ScopedPrinter.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -252,6 +254,70 @@ TEST(SerializationTest, BinaryConversions) {
               UnorderedElementsAreArray(yamlFromRelations(*In->Relations)));
 }
 
+TEST(SerializationTest, PostingLists) {
+  auto In = readIndexFile(YAML);
+  ASSERT_TRUE(bool(In)) << In.takeError();
+
+  IndexFileOut Out(*In);
+  Out.Format = IndexFileFormat::RIFF;
+  auto In2 = readIndexFile(llvm::to_string(Out));
+  ASSERT_TRUE(bool(In2)) << In2.takeError();
+  EXPECT_FALSE(In2->PostingLists);
+
+  Out.PostingLists = true;
+  std::string Serialized = llvm::to_string(Out);
+  In2 = readIndexFile(Serialized);
+  ASSERT_TRUE(bool(In2)) << In2.takeError();
+  ASSERT_TRUE(In2->Symbols);
+  ASSERT_TRUE(In2->PostingLists);
+  EXPECT_THAT(yamlFromSymbols(*In2->Symbols),
+              UnorderedElementsAreArray(yamlFromSymbols(*In->Symbols)));
+}
+
+TEST(SerializationTest, CorruptedPostingLists) {
+  auto In = readIndexFile(YAML);
+  ASSERT_TRUE(bool(In)) << In.takeError();
+  IndexFileOut Out(*In);
+  Out.Format = IndexFileFormat::RIFF;
+  Out.PostingLists = true;
+  std::string Serialized = llvm::to_string(Out);
+  auto In2 = readIndexFile(Serialized);
+  ASSERT_TRUE(bool(In2)) << In2.takeError();
+  ASSERT_TRUE(In2->PostingLists);
+
+  // Fill the payload of every saved chunk with continuation bytes, which
+  // makes a VByte sequence longer than any DocID.
+  size_t DexpOffset = In2->PostingLists->data() - Serialized.data();
+  const char *Dexp = Serialized.data() + DexpOffset;
+  uint32_t NumSymbols = llvm::support::endian::read32le(Dexp + 4);
+  uint32_t NumChunks = llvm::support::endian::read32le(Dexp + 8);
+  ASSERT_GT(NumChunks, 0u);
+  size_t ChunksOffset =
+      DexpOffset + 16 + NumSymbols * (SymbolID::RawSize + sizeof(uint32_t));
+  for (uint32_t I = 0; I < NumChunks; ++I)
+    std::fill_n(&Serialized[ChunksOffset + I * 32 + sizeof(uint32_t)], 28,
+                '\xff');
+
+  // The loader ignores the posting lists and builds them instead.
+  llvm::SmallString<128> Path;
+  int FD;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("corrupted-dexp", "idx", FD, Path));
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Serialized;
+  }
+  auto Index = loadIndex(Path, SymbolOrigin::Static, /*UseDex=*/true);
+  llvm::sys::fs::remove(Path);
+  ASSERT_TRUE(Index);
+  FuzzyFindRequest Req;
+  Req.Scopes = {"clang::"};
+  std::vector<std::string> Names;
+  Index->fuzzyFind(Req,
+                   [&](const Symbol &Sym) { Names.push_back(Sym.Name.str()); });
+  EXPECT_THAT(Names, UnorderedElementsAre("Foo1", "Foo2"));
+}
+
 TEST(SerializationTest, SrcsTest) {
   auto In = readIndexFile(YAML);
   EXPECT_TRUE(bool(In)) << In.takeError();
@@ -684,7 +684,7 @@ TEST_F(TUSchedulerTests, EmptyPreamble) {
       [&](Expected<InputsAndPreamble> Preamble) {
         // We expect to get a non-empty preamble.
         EXPECT_GT(
-            cantFail(std::move(Preamble)).Preamble->Preamble.getBounds().Size,
+            cantFail(std::move(Preamble)).Preamble->Preamble->getBounds().Size,
             0u);
       });
   // Wait while the preamble is being built.
@@ -699,11 +699,97 @@ TEST_F(TUSchedulerTests, EmptyPreamble) {
       [&](Expected<InputsAndPreamble> Preamble) {
         // We expect to get an empty preamble.
         EXPECT_EQ(
-            cantFail(std::move(Preamble)).Preamble->Preamble.getBounds().Size,
+            cantFail(std::move(Preamble)).Preamble->Preamble->getBounds().Size,
             0u);
       });
 }
 
+TEST_F(TUSchedulerTests, SharedPreamble) {
+  // Satisfies all requests at once, counts the ones not released yet.
+  struct : public PreambleThrottler {
+    std::atomic<unsigned> Held = {0};
+    RequestID acquire(llvm::StringRef Filename, Callback CB) override {
+      ++Held;
+      CB();
+      return 0;
+    }
+    void release(RequestID) override { --Held; }
+  } Throttler;
+  struct CaptureBuiltFilenames : public ParsingCallbacks {
+    std::atomic<unsigned> &Held;
+    std::mutex Mu;
+    std::vector<std::string> Filenames;
+    CaptureBuiltFilenames(std::atomic<unsigned> &Held) : Held(Held) {}
+    void onPreambleAST(PathRef Path, llvm::StringRef Version,
+                       const CompilerInvocation &CI, ASTContext &Ctx,
+                       Preprocessor &PP, const CanonicalIncludes &) override {
+      EXPECT_GT(Held, 0u) << "Built " << Path << " without the throttler";
+      std::lock_guard<std::mutex> Lock(Mu);
+      Filenames.emplace_back(Path);
+    }
+  };
+  auto Opts = optsForTest();
+  Opts.SharePreambles = true;
+  Opts.PreambleThrottler = &Throttler;
+  auto Callbacks = std::make_unique<CaptureBuiltFilenames>(Throttler.Held);
+  auto &Built = Callbacks->Filenames;
+  TUScheduler S(CDB, Opts, std::move(Callbacks));
+
+  auto Foo = testPath("foo.cpp");
+  auto Bar = testPath("bar.cpp");
+  auto Baz = testPath("baz.cpp");
+  FS.Files[testPath("foo.h")] = "int foo();";
+  S.update(Foo, getInputs(Foo, "#include \"foo.h\"\nint a = foo();"),
+           WantDiagnostics::Yes);
+  ASSERT_TRUE(S.blockUntilIdle(timeoutSeconds(10)));
+  auto BarInputs = getInputs(Bar, "#include \"foo.h\"\nint b = foo();");
+  BarInputs.Version = "bar-1";
+  S.update(Bar, BarInputs, WantDiagnostics::Yes);
+  // Macros in the preamble region point into the main file, no sharing.
+  S.update(Baz,
+           getInputs(Baz, "#include \"foo.h\"\n#define BAZ\nint c = foo();"),
+           WantDiagnostics::Yes);
+  ASSERT_TRUE(S.blockUntilIdle(timeoutSeconds(10)));
+  EXPECT_THAT(Built, UnorderedElementsAre(Foo, Baz));
+
+  auto GetPreamble = [&](PathRef File) {
+    const PreambleData *Result = nullptr;
+    S.runWithPreamble("GetPreamble", File, TUScheduler::Stale,
+                      [&](Expected<InputsAndPreamble> IP) {
+                        Result = cantFail(std::move(IP)).Preamble;
+                      });
+    EXPECT_TRUE(S.blockUntilIdle(timeoutSeconds(10)));
+    return Result;
+  };
+  // Bar has its own copy of the preamble, describing Bar.
+  const PreambleData *BarPreamble = GetPreamble(Bar);
+  EXPECT_EQ(GetPreamble(Foo)->Preamble, BarPreamble->Preamble);
+  EXPECT_NE(GetPreamble(Foo)->Preamble, GetPreamble(Baz)->Preamble);
+  EXPECT_EQ(BarPreamble->Version, "bar-1");
+  EXPECT_EQ(BarPreamble->CompileCommand.Filename, Bar);
+
+  S.runWithAST("CheckAST", Bar, [&](Expected<InputsAndAST> AST) {
+    EXPECT_THAT(*cantFail(std::move(AST)).AST.getDiagnostics(), IsEmpty());
+  });
+  ASSERT_TRUE(S.blockUntilIdle(timeoutSeconds(10)));
+
+  // The shared preamble outlives the file that built it.
+  S.remove(Foo);
+  S.update(Bar, getInputs(Bar, "#include \"foo.h\"\nint b = foo() + 1;"),
+           WantDiagnostics::Yes);
+  ASSERT_TRUE(S.blockUntilIdle(timeoutSeconds(10)));
+  EXPECT_THAT(Built, UnorderedElementsAre(Foo, Baz));
+
+  // The shared preamble is found, but foo.h changed, so Qux builds its own.
+  auto Qux = testPath("qux.cpp");
+  FS.Files[testPath("foo.h")] = "int foo(); int bar();";
+  S.update(Qux, getInputs(Qux, "#include \"foo.h\"\nint d = foo();"),
+           WantDiagnostics::Yes);
+  ASSERT_TRUE(S.blockUntilIdle(timeoutSeconds(10)));
+  EXPECT_THAT(Built, UnorderedElementsAre(Foo, Baz, Qux));
+  EXPECT_NE(GetPreamble(Bar)->Preamble, GetPreamble(Qux)->Preamble);
+}
+
 TEST_F(TUSchedulerTests, ASTSignalsSmokeTests) {
   TUScheduler S(CDB, optsForTest());
   auto Foo = testPath("foo.cpp");
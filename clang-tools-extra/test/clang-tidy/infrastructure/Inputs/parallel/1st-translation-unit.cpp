@@ -0,0 +1,5 @@
+#include "header.h"
+
+struct First {
+  First(int);
+};
@@ -0,0 +1,3 @@
+struct InHeader {
+  InHeader(int);
+};
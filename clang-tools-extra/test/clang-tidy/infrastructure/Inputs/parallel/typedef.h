@@ -0,0 +1 @@
+typedef int int_t;
@@ -0,0 +1,24 @@
+// RUN: clang-tidy -enable-matcher-profile -checks='-*,readability-function-size' %s -- 2>&1 | FileCheck --match-full-lines -implicit-check-not='{{warning:|error:}}' %s
+
+// CHECK: ===-------------------------------------------------------------------------===
+// CHECK-NEXT:                          clang-tidy checks profiling
+// CHECK-NEXT: ===-------------------------------------------------------------------------===
+// CHECK-NEXT: Total Execution Time: {{.*}} seconds ({{.*}} wall clock)
+
+// CHECK: {{.*}}  --- Name ---
+// CHECK-NEXT: {{.*}}  readability-function-size
+// CHECK-NEXT: {{.*}}  Total
+
+// CHECK: ===-------------------------------------------------------------------------===
+// CHECK-NEXT:                        clang-tidy matchers profiling
+// CHECK-NEXT: ===-------------------------------------------------------------------------===
+// CHECK-NEXT: Total Execution Time: {{.*}} seconds ({{.*}} wall clock)
+
+// CHECK: {{.*}}  --- Name ---
+// CHECK-NEXT: {{.*}}  readability-function-size.FunctionDecl.1 (2/2 matched)
+// CHECK-NEXT: {{.*}}  Total
+
+class A {
+  A() {}
+  ~A() {}
+};
@@ -0,0 +1,49 @@
+// A warning in a header included by both translation units is reported once.
+// RUN: clang-tidy -j2 %S/Inputs/parallel/1st-translation-unit.cpp %S/Inputs/parallel/2nd-translation-unit.cpp -checks='-*,google-explicit-constructor' -header-filter='.*' -- 2>&1 | FileCheck -implicit-check-not='{{warning:|error:}}' %s
+
+// Results are reused from the cache directory by a second run.
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: clang-tidy -j2 --cache-dir=%t/cache %S/Inputs/parallel/1st-translation-unit.cpp %S/Inputs/parallel/2nd-translation-unit.cpp -checks='-*,google-explicit-constructor' -header-filter='.*' -- 2> %t/cold.txt | FileCheck -implicit-check-not='{{warning:|error:}}' %s
+// RUN: FileCheck --check-prefix=CHECK-COLD --input-file=%t/cold.txt %s
+// RUN: clang-tidy -j2 --cache-dir=%t/cache %S/Inputs/parallel/1st-translation-unit.cpp %S/Inputs/parallel/2nd-translation-unit.cpp -checks='-*,google-explicit-constructor' -header-filter='.*' -- 2> %t/warm.txt | FileCheck -implicit-check-not='{{warning:|error:}}' %s
+// RUN: FileCheck --check-prefix=CHECK-WARM --input-file=%t/warm.txt %s
+
+// Changing a header that was read, or adding one that shadows it on the
+// include path, invalidates the cached results.
+// RUN: mkdir -p %t/deps/src %t/deps/shadow %t/deps/inc
+// RUN: cp %S/Inputs/parallel/1st-translation-unit.cpp %S/Inputs/parallel/2nd-translation-unit.cpp %t/deps/src
+// RUN: cp %S/Inputs/parallel/header.h %t/deps/inc
+// RUN: clang-tidy -j2 --cache-dir=%t/deps/cache %t/deps/src/1st-translation-unit.cpp %t/deps/src/2nd-translation-unit.cpp -checks='-*,google-explicit-constructor' -header-filter='.*' -- -I%t/deps/shadow -I%t/deps/inc 2> %t/deps/cold.txt
+// RUN: FileCheck --check-prefix=CHECK-COLD --input-file=%t/deps/cold.txt %s
+// RUN: echo 'struct Modified { Modified(int); };' > %t/deps/inc/header.h
+// RUN: clang-tidy -j2 --cache-dir=%t/deps/cache %t/deps/src/1st-translation-unit.cpp %t/deps/src/2nd-translation-unit.cpp -checks='-*,google-explicit-constructor' -header-filter='.*' -- -I%t/deps/shadow -I%t/deps/inc 2> %t/deps/modified.txt
+// RUN: FileCheck --check-prefix=CHECK-COLD --input-file=%t/deps/modified.txt %s
+// RUN: clang-tidy -j2 --cache-dir=%t/deps/cache %t/deps/src/1st-translation-unit.cpp %t/deps/src/2nd-translation-unit.cpp -checks='-*,google-explicit-constructor' -header-filter='.*' -- -I%t/deps/shadow -I%t/deps/inc 2> %t/deps/warm.txt
+// RUN: FileCheck --check-prefix=CHECK-WARM --input-file=%t/deps/warm.txt %s
+// RUN: cp %S/Inputs/parallel/header.h %t/deps/shadow
+// RUN: clang-tidy -j2 --cache-dir=%t/deps/cache %t/deps/src/1st-translation-unit.cpp %t/deps/src/2nd-translation-unit.cpp -checks='-*,google-explicit-constructor' -header-filter='.*' -- -I%t/deps/shadow -I%t/deps/inc 2> %t/deps/shadowed.txt
+// RUN: FileCheck --check-prefix=CHECK-COLD --input-file=%t/deps/shadowed.txt %s
+
+// Fixes from different translation units that overlap in a header are not
+// applied, as in a serial run.
+// RUN: mkdir -p %t/overlap/a %t/overlap/b
+// RUN: echo '#include "typedef.h"' > %t/overlap/a/tu.cpp
+// RUN: echo '#include "typedef.h"' > %t/overlap/b/tu.cpp
+// RUN: echo "Checks: '-*,modernize-use-using'" > %t/overlap/a/.clang-tidy
+// RUN: echo "Checks: '-*,readability-identifier-naming'" > %t/overlap/b/.clang-tidy
+// RUN: echo "CheckOptions:" >> %t/overlap/b/.clang-tidy
+// RUN: echo "  - key:             readability-identifier-naming.TypedefCase" >> %t/overlap/b/.clang-tidy
+// RUN: echo "    value:           CamelCase" >> %t/overlap/b/.clang-tidy
+// RUN: clang-tidy -j2 %t/overlap/a/tu.cpp %t/overlap/b/tu.cpp -header-filter='.*' -- -I%S/Inputs/parallel 2>&1 | FileCheck --check-prefix=CHECK-OVERLAP -implicit-check-not='{{warning:|error:}}' %s
+
+// CHECK: 1st-translation-unit.cpp:4:3: warning: single-argument constructors must be marked explicit
+// CHECK: 2nd-translation-unit.cpp:4:3: warning: single-argument constructors must be marked explicit
+// CHECK: header.h:2:3: warning: single-argument constructors must be marked explicit
+
+// CHECK-COLD: Reused cached results for 0 of 2 translation units.
+// CHECK-WARM: Reused cached results for 2 of 2 translation units.
+
+// CHECK-OVERLAP: typedef.h:1:1: warning: use 'using' instead of 'typedef' [modernize-use-using]
+// CHECK-OVERLAP: note: this fix will not be applied because it overlaps with another fix
+// CHECK-OVERLAP: typedef.h:1:13: warning: invalid case style for typedef 'int_t' [readability-identifier-naming]
+// CHECK-OVERLAP: note: this fix will not be applied because it overlaps with another fix
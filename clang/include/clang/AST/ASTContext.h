@@ -576,6 +576,10 @@ private:
   ImportDecl *FirstLocalImport = nullptr;
   ImportDecl *LastLocalImport = nullptr;
 
+  /// Incremented each time a declaration is added to a declaration context
+  /// or the definition of a tag type is completed.
+  unsigned DeclGeneration = 0;
+
   TranslationUnitDecl *TUDecl = nullptr;
   mutable ExternCContextDecl *ExternCContext = nullptr;
   mutable BuiltinTemplateDecl *MakeIntegerSeqDecl = nullptr;
@@ -1008,6 +1012,16 @@ public:
   /// parsed or implicitly created within this translation unit.
   void addedLocalImportDecl(ImportDecl *Import);
 
+  /// Get the current declaration generation. It changes whenever a
+  /// declaration is added to a declaration context or a tag type is
+  /// completed, i.e. whenever name lookup or a completeness check may give a
+  /// different answer than before.
+  unsigned getDeclGeneration() const { return DeclGeneration; }
+
+  /// Notify the AST context that a declaration was added to a declaration
+  /// context or that a tag type was completed.
+  void bumpDeclGeneration() { ++DeclGeneration; }
+
   static ImportDecl *getNextLocalImport(ImportDecl *Import) {
     return Import->getNextLocalImport();
   }
@@ -49,6 +49,17 @@ namespace clang {
 
 namespace ast_matchers {
 
+/// Time and match counts of a single top-level matcher, see
+/// MatchFinder::MatchFinderOptions::Profiling::MatcherRecords.
+struct MatcherProfileRecord {
+  /// Time spent matching, excluding the callbacks run on a match.
+  llvm::TimeRecord Time;
+  /// Number of nodes the matcher was tried on.
+  unsigned Invocations = 0;
+  /// Number of nodes the matcher matched.
+  unsigned Matches = 0;
+};
+
 /// A class to allow finding matches over the Clang AST.
 ///
 /// After creation, you can add multiple matchers to the MatchFinder via
@@ -132,6 +143,13 @@ public:
 
       /// Per bucket timing information.
       llvm::StringMap<llvm::TimeRecord> &Records;
+
+      using MatcherRecord = MatcherProfileRecord;
+
+      /// If set, also records information for each top-level matcher, keyed
+      /// by "<callback ID>.<node kind>.<N>", where N numbers the matchers of
+      /// the same kind registered by one callback in order.
+      llvm::StringMap<MatcherRecord> *MatcherRecords = nullptr;
     };
 
     /// Enables per-check timers.
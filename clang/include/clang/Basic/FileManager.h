@@ -299,6 +299,21 @@ public:
   std::error_code getNoncachedStatValue(StringRef Path,
                                         llvm::vfs::Status &Result);
 
+  /// Forget the files and directories looked up so far that no longer match
+  /// the file system, so that later lookups see its current state.
+  ///
+  /// Every file and directory that was found is stat'ed again. Files must
+  /// still have the same inode, size and modification time, compared with the
+  /// file system's full precision. Everything that was not found must still
+  /// be missing. Entries under one of \p SkippedDirs, such as a module cache
+  /// that compilations write to, are forgotten without being stat'ed, as are
+  /// virtual files. This lets clients that keep a file manager alive across
+  /// compilations reuse the entries that are still valid.
+  ///
+  /// \returns the number of entries that changed, not counting the skipped
+  /// ones.
+  unsigned dropStaleEntries(ArrayRef<std::string> SkippedDirs = std::nullopt);
+
   /// If path is not absolute and FileSystemOptions set the working
   /// directory, the path is modified to be relative to the given
   /// working directory.
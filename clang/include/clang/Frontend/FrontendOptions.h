@@ -283,6 +283,10 @@ public:
   /// Output time trace profile.
   unsigned TimeTrace : 1;
 
+  /// Output a summary of the time trace profile, with the total time spent in
+  /// each header, template and function.
+  unsigned TimeTraceSummary : 1;
+
   /// Show the -version text.
   unsigned ShowVersion : 1;
 
@@ -509,7 +513,8 @@ public:
 public:
   FrontendOptions()
       : DisableFree(false), RelocatablePCH(false), ShowHelp(false),
-        ShowStats(false), TimeTrace(false), ShowVersion(false),
+        ShowStats(false), TimeTrace(false), TimeTraceSummary(false),
+        ShowVersion(false),
         FixWhatYouCan(false), FixOnlyWarnings(false), FixAndRecompile(false),
         FixToTemporaries(false), ARCMTMigrateEmitARCErrors(false),
         SkipFunctionBodies(false), UseGlobalModuleIndex(true),
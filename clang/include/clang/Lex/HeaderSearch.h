@@ -319,6 +319,13 @@ class HeaderSearch {
   /// Describes whether a given directory has a module map in it.
   llvm::DenseMap<const DirectoryEntry *, bool> DirectoryHasModuleMap;
 
+  /// The lowercased names of the entries of each normal search directory,
+  /// listed on first use if HeaderSearchOptions::IndexSearchDirectories is
+  /// set. A null set means the directory couldn't be listed and has to be
+  /// probed for every header.
+  llvm::DenseMap<const DirectoryEntry *, std::unique_ptr<llvm::StringSet<>>>
+      SearchDirContents;
+
   /// Set of module map files we've already loaded, and a flag indicating
   /// whether they were valid or not.
   llvm::DenseMap<const FileEntry *, bool> LoadedModuleMaps;
@@ -879,6 +886,18 @@ public:
                                               llvm::StringRef MainFile,
                                               bool *IsSystem = nullptr);
 
+  /// Determine whether \p Filename may exist relative to the search
+  /// directory \p Dir, according to the listing of that directory.
+  ///
+  /// The listing is read the first time \p Dir is queried and is not
+  /// refreshed afterwards.
+  ///
+  /// \returns false only if the search directory index is enabled and the
+  /// first component of \p Filename is not an entry of \p Dir. This is a
+  /// conservative, case-insensitive check; the caller still has to look the
+  /// file up when this returns true.
+  bool mayContainFile(DirectoryEntryRef Dir, StringRef Filename);
+
   void PrintStats();
 
   size_t getTotalMemory() const;
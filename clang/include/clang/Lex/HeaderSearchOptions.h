@@ -218,6 +218,15 @@ public:
 
   unsigned ModulesHashContent : 1;
 
+  /// Whether AST files should be written so that identical inputs produce
+  /// byte-identical outputs: no modification times are recorded, the content
+  /// of every input file is hashed, and a content signature is embedded even
+  /// in precompiled headers. Importers then validate the AST file against the
+  /// signature rather than its size and modification time. When importing
+  /// with -fvalidate-ast-input-files-content, input files recorded without a
+  /// modification time are checked against their content hash.
+  unsigned DeterministicASTOutput : 1;
+
   /// Whether we should include all things that could impact the module in the
   /// hash.
   ///
@@ -225,6 +234,25 @@ public:
   /// diagnostics.
   unsigned ModulesStrictContextHash : 1;
 
+  /// Whether to list the contents of each search directory once and consult
+  /// that listing before probing the directory for a header.
+  ///
+  /// This avoids a failing stat() per search directory for every header that
+  /// isn't found in it, but assumes that the search directories don't change
+  /// during the compilation and that no header has been remapped into a
+  /// search directory without being present on disk.
+  unsigned IndexSearchDirectories : 1;
+
+  /// Whether to read the module files imported by a module concurrently
+  /// before loading them one by one. Requires a thread-safe virtual file
+  /// system.
+  unsigned ModulesPrefetchImports : 1;
+
+  /// Whether explicitly built and prebuilt module files may be memory mapped
+  /// instead of read in full. The build system must guarantee that these
+  /// files are not modified or replaced while the compiler is running.
+  unsigned ModulesMapExplicitFiles : 1;
+
   HeaderSearchOptions(StringRef _Sysroot = "/")
       : Sysroot(_Sysroot), ModuleFormat("raw"), DisableModuleHash(false),
         ImplicitModuleMaps(false), ModuleMapFileHomeIsCwd(false),
@@ -235,7 +263,9 @@ public:
         ModulesValidateSystemHeaders(false),
         ValidateASTInputFilesContent(false), UseDebugInfo(false),
         ModulesValidateDiagnosticOptions(true), ModulesHashContent(false),
-        ModulesStrictContextHash(false) {}
+        DeterministicASTOutput(false), ModulesStrictContextHash(false),
+        IndexSearchDirectories(false), ModulesPrefetchImports(false),
+        ModulesMapExplicitFiles(false) {}
 
   /// AddPath - Add the \p Path path to the specified \p Group list.
   void AddPath(StringRef Path, frontend::IncludeDirGroup Group,
@@ -1448,6 +1448,10 @@ public:
   /// The number of SFINAE diagnostics that have been trapped.
   unsigned NumSFINAEErrors;
 
+  /// The number of function template substitutions that were found to fail
+  /// in SubstitutionFailureCache instead of being performed again.
+  unsigned NumSubstitutionFailureCacheHits;
+
   typedef llvm::DenseMap<ParmVarDecl *, llvm::TinyPtrVector<ParmVarDecl *>>
     UnparsedDefaultArgInstantiationsMap;
 
@@ -9404,6 +9408,39 @@ public:
     SuppressedDiagnosticsMap;
   SuppressedDiagnosticsMap SuppressedDiagnostics;
 
+  /// A substitution of deduced template arguments into the declaration of a
+  /// function template that failed, and the diagnostic explaining why.
+  struct CachedSubstitutionFailure : llvm::FoldingSetNode {
+    llvm::FoldingSetNodeID Key;
+    Optional<PartialDiagnosticAt> Diag;
+    /// The declaration and module visibility generations at which the
+    /// substitution failed. The failure is only reused while both are
+    /// unchanged.
+    unsigned DeclGeneration = 0;
+    unsigned VisibleModulesGeneration = 0;
+
+    void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddNodeID(Key); }
+
+    static void Profile(llvm::FoldingSetNodeID &ID, const ASTContext &C,
+                        const FunctionTemplateDecl *Template,
+                        ArrayRef<TemplateArgument> Args);
+  };
+
+  /// Failed substitutions into function template declarations, keyed by the
+  /// canonical template and its canonical deduced arguments.
+  ///
+  /// Overload resolution in heavily templated code considers the same
+  /// SFINAE'd candidate with the same deduced arguments over and over again,
+  /// so the failure is remembered instead of substituting again. A later
+  /// attempt can succeed once a type used in the declaration is completed or
+  /// another overload becomes visible, so an entry is only used while no
+  /// declaration has been added, no tag type has been completed and no module
+  /// has been made visible since the failure; see
+  /// ASTContext::getDeclGeneration().
+  ///
+  /// Note that entries are deleted in Sema's destructor.
+  llvm::FoldingSet<CachedSubstitutionFailure> SubstitutionFailureCache;
+
   /// A stack object to be created when performing template
   /// instantiation.
   ///
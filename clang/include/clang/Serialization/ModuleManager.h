@@ -23,6 +23,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/ADT/iterator_range.h"
@@ -78,6 +79,15 @@ class ModuleManager {
   llvm::DenseMap<const FileEntry *, std::unique_ptr<llvm::MemoryBuffer>>
       InMemoryBuffers;
 
+  /// Contents of module files read ahead of time by prefetchModuleFiles(),
+  /// keyed by the file name that will be passed to addModule().
+  llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> PrefetchedBuffers;
+
+  /// The number of module files read by prefetchModuleFiles(), and how many
+  /// of those were then consumed by addModule().
+  unsigned NumPrefetchedModuleFiles = 0;
+  unsigned NumPrefetchedModuleFilesUsed = 0;
+
   /// The visitation order.
   SmallVector<ModuleFile *, 4> VisitOrder;
 
@@ -251,6 +261,32 @@ public:
   /// Remove the modules starting from First (to the end).
   void removeModules(ModuleIterator First);
 
+  /// Read the contents of the given module files concurrently, so that the
+  /// following calls to addModule() for them don't wait on the file system
+  /// one file at a time.
+  ///
+  /// Files that are already loaded or cached, and files of kinds that are
+  /// memory mapped rather than read, are skipped. This only has an effect if
+  /// HeaderSearchOptions::ModulesPrefetchImports is set, since it requires the
+  /// virtual file system to be safe to use from several threads.
+  void prefetchModuleFiles(
+      ArrayRef<std::pair<std::string, ModuleKind>> FileNamesAndKinds);
+
+  /// Drop the prefetched contents of the given module files that haven't
+  /// been consumed by addModule().
+  void discardPrefetchedModuleFiles(
+      ArrayRef<std::pair<std::string, ModuleKind>> FileNamesAndKinds);
+
+  /// The number of module files read by prefetchModuleFiles().
+  unsigned getNumPrefetchedModuleFiles() const {
+    return NumPrefetchedModuleFiles;
+  }
+
+  /// The number of prefetched module files that were then loaded.
+  unsigned getNumPrefetchedModuleFilesUsed() const {
+    return NumPrefetchedModuleFilesUsed;
+  }
+
   /// Add an in-memory buffer the list of known buffers
   void addInMemoryBuffer(StringRef FileName,
                          std::unique_ptr<llvm::MemoryBuffer> Buffer);
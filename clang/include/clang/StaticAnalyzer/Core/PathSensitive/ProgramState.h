@@ -168,7 +168,9 @@ public:
 
   /// Profile - Profile the contents of a ProgramState object for use in a
   ///  FoldingSet.  Two ProgramState objects are considered equal if they
-  ///  have the same Environment, Store, and GenericDataMap.
+  ///  have the same Environment, Store, and GenericDataMap.  These maps are
+  ///  canonicalized by their factories, so profiling their roots by address
+  ///  is enough and their trees are never compared element by element.
   static void Profile(llvm::FoldingSetNodeID& ID, const ProgramState *V) {
     V->Env.Profile(ID);
     ID.AddPointer(V->store);
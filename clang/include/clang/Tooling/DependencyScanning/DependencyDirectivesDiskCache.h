@@ -0,0 +1,71 @@
+//===- DependencyDirectivesDiskCache.h - Persistent directives --*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLING_DEPENDENCYSCANNING_DEPENDENCYDIRECTIVESDISKCACHE_H
+#define LLVM_CLANG_TOOLING_DEPENDENCYSCANNING_DEPENDENCYDIRECTIVESDISKCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Lex/DependencyDirectivesScanner.h"
+#include <string>
+
+namespace clang {
+namespace tooling {
+namespace dependencies {
+
+/// An on-disk store of scanned preprocessor directive tokens that outlives a
+/// single dependency scanning service.
+///
+/// Entries are keyed by a BLAKE3 hash of the original file contents rather
+/// than by path, modification time or inode, so an entry can never be returned
+/// for a file whose contents changed, and identical files (e.g. copies of the
+/// same header in several checkouts) share one entry. Every entry additionally
+/// records the size of the source it was produced from and is rejected if any
+/// token falls outside of the source buffer.
+///
+/// This class is thread safe. Entries are written to a temporary file and then
+/// atomically renamed into place, so several processes may share one cache
+/// directory. Failures to read or write the cache are never fatal; the scanner
+/// falls back to scanning the file.
+class DependencyDirectivesDiskCache {
+public:
+  /// Creates a cache rooted at \p CachePath. The directory is created lazily
+  /// when the first entry is stored.
+  explicit DependencyDirectivesDiskCache(StringRef CachePath)
+      : CachePath(CachePath) {}
+
+  StringRef getPath() const { return CachePath; }
+
+  /// Looks up the directives previously stored for \p Source.
+  ///
+  /// On success, fills \p Tokens and then \p Directives, whose token arrays
+  /// refer into \p Tokens. \p Tokens must therefore not be modified after this
+  /// call while \p Directives is in use.
+  ///
+  /// \returns true if a valid entry was found.
+  bool lookup(StringRef Source,
+              SmallVectorImpl<dependency_directives_scan::Token> &Tokens,
+              SmallVectorImpl<dependency_directives_scan::Directive> &Directives)
+      const;
+
+  /// Stores the directives scanned from \p Source. Any error is ignored.
+  void store(StringRef Source,
+             ArrayRef<dependency_directives_scan::Token> Tokens,
+             ArrayRef<dependency_directives_scan::Directive> Directives) const;
+
+private:
+  /// Computes the path of the entry for \p Source.
+  void getEntryPath(StringRef Source, SmallVectorImpl<char> &Path) const;
+
+  std::string CachePath;
+};
+
+} // end namespace dependencies
+} // end namespace tooling
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLING_DEPENDENCYSCANNING_DEPENDENCYDIRECTIVESDISKCACHE_H
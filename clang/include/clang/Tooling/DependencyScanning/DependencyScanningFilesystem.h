@@ -22,6 +22,8 @@ namespace clang {
 namespace tooling {
 namespace dependencies {
 
+class DependencyDirectivesDiskCache;
+
 using DependencyDirectivesTy =
     SmallVector<dependency_directives_scan::Directive, 20>;
 
@@ -195,15 +197,39 @@ public:
                                 const CachedFileSystemEntry &Entry);
   };
 
-  DependencyScanningFilesystemSharedCache();
+  /// Creates the shared cache. If \p DiskCache is non-null, scanned
+  /// directives are additionally looked up in and written to it, so that they
+  /// survive the lifetime of this cache.
+  DependencyScanningFilesystemSharedCache(
+      const DependencyDirectivesDiskCache *DiskCache = nullptr);
 
   /// Returns shard for the given key.
   CacheShard &getShardForFilename(StringRef Filename) const;
   CacheShard &getShardForUID(llvm::sys::fs::UniqueID UID) const;
 
+  /// Re-stats every filename in the cache through \p UnderlyingFS and drops
+  /// the entries of the ones that now refer to a different file, changed
+  /// their modification time or size, or started or stopped existing. A file
+  /// is dropped under all of its names, so the next lookup reads it again.
+  ///
+  /// Entries are handed out by reference and kept in the local caches of the
+  /// worker filesystems. Long-lived clients should call this only while no
+  /// worker is running, and must not reuse the existing workers if any entry
+  /// was dropped. The dropped entries are only freed with the cache.
+  ///
+  /// \returns the number of filenames whose entries were dropped.
+  unsigned invalidateOutOfDateEntries(llvm::vfs::FileSystem &UnderlyingFS);
+
+  /// Returns the persistent directives cache or nullptr if there is none.
+  const DependencyDirectivesDiskCache *getDiskCache() const {
+    return DiskCache;
+  }
+
 private:
   std::unique_ptr<CacheShard[]> CacheShards;
   unsigned NumShards;
+  /// Non-owning pointer to the persistent directives cache.
+  const DependencyDirectivesDiskCache *DiskCache;
 };
 
 /// This class is a local cache, that caches the 'stat' and 'open' calls to the
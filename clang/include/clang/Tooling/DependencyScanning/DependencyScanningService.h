@@ -9,6 +9,7 @@
 #ifndef LLVM_CLANG_TOOLING_DEPENDENCYSCANNING_DEPENDENCYSCANNINGSERVICE_H
 #define LLVM_CLANG_TOOLING_DEPENDENCYSCANNING_DEPENDENCYSCANNINGSERVICE_H
 
+#include "clang/Tooling/DependencyScanning/DependencyDirectivesDiskCache.h"
 #include "clang/Tooling/DependencyScanning/DependencyScanningFilesystem.h"
 
 namespace clang {
@@ -46,7 +47,8 @@ class DependencyScanningService {
 public:
   DependencyScanningService(ScanningMode Mode, ScanningOutputFormat Format,
                             bool OptimizeArgs = false,
-                            bool EagerLoadModules = false);
+                            bool EagerLoadModules = false,
+                            StringRef DirectivesCachePath = StringRef());
 
   ScanningMode getMode() const { return Mode; }
 
@@ -67,6 +69,9 @@ private:
   const bool OptimizeArgs;
   /// Whether to set up command-lines to load PCM files eagerly.
   const bool EagerLoadModules;
+  /// The persistent cache of scanned directives, if enabled. Must be declared
+  /// before \c SharedCache which refers to it.
+  std::unique_ptr<DependencyDirectivesDiskCache> DirectivesDiskCache;
   /// The global file system cache.
   DependencyScanningFilesystemSharedCache SharedCache;
 };
@@ -4441,6 +4441,7 @@ void TagDecl::completeDefinition() {
 
   setCompleteDefinition(true);
   setBeingDefined(false);
+  getASTContext().bumpDeclGeneration();
 
   if (ASTMutationListener *L = getASTMutationListener())
     L->CompletedTagDefinition(this);
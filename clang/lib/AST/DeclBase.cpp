@@ -1590,6 +1590,7 @@ void DeclContext::addHiddenDecl(Decl *D) {
   } else {
     FirstDecl = LastDecl = D;
   }
+  D->getASTContext().bumpDeclGeneration();
 
   // Notify a C++ record declaration that we've added a member, so it can
   // update its class-specific state.
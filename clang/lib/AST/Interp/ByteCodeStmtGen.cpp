@@ -14,6 +14,7 @@
 #include "PrimType.h"
 #include "Program.h"
 #include "State.h"
+#include "clang/AST/StmtCXX.h"
 #include "clang/Basic/LLVM.h"
 
 using namespace clang;
@@ -178,10 +179,20 @@ bool ByteCodeStmtGen<Emitter>::visitStmt(const Stmt *S) {
     return visitDoStmt(cast<DoStmt>(S));
   case Stmt::ForStmtClass:
     return visitForStmt(cast<ForStmt>(S));
+  case Stmt::CXXForRangeStmtClass:
+    return visitCXXForRangeStmt(cast<CXXForRangeStmt>(S));
   case Stmt::BreakStmtClass:
     return visitBreakStmt(cast<BreakStmt>(S));
   case Stmt::ContinueStmtClass:
     return visitContinueStmt(cast<ContinueStmt>(S));
+  case Stmt::SwitchStmtClass:
+    return visitSwitchStmt(cast<SwitchStmt>(S));
+  case Stmt::CaseStmtClass:
+    return visitCaseStmt(cast<CaseStmt>(S));
+  case Stmt::DefaultStmtClass:
+    return visitDefaultStmt(cast<DefaultStmt>(S));
+  case Stmt::AttributedStmtClass:
+    return visitStmt(cast<AttributedStmt>(S)->getSubStmt());
   case Stmt::NullStmtClass:
     return true;
   default: {
@@ -375,6 +386,50 @@ bool ByteCodeStmtGen<Emitter>::visitForStmt(const ForStmt *S) {
   return true;
 }
 
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitCXXForRangeStmt(const CXXForRangeStmt *S) {
+  // for (Init; LoopVar : Range) { Body } is compiled as
+  // { Init; Range; Begin; End; for (; Cond; Inc) { LoopVar; Body } }
+  const Stmt *Init = S->getInit();
+  const Expr *Cond = S->getCond();
+  const Expr *Inc = S->getInc();
+  const Stmt *Body = S->getBody();
+  const VarDecl *LoopVar = S->getLoopVariable();
+
+  LabelTy EndLabel = this->getLabel();
+  LabelTy CondLabel = this->getLabel();
+  LabelTy IncLabel = this->getLabel();
+  BlockScope<Emitter> Scope(this);
+  LoopScope<Emitter> LS(this, EndLabel, IncLabel);
+
+  if (Init && !this->visitStmt(Init))
+    return false;
+  if (!this->visitStmt(S->getRangeStmt()))
+    return false;
+  if (!this->visitStmt(S->getBeginStmt()))
+    return false;
+  if (!this->visitStmt(S->getEndStmt()))
+    return false;
+
+  this->emitLabel(CondLabel);
+  if (!this->visitBool(Cond))
+    return false;
+  if (!this->jumpFalse(EndLabel))
+    return false;
+
+  if (!this->visitVarDecl(LoopVar))
+    return false;
+  if (!this->visitStmt(Body))
+    return false;
+  this->emitLabel(IncLabel);
+  if (!this->discard(Inc))
+    return false;
+  if (!this->jump(CondLabel))
+    return false;
+  this->emitLabel(EndLabel);
+  return true;
+}
+
 template <class Emitter>
 bool ByteCodeStmtGen<Emitter>::visitBreakStmt(const BreakStmt *S) {
   if (!BreakLabel)
@@ -391,6 +446,90 @@ bool ByteCodeStmtGen<Emitter>::visitContinueStmt(const ContinueStmt *S) {
   return this->jump(*ContinueLabel);
 }
 
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitSwitchStmt(const SwitchStmt *S) {
+  const Expr *Cond = S->getCond();
+  std::optional<PrimType> CondT = this->classify(Cond->getType());
+  if (!CondT)
+    return this->bail(S);
+
+  LabelTy EndLabel = this->getLabel();
+  OptLabelTy DefaultLabel = std::nullopt;
+  BlockScope<Emitter> Scope(this);
+
+  if (const Stmt *CondInit = S->getInit())
+    if (!visitStmt(CondInit))
+      return false;
+
+  if (const DeclStmt *CondDecl = S->getConditionVariableDeclStmt())
+    if (!visitDeclStmt(CondDecl))
+      return false;
+
+  // Evaluate the condition once and keep it in a local.
+  unsigned CondVar =
+      this->allocateLocalPrimitive(Cond, *CondT, /*IsConst=*/true);
+  if (!this->visit(Cond))
+    return false;
+  if (!this->emitSetLocal(*CondT, CondVar, S))
+    return false;
+
+  // Compare the condition against every case value in turn and jump to the
+  // first one that matches.
+  CaseMap CaseLabels;
+  for (const SwitchCase *SC = S->getSwitchCaseList(); SC;
+       SC = SC->getNextSwitchCase()) {
+    if (isa<DefaultStmt>(SC)) {
+      DefaultLabel = this->getLabel();
+      continue;
+    }
+
+    const auto *CS = cast<CaseStmt>(SC);
+    // FIXME: Support GNU case ranges.
+    if (CS->caseStmtIsGNURange())
+      return this->bail(CS);
+
+    LabelTy CaseLabel = this->getLabel();
+    CaseLabels[CS] = CaseLabel;
+    if (!this->emitGetLocal(*CondT, CondVar, CS))
+      return false;
+    if (!this->visit(CS->getLHS()))
+      return false;
+    if (!this->emitEQ(*CondT, CS))
+      return false;
+    if (!this->jumpTrue(CaseLabel))
+      return false;
+  }
+
+  // No case matched; go to the default statement, if any.
+  if (!this->jump(DefaultLabel ? *DefaultLabel : EndLabel))
+    return false;
+
+  SwitchScope<Emitter> SS(this, std::move(CaseLabels), EndLabel, DefaultLabel);
+  if (!visitStmt(S->getBody()))
+    return false;
+  this->emitLabel(EndLabel);
+  return true;
+}
+
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitCaseStmt(const CaseStmt *S) {
+  auto It = CaseLabels.find(S);
+  if (It == CaseLabels.end())
+    return this->bail(S);
+
+  this->emitLabel(It->second);
+  return visitStmt(S->getSubStmt());
+}
+
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitDefaultStmt(const DefaultStmt *S) {
+  if (!DefaultLabel)
+    return this->bail(S);
+
+  this->emitLabel(*DefaultLabel);
+  return visitStmt(S->getSubStmt());
+}
+
 template <class Emitter>
 bool ByteCodeStmtGen<Emitter>::visitVarDecl(const VarDecl *VD) {
   if (!VD->hasLocalStorage()) {
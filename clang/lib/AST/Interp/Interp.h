@@ -311,7 +311,7 @@ bool IncDecHelper(InterpState &S, CodePtr OpPC, const Pointer &Ptr) {
   T Result;
 
   if constexpr (DoPush == PushVal::Yes)
-    S.Stk.push<T>(Result);
+    S.Stk.push<T>(Value);
 
   if constexpr (Op == IncDecOp::Inc) {
     if (!T::increment(Value, &Result)) {
@@ -1094,6 +1094,38 @@ inline bool SubPtr(InterpState &S, CodePtr OpPC) {
   return AddSubMulHelper<T, T::sub, std::minus>(S, OpPC, A.bitWidth(), A, B);
 }
 
+template <bool Add> bool IncDecPtrHelper(InterpState &S, CodePtr OpPC) {
+  using OneT = Integral<32, false>;
+  const Pointer &Ptr = S.Stk.pop<Pointer>();
+  if (!CheckLoad(S, OpPC, Ptr) || !CheckStore(S, OpPC, Ptr))
+    return false;
+
+  // Push the original value, then compute the new one from it.
+  const Pointer Value = Ptr.deref<Pointer>();
+  S.Stk.push<Pointer>(Value);
+  S.Stk.push<Pointer>(Value);
+  S.Stk.push<OneT>(OneT::from(1));
+  if (!OffsetHelper<OneT, Add>(S, OpPC))
+    return false;
+
+  Ptr.deref<Pointer>() = S.Stk.pop<Pointer>();
+  return true;
+}
+
+/// 1) Pops a pointer to a pointer from the stack.
+/// 2) Advances the pointed-to pointer by one element.
+/// 3) Pushes the original (pre-inc) value on the stack.
+inline bool IncPtr(InterpState &S, CodePtr OpPC) {
+  return IncDecPtrHelper<true>(S, OpPC);
+}
+
+/// 1) Pops a pointer to a pointer from the stack.
+/// 2) Moves the pointed-to pointer back by one element.
+/// 3) Pushes the original (pre-dec) value on the stack.
+inline bool DecPtr(InterpState &S, CodePtr OpPC) {
+  return IncDecPtrHelper<false>(S, OpPC);
+}
+
 //===----------------------------------------------------------------------===//
 // Destroy
 //===----------------------------------------------------------------------===//
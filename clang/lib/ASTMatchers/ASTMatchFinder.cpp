@@ -20,6 +20,7 @@
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Timer.h"
@@ -420,11 +421,16 @@ class MatchASTVisitor : public RecursiveASTVisitor<MatchASTVisitor>,
 public:
   MatchASTVisitor(const MatchFinder::MatchersByType *Matchers,
                   const MatchFinder::MatchFinderOptions &Options)
-      : Matchers(Matchers), Options(Options), ActiveASTContext(nullptr) {}
+      : Matchers(Matchers), Options(Options), ActiveASTContext(nullptr) {
+    if (Options.CheckProfiling && Options.CheckProfiling->MatcherRecords)
+      initMatcherRecords();
+  }
 
   ~MatchASTVisitor() override {
     if (Options.CheckProfiling) {
       Options.CheckProfiling->Records = std::move(TimeByBucket);
+      if (Options.CheckProfiling->MatcherRecords)
+        *Options.CheckProfiling->MatcherRecords = std::move(MatcherRecords);
     }
   }
 
@@ -1005,30 +1011,89 @@ private:
     llvm::TimeRecord *Bucket;
   };
 
-  /// Runs all the \p Matchers on \p Node.
-  ///
-  /// Used by \c matchDispatch() below.
-  template <typename T, typename MC>
-  void matchWithoutFilter(const T &Node, const MC &Matchers) {
+  /// Assigns a record to every top-level matcher for per-matcher profiling.
+  void initMatcherRecords() {
+    llvm::StringMap<unsigned> CountByPrefix;
+    auto AddRecords = [&](const auto &List) {
+      for (const auto &MP : List) {
+        DynTypedMatcher M = MP.first;
+        std::string Prefix =
+            (MP.second->getID() + "." + M.getID().first.asStringRef()).str();
+        unsigned N = ++CountByPrefix[Prefix];
+        RecordByMatcher[&MP] =
+            &MatcherRecords[(Prefix + "." + llvm::Twine(N)).str()];
+      }
+    };
+    AddRecords(Matchers->DeclOrStmt);
+    AddRecords(Matchers->Type);
+    AddRecords(Matchers->NestedNameSpecifier);
+    AddRecords(Matchers->NestedNameSpecifierLoc);
+    AddRecords(Matchers->TypeLoc);
+    AddRecords(Matchers->CtorInit);
+    AddRecords(Matchers->TemplateArgumentLoc);
+    AddRecords(Matchers->Attr);
+  }
+
+  /// Runs the matcher of \p MP on \p Node, recording its cost if per-matcher
+  /// profiling is enabled.
+  template <typename T, typename MP>
+  bool matchProfiled(const MP &Matcher, const T &Node,
+                     BoundNodesTreeBuilder *Builder) {
+    if (RecordByMatcher.empty())
+      return Matcher.first.matches(Node, this, Builder);
+    MatchFinder::MatchFinderOptions::Profiling::MatcherRecord *Record =
+        RecordByMatcher.lookup(&Matcher);
+    Record->Time -= llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+    bool Result = Matcher.first.matches(Node, this, Builder);
+    Record->Time += llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+    ++Record->Invocations;
+    if (Result)
+      ++Record->Matches;
+    return Result;
+  }
+
+  /// Runs the \p Matchers selected by \p Filter on \p Node.
+  template <typename T, typename MC, typename IndexRange>
+  void matchSelected(const T &Node, const MC &Matchers,
+                     const IndexRange &Filter) {
     const bool EnableCheckProfiling = Options.CheckProfiling.has_value();
     TimeBucketRegion Timer;
-    for (const auto &MP : Matchers) {
+    for (auto I : Filter) {
+      const auto &MP = Matchers[I];
       if (EnableCheckProfiling)
         Timer.setBucket(&TimeByBucket[MP.second->getID()]);
       BoundNodesTreeBuilder Builder;
       CurMatchRAII RAII(*this, MP.second, Node);
-      if (MP.first.matches(Node, this, &Builder)) {
+      if (matchProfiled(MP, Node, &Builder)) {
         MatchVisitor Visitor(*this, ActiveASTContext, MP.second);
         Builder.visitMatches(&Visitor);
       }
     }
   }
 
+  /// Runs all the \p Matchers on \p Node.
+  ///
+  /// Used by \c matchDispatch() below.
+  template <typename T, typename MC>
+  void matchWithoutFilter(const T &Node, const MC &Matchers) {
+    matchSelected(Node, Matchers, llvm::seq<size_t>(0, Matchers.size()));
+  }
+
+  /// Runs the \p Matchers that can match the dynamic kind of \p Node.
+  ///
+  /// Used by \c matchDispatch() for node types other than \c Decl and
+  /// \c Stmt whose matchers are commonly restricted to a derived kind.
+  template <typename T, typename MC>
+  void matchWithKindFilter(const T &Node, const MC &Matchers) {
+    const auto &Filter =
+        getFilterForKind(ASTNodeKind::getFromNode(Node), Matchers);
+    if (!Filter.empty())
+      matchSelected(Node, Matchers, Filter);
+  }
+
   void matchWithFilter(const DynTypedNode &DynNode) {
-    auto Kind = DynNode.getNodeKind();
-    auto it = MatcherFiltersMap.find(Kind);
     const auto &Filter =
-        it != MatcherFiltersMap.end() ? it->second : getFilterForKind(Kind);
+        getFilterForKind(DynNode.getNodeKind(), this->Matchers->DeclOrStmt);
 
     if (Filter.empty())
       return;
@@ -1050,19 +1115,27 @@ private:
       }
 
       CurMatchRAII RAII(*this, MP.second, DynNode);
-      if (MP.first.matches(DynNode, this, &Builder)) {
+      if (matchProfiled(MP, DynNode, &Builder)) {
         MatchVisitor Visitor(*this, ActiveASTContext, MP.second);
         Builder.visitMatches(&Visitor);
       }
     }
   }
 
-  const std::vector<unsigned short> &getFilterForKind(ASTNodeKind Kind) {
+  /// Returns the indices of the \p Matchers that can match nodes of \p Kind.
+  ///
+  /// \p Matchers must be the list that holds matchers for \p Kind; the node
+  /// kinds of the different lists are disjoint, so they share one map.
+  template <typename MC>
+  const std::vector<unsigned short> &getFilterForKind(ASTNodeKind Kind,
+                                                      const MC &Matchers) {
+    auto It = MatcherFiltersMap.find(Kind);
+    if (It != MatcherFiltersMap.end())
+      return It->second;
     auto &Filter = MatcherFiltersMap[Kind];
-    auto &Matchers = this->Matchers->DeclOrStmt;
     assert((Matchers.size() < USHRT_MAX) && "Too many matchers.");
     for (unsigned I = 0, E = Matchers.size(); I != E; ++I) {
-      if (Matchers[I].first.canMatchNodesOfKind(Kind)) {
+      if (DynTypedMatcher(Matchers[I].first).canMatchNodesOfKind(Kind)) {
         Filter.push_back(I);
       }
     }
@@ -1082,7 +1155,7 @@ private:
     matchWithoutFilter(QualType(Node, 0), Matchers->Type);
   }
   void matchDispatch(const TypeLoc *Node) {
-    matchWithoutFilter(*Node, Matchers->TypeLoc);
+    matchWithKindFilter(*Node, Matchers->TypeLoc);
   }
   void matchDispatch(const QualType *Node) {
     matchWithoutFilter(*Node, Matchers->Type);
@@ -1100,7 +1173,7 @@ private:
     matchWithoutFilter(*Node, Matchers->TemplateArgumentLoc);
   }
   void matchDispatch(const Attr *Node) {
-    matchWithoutFilter(*Node, Matchers->Attr);
+    matchWithKindFilter(*Node, Matchers->Attr);
   }
   void matchDispatch(const void *) { /* Do nothing. */ }
   /// @}
@@ -1315,8 +1388,17 @@ private:
   /// kind (and derived kinds) so it is a waste to try every matcher on every
   /// node.
   /// We precalculate a list of matchers that pass the toplevel restrict check.
+  /// The same is done for \c TypeLoc and \c Attr matchers.
   llvm::DenseMap<ASTNodeKind, std::vector<unsigned short>> MatcherFiltersMap;
 
+  /// Per-matcher profiling records, if requested.
+  llvm::StringMap<MatchFinder::MatchFinderOptions::Profiling::MatcherRecord>
+      MatcherRecords;
+  /// Maps an element of one of the \c MatchersByType lists to its record.
+  llvm::DenseMap<const void *,
+                 MatchFinder::MatchFinderOptions::Profiling::MatcherRecord *>
+      RecordByMatcher;
+
   const MatchFinder::MatchFinderOptions &Options;
   ASTContext *ActiveASTContext;
 
@@ -19,6 +19,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/FileSystemStatCache.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Config/llvm-config.h"
@@ -352,6 +353,7 @@ FileManager::getFileRef(StringRef Filename, bool openFile, bool CacheFailure) {
   UFE->LastRef = ReturnedRef;
   UFE->Size = Status.getSize();
   UFE->ModTime = llvm::sys::toTimeT(Status.getLastModificationTime());
+  UFE->PreciseModTime = Status.getLastModificationTime();
   UFE->Dir = &DirInfo.getDirEntry();
   UFE->UID = NextFileUID++;
   UFE->UniqueID = Status.getUniqueID();
@@ -465,6 +467,7 @@ FileEntryRef FileManager::getVirtualFileRef(StringRef Filename, off_t Size,
   UFE->LastRef = FileEntryRef(NamedFileEnt);
   UFE->Size    = Size;
   UFE->ModTime = ModificationTime;
+  UFE->PreciseModTime = llvm::sys::toTimePoint(ModificationTime);
   UFE->Dir     = &DirInfo->getDirEntry();
   UFE->UID     = NextFileUID++;
   UFE->File.reset();
@@ -495,6 +498,7 @@ OptionalFileEntryRef FileManager::getBypassFile(FileEntryRef VF) {
   BFE->Size = Status.getSize();
   BFE->Dir = VF.getFileEntry().Dir;
   BFE->ModTime = llvm::sys::toTimeT(Status.getLastModificationTime());
+  BFE->PreciseModTime = Status.getLastModificationTime();
   BFE->UID = NextFileUID++;
 
   // Save the entry in the bypass table and return.
@@ -611,6 +615,104 @@ FileManager::getNoncachedStatValue(StringRef Path,
   return std::error_code();
 }
 
+/// Whether \p Path is \p Dir or inside it.
+static bool isInDirectory(StringRef Path, StringRef Dir) {
+  if (!Path.consume_front(Dir))
+    return false;
+  return Path.empty() || llvm::sys::path::is_separator(Path.front()) ||
+         (!Dir.empty() && llvm::sys::path::is_separator(Dir.back()));
+}
+
+unsigned FileManager::dropStaleEntries(ArrayRef<std::string> SkippedDirs) {
+  auto IsSkipped = [&](StringRef Path) {
+    return llvm::any_of(SkippedDirs, [&](const std::string &Dir) {
+      return isInDirectory(Path, Dir);
+    });
+  };
+  unsigned NumStale = 0;
+
+  // Bypass entries refer to directory entries that may be dropped below.
+  SeenBypassFileEntries.reset();
+
+  llvm::SmallPtrSet<const DirectoryEntryRef::MapEntry *, 8> DroppedDirs;
+  std::vector<std::string> DirsToDrop;
+  for (const auto &Entry : SeenDirEntries) {
+    if (!IsSkipped(Entry.getKey())) {
+      llvm::vfs::Status Status;
+      std::error_code EC = getNoncachedStatValue(Entry.getKey(), Status);
+      if (bool(Entry.getValue()) == (!EC && Status.isDirectory()))
+        continue;
+      ++NumStale;
+    }
+    DroppedDirs.insert(&Entry);
+    DirsToDrop.push_back(Entry.getKey().str());
+  }
+
+  // A file is dropped under all of its names, so that nothing refers to its
+  // FileEntry anymore and the next lookup creates a new one.
+  llvm::SmallPtrSet<const FileEntry *, 8> DroppedFiles;
+  std::vector<std::string> FilesToDrop;
+  for (const auto &Entry : SeenFileEntries) {
+    StringRef Path = Entry.getKey();
+    if (!Entry.getValue()) {
+      if (IsSkipped(Path)) {
+        FilesToDrop.push_back(Path.str());
+        continue;
+      }
+      // A lookup that failed because it named a directory fails the same way
+      // as long as it still does.
+      llvm::vfs::Status Status;
+      std::error_code EC = getNoncachedStatValue(Path, Status);
+      if (!EC && (!Status.isDirectory() ||
+                  Entry.getValue().getError() != std::errc::is_a_directory)) {
+        ++NumStale;
+        FilesToDrop.push_back(Path.str());
+      }
+      continue;
+    }
+
+    FileEntryRef Ref(Entry);
+    const FileEntry &FE = Ref.getFileEntry();
+    if (DroppedFiles.count(&FE))
+      continue;
+    if (IsSkipped(Path) || DroppedDirs.count(&Ref.getDir().getMapEntry()) ||
+        llvm::is_contained(VirtualFileEntries, &FE)) {
+      DroppedFiles.insert(&FE);
+      continue;
+    }
+    llvm::vfs::Status Status;
+    std::error_code EC = getNoncachedStatValue(Path, Status);
+    if (EC || Status.isDirectory() ||
+        Status.getUniqueID() != FE.getUniqueID() ||
+        Status.getSize() != uint64_t(FE.getSize()) ||
+        Status.getLastModificationTime() != FE.PreciseModTime) {
+      ++NumStale;
+      DroppedFiles.insert(&FE);
+    }
+  }
+
+  if (!DroppedFiles.empty()) {
+    for (const auto &Entry : SeenFileEntries)
+      if (Entry.getValue() &&
+          DroppedFiles.count(&FileEntryRef(Entry).getFileEntry()))
+        FilesToDrop.push_back(Entry.getKey().str());
+    for (const FileEntry *FE : DroppedFiles) {
+      FE->closeFile();
+      auto It = UniqueRealFiles.find(FE->getUniqueID());
+      if (It != UniqueRealFiles.end() && It->second == FE)
+        UniqueRealFiles.erase(It);
+    }
+    llvm::erase_if(VirtualFileEntries, [&](const FileEntry *FE) {
+      return DroppedFiles.count(FE);
+    });
+  }
+  for (const std::string &Path : FilesToDrop)
+    SeenFileEntries.erase(Path);
+  for (const std::string &Path : DirsToDrop)
+    SeenDirEntries.erase(Path);
+  return NumStale;
+}
+
 void FileManager::GetUniqueIDMapping(
     SmallVectorImpl<const FileEntry *> &UIDToFiles) const {
   UIDToFiles.clear();
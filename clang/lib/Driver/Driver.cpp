@@ -1217,9 +1217,10 @@ Compilation *Driver::BuildCompilation(ArrayRef<const char *> ArgList) {
   Args.ClaimAllArgs(options::OPT_canonical_prefixes);
   Args.ClaimAllArgs(options::OPT_no_canonical_prefixes);
 
-  // f(no-)integated-cc1 is also used very early in main.
+  // f(no-)integated-cc1 and -fcc1-server= are also used very early in main.
   Args.ClaimAllArgs(options::OPT_fintegrated_cc1);
   Args.ClaimAllArgs(options::OPT_fno_integrated_cc1);
+  Args.ClaimAllArgs(options::OPT_fcc1_server_EQ);
 
   // Ignore -pipe.
   Args.ClaimAllArgs(options::OPT_pipe);
@@ -3345,6 +3345,21 @@ cleanupAroundReplacements(StringRef Code, const tooling::Replacements &Replaces,
   return cantFail(processReplacements(Cleanup, Code, NewReplaces, Style));
 }
 
+// Some passes of reformat() only rewrite one kind of declaration, but still lex
+// and parse the whole file. These return false if \p Code can't contain such a
+// declaration, so that the pass can be skipped.
+static bool mayContainNamespace(StringRef Code, const FormatStyle &Style) {
+  if (Code.contains("namespace"))
+    return true;
+  return llvm::any_of(Style.NamespaceMacros, [&](const std::string &Macro) {
+    return Code.contains(Macro);
+  });
+}
+
+static bool mayContainUsingDeclaration(StringRef Code) {
+  return Code.contains("using");
+}
+
 namespace internal {
 std::pair<tooling::Replacements, unsigned>
 reformat(const FormatStyle &Style, StringRef Code,
@@ -3440,13 +3455,13 @@ reformat(const FormatStyle &Style, StringRef Code,
       });
     }
 
-    if (Style.FixNamespaceComments) {
+    if (Style.FixNamespaceComments && mayContainNamespace(Code, Expanded)) {
       Passes.emplace_back([&](const Environment &Env) {
         return NamespaceEndCommentsFixer(Env, Expanded).process();
       });
     }
 
-    if (Style.SortUsingDeclarations) {
+    if (Style.SortUsingDeclarations && mayContainUsingDeclaration(Code)) {
       Passes.emplace_back([&](const Environment &Env) {
         return UsingDeclarationsSorter(Env, Expanded).process();
       });
@@ -3482,6 +3497,11 @@ reformat(const FormatStyle &Style, StringRef Code,
   unsigned Penalty = 0;
   for (size_t I = 0, E = Passes.size(); I < E; ++I) {
     std::pair<tooling::Replacements, unsigned> PassFixes = Passes[I](*Env);
+    // The code is unchanged, so the next pass can reuse the environment.
+    if (PassFixes.first.empty()) {
+      Penalty += PassFixes.second;
+      continue;
+    }
     auto NewCode = applyAllReplacements(
         CurrentCode ? StringRef(*CurrentCode) : Code, PassFixes.first);
     if (NewCode) {
@@ -1175,8 +1175,7 @@ private:
     QueueType Queue;
 
     // Insert start element into queue.
-    StateNode *RootNode =
-        new (Allocator.Allocate()) StateNode(InitialState, false, nullptr);
+    StateNode *RootNode = createNode(InitialState, false, nullptr);
     Queue.push(QueueItem(OrderedPenalty(0, Count), RootNode));
     ++Count;
 
@@ -1204,6 +1203,7 @@ private:
 
       if (!Seen.insert(&Node->State).second) {
         // State already examined with lower penalty.
+        FreeNodes.push_back(Node);
         continue;
       }
 
@@ -1243,10 +1243,11 @@ private:
     if (!NewLine && Indenter->mustBreak(PreviousNode->State))
       return;
 
-    StateNode *Node = new (Allocator.Allocate())
-        StateNode(PreviousNode->State, NewLine, PreviousNode);
-    if (!formatChildren(Node->State, NewLine, /*DryRun=*/true, Penalty))
+    StateNode *Node = createNode(PreviousNode->State, NewLine, PreviousNode);
+    if (!formatChildren(Node->State, NewLine, /*DryRun=*/true, Penalty)) {
+      FreeNodes.push_back(Node);
       return;
+    }
 
     Penalty += Indenter->addTokenToState(Node->State, NewLine, true);
 
@@ -1254,6 +1255,24 @@ private:
     ++(*Count);
   }
 
+  /// Returns a node for \p State, reusing a node that was dropped from the
+  /// search if there is one.
+  ///
+  /// Nodes are mostly dropped because an equal state was already examined.
+  /// Reusing them keeps the memory of the search proportional to the number
+  /// of distinct states, and assigning to their \c LineState reuses the memory
+  /// of its \c Stack instead of allocating a new one for each node.
+  StateNode *createNode(const LineState &State, bool NewLine,
+                        StateNode *Previous) {
+    if (FreeNodes.empty())
+      return new (Allocator.Allocate()) StateNode(State, NewLine, Previous);
+    StateNode *Node = FreeNodes.pop_back_val();
+    Node->State = State;
+    Node->NewLine = NewLine;
+    Node->Previous = Previous;
+    return Node;
+  }
+
   /// Applies the best formatting by reconstructing the path in the
   /// solution space that leads to \c Best.
   void reconstructPath(LineState &State, StateNode *Best) {
@@ -1280,6 +1299,8 @@ private:
   }
 
   llvm::SpecificBumpPtrAllocator<StateNode> Allocator;
+  /// Nodes that are no longer referenced by the search, see \c createNode.
+  SmallVector<StateNode *> FreeNodes;
 };
 
 } // anonymous namespace
@@ -1162,6 +1162,13 @@ static void parseAnalyzerConfigs(AnalyzerOptions &AnOpts,
       !llvm::sys::fs::is_directory(AnOpts.ModelPath))
     Diags->Report(diag::err_analyzer_config_invalid_input) << "model-path"
                                                            << "a filename";
+
+  if (AnOpts.ShardCount == 0)
+    Diags->Report(diag::err_analyzer_config_invalid_input) << "shard-count"
+                                                           << "a positive";
+  else if (AnOpts.ShardIndex >= AnOpts.ShardCount)
+    Diags->Report(diag::err_analyzer_config_invalid_input)
+        << "shard-index" << "a smaller than 'shard-count'";
 }
 
 /// Generate a remark argument. This is an inverse of `ParseOptimizationRemark`.
@@ -57,6 +57,9 @@ ALWAYS_ENABLED_STATISTIC(
 ALWAYS_ENABLED_STATISTIC(NumFrameworkLookups, "Number of framework lookups.");
 ALWAYS_ENABLED_STATISTIC(NumSubFrameworkLookups,
                          "Number of subframework lookups.");
+ALWAYS_ENABLED_STATISTIC(
+    NumSearchDirIndexSkips,
+    "Number of search directory probes skipped thanks to the index.");
 
 const IdentifierInfo *
 HeaderFileInfo::getControllingMacro(ExternalPreprocessorSource *External) {
@@ -101,6 +104,10 @@ void HeaderSearch::PrintStats() {
 
   llvm::errs() << NumFrameworkLookups << " framework lookups.\n"
                << NumSubFrameworkLookups << " subframework lookups.\n";
+
+  if (HSOpts->IndexSearchDirectories)
+    llvm::errs() << SearchDirContents.size() << " search directories indexed, "
+                 << NumSearchDirIndexSkips << " probes skipped.\n";
 }
 
 void HeaderSearch::SetSearchPaths(
@@ -415,6 +422,40 @@ StringRef DirectoryLookup::getName() const {
   return getHeaderMap()->getFileName();
 }
 
+bool HeaderSearch::mayContainFile(DirectoryEntryRef Dir, StringRef Filename) {
+  if (!HSOpts->IndexSearchDirectories || Filename.empty() ||
+      llvm::sys::path::is_absolute(Filename))
+    return true;
+
+  // Only the first path component is checked. "." and ".." never show up in
+  // directory listings.
+  StringRef FirstComponent = *llvm::sys::path::begin(Filename);
+  if (FirstComponent == "." || FirstComponent == "..")
+    return true;
+
+  auto Insertion = SearchDirContents.try_emplace(&Dir.getDirEntry(), nullptr);
+  std::unique_ptr<llvm::StringSet<>> &Contents = Insertion.first->second;
+  if (Insertion.second) {
+    // Lowercase every name so that this stays conservative on
+    // case-insensitive file systems.
+    auto Names = std::make_unique<llvm::StringSet<>>();
+    std::error_code EC;
+    SmallString<128> DirNative;
+    llvm::sys::path::native(Dir.getName(), DirNative);
+    llvm::vfs::FileSystem &FS = FileMgr.getVirtualFileSystem();
+    for (llvm::vfs::directory_iterator It = FS.dir_begin(DirNative, EC), End;
+         It != End && !EC; It.increment(EC))
+      Names->insert(llvm::sys::path::filename(It->path()).lower());
+    if (!EC)
+      Contents = std::move(Names);
+  }
+
+  if (!Contents || Contents->contains(FirstComponent.lower()))
+    return true;
+  ++NumSearchDirIndexSkips;
+  return false;
+}
+
 OptionalFileEntryRef HeaderSearch::getFileAndSuggestModule(
     StringRef FileName, SourceLocation IncludeLoc, const DirectoryEntry *Dir,
     bool IsSystemHeaderDir, Module *RequestingModule,
@@ -460,6 +501,9 @@ OptionalFileEntryRef DirectoryLookup::LookupFile(
 
   SmallString<1024> TmpDir;
   if (isNormalDir()) {
+    if (!HS.mayContainFile(*getDirRef(), Filename))
+      return std::nullopt;
+
     // Concatenate the requested file onto the directory.
     TmpDir = getDirRef()->getName();
     llvm::sys::path::append(TmpDir, Filename);
@@ -47,6 +47,15 @@
 #include <tuple>
 #include <utility>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
+
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -1820,8 +1829,141 @@ bool Lexer::LexUnicodeIdentifierStart(Token &Result, uint32_t C,
   return true;
 }
 
+//===----------------------------------------------------------------------===//
+// Vectorized scanning helpers
+//===----------------------------------------------------------------------===//
+//
+// The helpers below skip runs of bytes that the scalar lexing loops would
+// consume without doing anything else, 16 bytes at a time. They return a
+// pointer to the first byte the caller has to look at, or to a point less than
+// 16 bytes before the end of the buffer, and never read at or past \p End.
+// Callers always finish with their scalar loop, which is also the fallback on
+// hosts without SSE2 or AArch64 NEON.
+
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+#define CLANG_LEXER_HAS_BYTE_VECTORS 1
+
+#ifdef __SSE2__
+using ByteVector = __m128i;
+
+static ByteVector loadBytes(const char *Ptr) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));
+}
+static ByteVector splatByte(char C) { return _mm_set1_epi8(C); }
+static ByteVector bytesEqual(ByteVector V, char C) {
+  return _mm_cmpeq_epi8(V, splatByte(C));
+}
+static ByteVector bytesOr(ByteVector A, ByteVector B) {
+  return _mm_or_si128(A, B);
+}
+/// Matches bytes in the ASCII range [Lo, Hi]. Non-ASCII bytes compare as
+/// negative and never match.
+static ByteVector bytesInRange(ByteVector V, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(V, splatByte(Lo - 1)),
+                       _mm_cmplt_epi8(V, splatByte(Hi + 1)));
+}
+static ByteVector bytesNonASCII(ByteVector V) {
+  return _mm_cmplt_epi8(V, _mm_setzero_si128());
+}
+/// Returns the index of the first matching byte, or 16 if there is none.
+static unsigned firstMatch(ByteVector Matches) {
+  unsigned Mask = _mm_movemask_epi8(Matches);
+  return Mask ? llvm::countTrailingZeros(Mask) : 16;
+}
+/// Returns the index of the first byte that doesn't match, or 16.
+static unsigned firstMismatch(ByteVector Matches) {
+  unsigned Mask = ~_mm_movemask_epi8(Matches) & 0xFFFF;
+  return Mask ? llvm::countTrailingZeros(Mask) : 16;
+}
+#else
+using ByteVector = uint8x16_t;
+
+static ByteVector loadBytes(const char *Ptr) {
+  return vld1q_u8(reinterpret_cast<const uint8_t *>(Ptr));
+}
+static ByteVector splatByte(char C) { return vdupq_n_u8(C); }
+static ByteVector bytesEqual(ByteVector V, char C) {
+  return vceqq_u8(V, splatByte(C));
+}
+static ByteVector bytesOr(ByteVector A, ByteVector B) {
+  return vorrq_u8(A, B);
+}
+static ByteVector bytesInRange(ByteVector V, char Lo, char Hi) {
+  return vandq_u8(vcgeq_u8(V, splatByte(Lo)), vcleq_u8(V, splatByte(Hi)));
+}
+static ByteVector bytesNonASCII(ByteVector V) {
+  return vcgeq_u8(V, vdupq_n_u8(0x80));
+}
+/// Returns the index of the first matching byte, or 16 if there is none.
+static unsigned firstMatch(ByteVector Matches) {
+  // Narrow every byte of the mask to a nibble to get a scalar bitmask.
+  uint64_t Mask = vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Matches), 4)), 0);
+  return Mask ? llvm::countTrailingZeros(Mask) / 4 : 16;
+}
+/// Returns the index of the first byte that doesn't match, or 16.
+static unsigned firstMismatch(ByteVector Matches) {
+  return firstMatch(vmvnq_u8(Matches));
+}
+#endif
+#endif // __SSE2__ || (__ARM_NEON && __aarch64__)
+
+/// Skips bytes matching [_A-Za-z0-9].
+static const char *skipAsciiIdentifierContinue(const char *Ptr,
+                                               const char *End) {
+#ifdef CLANG_LEXER_HAS_BYTE_VECTORS
+  while (End - Ptr >= 16) {
+    ByteVector V = loadBytes(Ptr);
+    ByteVector IsIdent =
+        bytesOr(bytesOr(bytesInRange(V, 'a', 'z'), bytesInRange(V, 'A', 'Z')),
+                bytesOr(bytesInRange(V, '0', '9'), bytesEqual(V, '_')));
+    unsigned N = firstMismatch(IsIdent);
+    Ptr += N;
+    if (N != 16)
+      break;
+  }
+#endif
+  return Ptr;
+}
+
+/// Skips bytes matching [ \t\f\v].
+static const char *skipHorizontalWhitespace(const char *Ptr, const char *End) {
+#ifdef CLANG_LEXER_HAS_BYTE_VECTORS
+  while (End - Ptr >= 16) {
+    ByteVector V = loadBytes(Ptr);
+    ByteVector IsSpace =
+        bytesOr(bytesOr(bytesEqual(V, ' '), bytesEqual(V, '\t')),
+                bytesOr(bytesEqual(V, '\f'), bytesEqual(V, '\v')));
+    unsigned N = firstMismatch(IsSpace);
+    Ptr += N;
+    if (N != 16)
+      break;
+  }
+#endif
+  return Ptr;
+}
+
+/// Skips ASCII bytes other than '\n', '\r' and '\0', i.e. the body of a line
+/// comment up to the first byte that needs attention.
+static const char *skipLineCommentBody(const char *Ptr, const char *End) {
+#ifdef CLANG_LEXER_HAS_BYTE_VECTORS
+  while (End - Ptr >= 16) {
+    ByteVector V = loadBytes(Ptr);
+    ByteVector IsSpecial =
+        bytesOr(bytesOr(bytesNonASCII(V), bytesEqual(V, '\0')),
+                bytesOr(bytesEqual(V, '\n'), bytesEqual(V, '\r')));
+    unsigned N = firstMatch(IsSpecial);
+    Ptr += N;
+    if (N != 16)
+      break;
+  }
+#endif
+  return Ptr;
+}
+
 bool Lexer::LexIdentifierContinue(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched an identifier start.
+  CurPtr = skipAsciiIdentifierContinue(CurPtr, BufferEnd);
   while (true) {
     unsigned char C = *CurPtr;
     // Fast path.
@@ -2377,6 +2519,10 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
   // Skip consecutive spaces efficiently.
   while (true) {
     // Skip horizontal whitespace very aggressively.
+    if (isHorizontalWhitespace(Char)) {
+      CurPtr = skipHorizontalWhitespace(CurPtr, BufferEnd);
+      Char = *CurPtr;
+    }
     while (isHorizontalWhitespace(Char))
       Char = *++CurPtr;
 
@@ -2462,6 +2608,11 @@ bool Lexer::SkipLineComment(Token &Result, const char *CurPtr,
 
   char C;
   while (true) {
+    const char *ChunkEnd = skipLineCommentBody(CurPtr, BufferEnd);
+    if (ChunkEnd != CurPtr) {
+      CurPtr = ChunkEnd;
+      UnicodeDecodingAlreadyDiagnosed = false;
+    }
     C = *CurPtr;
     // Skip over characters in the fast loop.
     while (isASCII(C) && C != 0 &&   // Potentially EOF.
@@ -2700,13 +2851,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr, Lexer *L,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
@@ -2790,6 +2934,19 @@ bool Lexer::SkipBlockComment(Token &Result, const char *CurPtr,
         }
         CurPtr += 16;
       }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+      while (CurPtr + 16 < BufferEnd) {
+        ByteVector V = loadBytes(CurPtr);
+        if (LLVM_UNLIKELY(firstMatch(bytesNonASCII(V)) != 16))
+          goto MultiByteUTF8;
+        unsigned N = firstMatch(bytesEqual(V, '/'));
+        if (N != 16) {
+          // As above, point directly after the first slash.
+          CurPtr += N + 1;
+          goto FoundSlash;
+        }
+        CurPtr += 16;
+      }
 #elif __ALTIVEC__
       __vector unsigned char LongUTF = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
                                         0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
@@ -209,7 +209,7 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
       ValueWithBytesObjCTypeMethod(nullptr), NSArrayDecl(nullptr),
       ArrayWithObjectsMethod(nullptr), NSDictionaryDecl(nullptr),
       DictionaryWithObjectsMethod(nullptr), GlobalNewDeleteDeclared(false),
-      TUKind(TUKind), NumSFINAEErrors(0),
+      TUKind(TUKind), NumSFINAEErrors(0), NumSubstitutionFailureCacheHits(0),
       FullyCheckedComparisonCategories(
           static_cast<unsigned>(ComparisonCategoryType::Last) + 1),
       SatisfactionCache(Context), AccessCheckingSFINAE(false),
@@ -481,6 +481,14 @@ Sema::~Sema() {
   for (auto *Node : Satisfactions)
     delete Node;
 
+  // Delete cached substitution failures.
+  std::vector<CachedSubstitutionFailure *> SubstitutionFailures;
+  SubstitutionFailures.reserve(SubstitutionFailureCache.size());
+  for (auto &Node : SubstitutionFailureCache)
+    SubstitutionFailures.push_back(&Node);
+  for (auto *Node : SubstitutionFailures)
+    delete Node;
+
   threadSafety::threadSafetyCleanup(ThreadSafetyDeclCache);
 
   // Destroys data sharing attributes stack for OpenMP
@@ -556,6 +564,9 @@ void Sema::addExternalSource(ExternalSemaSource *E) {
 void Sema::PrintStats() const {
   llvm::errs() << "\n*** Semantic Analysis Stats:\n";
   llvm::errs() << NumSFINAEErrors << " SFINAE diagnostics trapped.\n";
+  llvm::errs() << SubstitutionFailureCache.size()
+               << " failed function template substitutions cached, "
+               << NumSubstitutionFailureCacheHits << " cache hits.\n";
 
   BumpAlloc.PrintStats();
   AnalysisWarnings.PrintStats();
@@ -52,6 +52,7 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/TimeProfiler.h"
 #include <algorithm>
 #include <cassert>
 #include <tuple>
@@ -3529,6 +3530,33 @@ static unsigned getPackIndexForParam(Sema &S,
   llvm_unreachable("parameter index would not be produced from template");
 }
 
+void Sema::CachedSubstitutionFailure::Profile(
+    llvm::FoldingSetNodeID &ID, const ASTContext &C,
+    const FunctionTemplateDecl *Template, ArrayRef<TemplateArgument> Args) {
+  ID.AddPointer(Template->getCanonicalDecl());
+  ID.AddInteger(Args.size());
+  for (const TemplateArgument &Arg : Args)
+    Arg.Profile(ID, C);
+}
+
+/// Determine whether the outcome of substituting deduced template arguments
+/// into the declaration of \p FunctionTemplate depends only on the template
+/// and the arguments, so that a failure can be cached.
+static bool canCacheSubstitutionFailure(Sema &S,
+                                        FunctionTemplateDecl *FunctionTemplate,
+                                        bool PartialOverloading) {
+  if (!S.getLangOpts().CacheSubstitutionFailures || PartialOverloading)
+    return false;
+
+  // Templates declared within a function, such as the call operator of a
+  // generic lambda, are substituted in the local instantiation scope of the
+  // enclosing function.
+  if (FunctionTemplate->getDeclContext()->isDependentContext() ||
+      FunctionTemplate->getParentFunctionOrMethod())
+    return false;
+  return true;
+}
+
 /// Finish template argument deduction for a function template,
 /// checking the deduced template arguments for completeness and forming
 /// the function template specialization.
@@ -3587,6 +3615,42 @@ Sema::TemplateDeductionResult Sema::FinishTemplateArgumentDeduction(
       TemplateArgumentList::CreateCopy(Context, CanonicalBuilder);
   Info.reset(SugaredDeducedArgumentList, CanonicalDeducedArgumentList);
 
+  // Check whether substituting these arguments is already known to fail.
+  // Dependent arguments only arise while checking templates and during
+  // partial ordering, where they stand for another template's parameters.
+  bool CacheFailure =
+      canCacheSubstitutionFailure(*this, FunctionTemplate,
+                                  PartialOverloading) &&
+      llvm::none_of(CanonicalBuilder, [](const TemplateArgument &Arg) {
+        return Arg.isDependent();
+      });
+  llvm::FoldingSetNodeID FailureKey;
+  if (CacheFailure) {
+    CachedSubstitutionFailure::Profile(FailureKey, Context, FunctionTemplate,
+                                       CanonicalBuilder);
+    void *InsertPos;
+    CachedSubstitutionFailure *Cached =
+        SubstitutionFailureCache.FindNodeOrInsertPos(FailureKey, InsertPos);
+    // The failure can only be reused if nothing has been declared or
+    // completed, and no module has been made visible, since it was found.
+    if (Cached && Cached->DeclGeneration == Context.getDeclGeneration() &&
+        Cached->VisibleModulesGeneration == VisibleModules.getGeneration()) {
+      llvm::TimeTraceScope TimeScope("SubstitutionFailureCacheHit", [&]() {
+        std::string Name;
+        llvm::raw_string_ostream OS(Name);
+        FunctionTemplate->getNameForDiagnostic(OS, getPrintingPolicy(),
+                                               /*Qualified=*/true);
+        return Name;
+      });
+      ++NumSubstitutionFailureCacheHits;
+      if (Cached->Diag)
+        Info.addSFINAEDiagnostic(Cached->Diag->first, Cached->Diag->second);
+      return TDK_SubstitutionFailure;
+    }
+  }
+  unsigned DeclGeneration = Context.getDeclGeneration();
+  unsigned VisibleModulesGeneration = VisibleModules.getGeneration();
+
   // Substitute the deduced template arguments into the function template
   // declaration to produce the function template specialization.
   DeclContext *Owner = FunctionTemplate->getDeclContext();
@@ -3597,7 +3661,44 @@ Sema::TemplateDeductionResult Sema::FinishTemplateArgumentDeduction(
       /*Final=*/false);
   Specialization = cast_or_null<FunctionDecl>(
       SubstDecl(FunctionTemplate->getTemplatedDecl(), Owner, SubstArgs));
-  if (!Specialization || Specialization->isInvalidDecl())
+  bool Failed = !Specialization || Specialization->isInvalidDecl();
+
+  if (CacheFailure) {
+    // Only remember failures caused by a SFINAE error; anything else has
+    // already been diagnosed. If the substitution itself declared or
+    // completed something, e.g. by instantiating a class template, another
+    // attempt starts from a different state, so that failure is not
+    // remembered either; the next one will be.
+    bool RememberFailure = Failed && Trap.hasErrorOccurred() &&
+                           !getDiagnostics().hasFatalErrorOccurred() &&
+                           DeclGeneration == Context.getDeclGeneration() &&
+                           VisibleModulesGeneration ==
+                               VisibleModules.getGeneration();
+    // The substitution may have inserted or removed entries, so the entry
+    // has to be looked up again. An existing entry is updated if the failure
+    // is remembered, and dropped as out of date otherwise.
+    void *InsertPos;
+    CachedSubstitutionFailure *Failure =
+        SubstitutionFailureCache.FindNodeOrInsertPos(FailureKey, InsertPos);
+    if (RememberFailure) {
+      if (!Failure) {
+        Failure = new CachedSubstitutionFailure();
+        Failure->Key = FailureKey;
+        // Note that entries of SubstitutionFailureCache are deleted in Sema's
+        // destructor.
+        SubstitutionFailureCache.InsertNode(Failure, InsertPos);
+      }
+      Failure->Diag.reset();
+      if (Info.hasSFINAEDiagnostic())
+        Failure->Diag = Info.peekSFINAEDiagnostic();
+      Failure->DeclGeneration = DeclGeneration;
+      Failure->VisibleModulesGeneration = VisibleModulesGeneration;
+    } else if (Failure) {
+      SubstitutionFailureCache.RemoveNode(Failure);
+      delete Failure;
+    }
+  }
+  if (Failed)
     return TDK_SubstitutionFailure;
 
   assert(Specialization->getPrimaryTemplate()->getCanonicalDecl() ==
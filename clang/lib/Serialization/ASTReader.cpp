@@ -2415,15 +2415,24 @@ InputFile ASTReader::getInputFile(ModuleFile &F, unsigned ID, bool Complain) {
   auto HasInputFileChanged = [&]() {
     if (StoredSize != File->getSize())
       return Change{Change::Size, StoredSize, File->getSize()};
-    if (!shouldDisableValidationForFile(F) && StoredTime &&
-        StoredTime != File->getModificationTime()) {
+    bool HasContentHash =
+        StoredContentHash != static_cast<uint64_t>(llvm::hash_code(-1));
+    // AST files written by -fdeterministic-ast-output record no timestamps,
+    // so a same-size edit can only be caught by hashing the content. Only do
+    // this when asked to, since it reads every input file on every import;
+    // otherwise keep the size/mtime fast path.
+    bool ValidateByContentOnly =
+        !StoredTime && ValidateASTInputFilesContent && HasContentHash &&
+        PP.getHeaderSearchInfo().getHeaderSearchOpts().DeterministicASTOutput;
+    if (!shouldDisableValidationForFile(F) &&
+        ((StoredTime && StoredTime != File->getModificationTime()) ||
+         ValidateByContentOnly)) {
       Change MTimeChange = {Change::ModTime, StoredTime,
                             File->getModificationTime()};
 
       // In case the modification time changes but not the content,
       // accept the cached file as legit.
-      if (ValidateASTInputFilesContent &&
-          StoredContentHash != static_cast<uint64_t>(llvm::hash_code(-1))) {
+      if (ValidateASTInputFilesContent && HasContentHash) {
         auto MemBuffOrError = FileMgr.getBufferForFile(File);
         if (!MemBuffOrError) {
           if (!Complain)
@@ -2835,20 +2844,30 @@ ASTReader::ReadControlBlock(ModuleFile &F,
       if (ASTReadResult Result = readUnhashedControlBlockOnce())
         return Result;
 
-      // Load each of the imported PCH files.
+      // Decode the imports up front, so that their module files can be
+      // prefetched while they are loaded one by one below.
+      struct ImportedModuleFile {
+        ModuleKind Kind;
+        SourceLocation ImportLoc;
+        off_t StoredSize;
+        time_t StoredModTime;
+        ASTFileSignature StoredSignature;
+      };
+      SmallVector<ImportedModuleFile, 4> Imports;
+      SmallVector<std::pair<std::string, ModuleKind>, 4> ImportedFiles;
       unsigned Idx = 0, N = Record.size();
       while (Idx < N) {
         // Read information about the AST file.
-        ModuleKind ImportedKind = (ModuleKind)Record[Idx++];
+        ImportedModuleFile Import;
+        Import.Kind = (ModuleKind)Record[Idx++];
         // The import location will be the local one for now; we will adjust
         // all import locations of module imports after the global source
         // location info are setup, in ReadAST.
-        SourceLocation ImportLoc =
-            ReadUntranslatedSourceLocation(Record[Idx++]);
-        off_t StoredSize = (off_t)Record[Idx++];
-        time_t StoredModTime = (time_t)Record[Idx++];
+        Import.ImportLoc = ReadUntranslatedSourceLocation(Record[Idx++]);
+        Import.StoredSize = (off_t)Record[Idx++];
+        Import.StoredModTime = (time_t)Record[Idx++];
         auto FirstSignatureByte = Record.begin() + Idx;
-        ASTFileSignature StoredSignature = ASTFileSignature::create(
+        Import.StoredSignature = ASTFileSignature::create(
             FirstSignatureByte, FirstSignatureByte + ASTFileSignature::size);
         Idx += ASTFileSignature::size;
 
@@ -2860,7 +2879,8 @@ ASTReader::ReadControlBlock(ModuleFile &F,
         // directories, only the explicit name to file mappings. Also, we will
         // still verify the size/signature making sure it is essentially the
         // same file but perhaps in a different location.
-        if (ImportedKind == MK_PrebuiltModule || ImportedKind == MK_ExplicitModule)
+        if (Import.Kind == MK_PrebuiltModule ||
+            Import.Kind == MK_ExplicitModule)
           ImportedFile = PP.getHeaderSearchInfo().getPrebuiltModuleFileName(
             ImportedName, /*FileMapOnly*/ true);
 
@@ -2871,6 +2891,20 @@ ASTReader::ReadControlBlock(ModuleFile &F,
         else
           SkipPath(Record, Idx);
 
+        Imports.push_back(Import);
+        ImportedFiles.emplace_back(std::move(ImportedFile), Import.Kind);
+      }
+
+      ModuleManager &ModMgr = getModuleManager();
+      ModMgr.prefetchModuleFiles(ImportedFiles);
+      auto DiscardPrefetched = llvm::make_scope_exit(
+          [&] { ModMgr.discardPrefetchedModuleFiles(ImportedFiles); });
+
+      // Load each of the imported PCH files.
+      for (unsigned I = 0, E = Imports.size(); I != E; ++I) {
+        const ImportedModuleFile &Import = Imports[I];
+        const std::string &ImportedFile = ImportedFiles[I].first;
+
         // If our client can't cope with us being out of date, we can't cope with
         // our dependency being missing.
         unsigned Capabilities = ClientLoadCapabilities;
@@ -2878,14 +2912,15 @@ ASTReader::ReadControlBlock(ModuleFile &F,
           Capabilities &= ~ARR_Missing;
 
         // Load the AST file.
-        auto Result = ReadASTCore(ImportedFile, ImportedKind, ImportLoc, &F,
-                                  Loaded, StoredSize, StoredModTime,
-                                  StoredSignature, Capabilities);
+        auto Result =
+            ReadASTCore(ImportedFile, Import.Kind, Import.ImportLoc, &F, Loaded,
+                        Import.StoredSize, Import.StoredModTime,
+                        Import.StoredSignature, Capabilities);
 
         // If we diagnosed a problem, produce a backtrace.
         bool recompilingFinalized =
             Result == OutOfDate && (Capabilities & ARR_OutOfDate) &&
-            getModuleManager().getModuleCache().isPCMFinal(F.FileName);
+            ModMgr.getModuleCache().isPCMFinal(F.FileName);
         if (isDiagnosedResult(Result, Capabilities) || recompilingFinalized)
           Diag(diag::note_module_file_imported_by)
               << F.FileName << !F.ModuleName.empty() << F.ModuleName;
@@ -7896,6 +7931,10 @@ void ASTReader::PrintStats() {
                  NumIdentifierLookupHits, NumIdentifierLookups,
                  (double)NumIdentifierLookupHits*100.0/NumIdentifierLookups);
 
+  if (unsigned NumPrefetched = ModuleMgr.getNumPrefetchedModuleFiles())
+    std::fprintf(stderr, "  %u/%u prefetched module files used\n",
+                 ModuleMgr.getNumPrefetchedModuleFilesUsed(), NumPrefetched);
+
   if (GlobalIndex) {
     std::fprintf(stderr, "\n");
     GlobalIndex->printStats();
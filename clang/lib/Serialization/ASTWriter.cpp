@@ -1139,10 +1139,14 @@ ASTFileSignature ASTWriter::writeUnhashedControlBlock(Preprocessor &PP,
   RecordData Record;
   Stream.EnterSubblock(UNHASHED_CONTROL_BLOCK_ID, 5);
 
-  // For implicit modules, write the hash of the PCM as its signature.
+  // For implicit modules, write the hash of the PCM as its signature. In
+  // deterministic mode, do so for every AST file so that importers validate
+  // it by content rather than by size and modification time.
   ASTFileSignature Signature;
-  if (WritingModule &&
-      PP.getHeaderSearchInfo().getHeaderSearchOpts().ModulesHashContent) {
+  const HeaderSearchOptions &HSOpts =
+      PP.getHeaderSearchInfo().getHeaderSearchOpts();
+  if ((WritingModule && HSOpts.ModulesHashContent) ||
+      HSOpts.DeterministicASTOutput) {
     ASTFileSignature ASTBlockHash;
     auto ASTBlockStartByte = ASTBlockRange.first >> 3;
     auto ASTBlockByteLength = (ASTBlockRange.second >> 3) - ASTBlockStartByte;
@@ -1178,8 +1182,6 @@ ASTFileSignature ASTWriter::writeUnhashedControlBlock(Preprocessor &PP,
 
   // Header search paths.
   Record.clear();
-  const HeaderSearchOptions &HSOpts =
-      PP.getHeaderSearchInfo().getHeaderSearchOpts();
 
   // Include entries.
   Record.push_back(HSOpts.UserEntries.size());
@@ -1573,9 +1575,9 @@ void ASTWriter::WriteInputFiles(SourceManager &SourceMgr,
                                 File.getIncludeLoc().isInvalid();
 
     auto ContentHash = hash_code(-1);
-    if (PP->getHeaderSearchInfo()
-            .getHeaderSearchOpts()
-            .ValidateASTInputFilesContent) {
+    const HeaderSearchOptions &HSOpts =
+        PP->getHeaderSearchInfo().getHeaderSearchOpts();
+    if (HSOpts.ValidateASTInputFilesContent || HSOpts.DeterministicASTOutput) {
       auto MemBuff = Cache->getBufferIfLoaded();
       if (MemBuff)
         ContentHash = hash_value(MemBuff->getBuffer());
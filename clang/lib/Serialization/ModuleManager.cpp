@@ -15,6 +15,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/LLVM.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/ModuleMap.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
 #include "clang/Serialization/InMemoryModuleCache.h"
@@ -31,6 +32,7 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/GraphWriter.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include <algorithm>
 #include <cassert>
@@ -75,6 +77,23 @@ ModuleManager::lookupBuffer(StringRef Name) {
   return std::move(InMemoryBuffers[*Entry]);
 }
 
+/// Whether module files of the given kind are memory mapped instead of read
+/// into memory up front.
+///
+/// Only the parts of a mapped file that are actually used, such as the on-disk
+/// lookup tables consulted on first use, are paged in. This is only safe if
+/// the file isn't modified or replaced while the compiler runs, since that
+/// would change or invalidate the mapped contents. Files in the implicit
+/// module cache may be replaced at any time by other compiler invocations, so
+/// they are always read in full. Explicitly built and prebuilt modules are
+/// only mapped if the build system promises that its module files are
+/// read-only (-fmodules-map-explicit-files).
+static bool isMappedModuleKind(const HeaderSearchOptions &HSOpts,
+                               ModuleKind Kind) {
+  return HSOpts.ModulesMapExplicitFiles &&
+         (Kind == MK_ExplicitModule || Kind == MK_PrebuiltModule);
+}
+
 static bool checkSignature(ASTFileSignature Signature,
                            ASTFileSignature ExpectedSignature,
                            std::string &ErrorStr) {
@@ -204,17 +223,28 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
   } else {
     // Open the AST file.
     llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buf((std::error_code()));
+    auto Prefetched = PrefetchedBuffers.find(FileName);
     if (FileName == "-") {
       Buf = llvm::MemoryBuffer::getSTDIN();
+    } else if (Prefetched != PrefetchedBuffers.end() && Prefetched->second &&
+               Prefetched->second->getBufferSize() ==
+                   static_cast<size_t>(Entry->getSize())) {
+      // The contents were read ahead of time by prefetchModuleFiles().
+      Buf = std::move(Prefetched->second);
+      PrefetchedBuffers.erase(Prefetched);
+      ++NumPrefetchedModuleFilesUsed;
+      Entry->closeFile();
     } else {
       // Get a buffer of the file and close the file descriptor when done.
       // The file is volatile because in a parallel build we expect multiple
-      // compiler processes to use the same module file rebuilding it if needed.
+      // compiler processes to use the same module file rebuilding it if needed,
+      // unless the build system promised otherwise. See isMappedModuleKind().
       //
       // RequiresNullTerminator is false because module files don't need it, and
       // this allows the file to still be mmapped.
-      Buf = FileMgr.getBufferForFile(NewModule->File,
-                                     /*IsVolatile=*/true,
+      bool IsVolatile =
+          !isMappedModuleKind(HeaderSearchInfo.getHeaderSearchOpts(), Type);
+      Buf = FileMgr.getBufferForFile(NewModule->File, IsVolatile,
                                      /*RequiresNullTerminator=*/false);
     }
 
@@ -287,6 +317,50 @@ void ModuleManager::removeModules(ModuleIterator First) {
   Chain.erase(Chain.begin() + (First - begin()), Chain.end());
 }
 
+void ModuleManager::prefetchModuleFiles(
+    ArrayRef<std::pair<std::string, ModuleKind>> FileNamesAndKinds) {
+  const HeaderSearchOptions &HSOpts = HeaderSearchInfo.getHeaderSearchOpts();
+  if (!HSOpts.ModulesPrefetchImports)
+    return;
+
+  SmallVector<StringRef, 8> ToRead;
+  for (const auto &FileNameAndKind : FileNamesAndKinds) {
+    StringRef FileName = FileNameAndKind.first;
+    if (isMappedModuleKind(HSOpts, FileNameAndKind.second) ||
+        FileName == "-" ||
+        PrefetchedBuffers.count(FileName) ||
+        getModuleCache().lookupPCM(FileName) || lookupByFileName(FileName))
+      continue;
+    ToRead.push_back(FileName);
+  }
+  // There's nothing to overlap with a single file.
+  if (ToRead.size() < 2)
+    return;
+
+  llvm::vfs::FileSystem &FS = FileMgr.getVirtualFileSystem();
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> Buffers(ToRead.size());
+  llvm::parallelFor(0, ToRead.size(), [&](size_t I) {
+    auto Buf = FS.getBufferForFile(ToRead[I], /*FileSize=*/-1,
+                                   /*RequiresNullTerminator=*/false,
+                                   /*IsVolatile=*/true);
+    if (Buf)
+      Buffers[I] = std::move(*Buf);
+  });
+
+  for (size_t I = 0, E = ToRead.size(); I != E; ++I) {
+    if (!Buffers[I])
+      continue;
+    PrefetchedBuffers[ToRead[I]] = std::move(Buffers[I]);
+    ++NumPrefetchedModuleFiles;
+  }
+}
+
+void ModuleManager::discardPrefetchedModuleFiles(
+    ArrayRef<std::pair<std::string, ModuleKind>> FileNamesAndKinds) {
+  for (const auto &FileNameAndKind : FileNamesAndKinds)
+    PrefetchedBuffers.erase(FileNameAndKind.first);
+}
+
 void
 ModuleManager::addInMemoryBuffer(StringRef FileName,
                                  std::unique_ptr<llvm::MemoryBuffer> Buffer) {
@@ -41,6 +41,7 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <memory>
 #include <queue>
 #include <utility>
@@ -528,9 +529,12 @@ static void reportAnalyzerFunctionMisuse(const AnalyzerOptions &Opts,
 void AnalysisConsumer::runAnalysisOnTranslationUnit(ASTContext &C) {
   BugReporter BR(*Mgr);
   TranslationUnitDecl *TU = C.getTranslationUnitDecl();
+  // Checks on the whole translation unit belong to the first shard.
+  const bool RunTUChecks = Opts->ShardIndex == 0;
   if (SyntaxCheckTimer)
     SyntaxCheckTimer->startTimer();
-  checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
+  if (RunTUChecks)
+    checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
   if (SyntaxCheckTimer)
     SyntaxCheckTimer->stopTimer();
 
@@ -557,7 +561,8 @@ void AnalysisConsumer::runAnalysisOnTranslationUnit(ASTContext &C) {
     HandleDeclsCallGraph(LocalTUDeclsSize);
 
   // After all decls handled, run checkers on the entire TranslationUnit.
-  checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
+  if (RunTUChecks)
+    checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
 
   BR.FlushReports();
   RecVisitorBR = nullptr;
@@ -621,12 +626,39 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
         NumBlocksInAnalyzedFunctions;
 }
 
+/// Returns whether \p D is analyzed path-sensitively by this analyzer when
+/// the top-level functions are split into shards. The assignment only depends
+/// on the name of \p D, so every shard computes the same partition.
+static bool isInCurrentShard(const Decl *D, const AnalyzerOptions &Opts) {
+  if (Opts.ShardCount <= 1)
+    return true;
+  return llvm::xxHash64(AnalysisDeclContext::getFunctionName(D)) %
+             Opts.ShardCount ==
+         Opts.ShardIndex;
+}
+
 AnalysisConsumer::AnalysisMode
 AnalysisConsumer::getModeForDecl(Decl *D, AnalysisMode Mode) {
   if (!Opts->AnalyzeSpecificFunction.empty() &&
       AnalysisDeclContext::getFunctionName(D) != Opts->AnalyzeSpecificFunction)
     return AM_None;
 
+  // Syntax checks run in the first shard only. Path-sensitive analysis only
+  // starts from the top-level functions of the current shard. Callers from
+  // other shards are not analyzed here, so their callees are never marked as
+  // inlined and are analyzed as top-level functions, which a single run
+  // would skip. This adds reports to the union of the shards, usually with
+  // the same issue hash as the inlined report. The analysis of each caller
+  // itself does not depend on the sharding.
+  if (Opts->ShardCount > 1) {
+    if (Opts->ShardIndex != 0)
+      Mode &= ~AM_Syntax;
+    if ((Mode & AM_Path) && !isInCurrentShard(D, *Opts))
+      Mode &= ~AM_Path;
+    if (Mode == AM_None)
+      return AM_None;
+  }
+
   // Unless -analyze-all is specified, treat decls differently depending on
   // where they came from:
   // - Main source file: run both path-sensitive and non-path-sensitive checks.
@@ -0,0 +1,171 @@
+//===- DependencyDirectivesDiskCache.cpp - Persistent directives ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Every entry is a little-endian file with the following layout:
+//
+//   char     Magic[4]       "CDDC"
+//   uint32_t Version        EntryFormatVersion
+//   uint32_t NumTokenKinds  tok::NUM_TOKENS of the producing compiler
+//   uint64_t SourceSize     size of the original source
+//   uint32_t NumTokens
+//   uint32_t NumDirectives
+//   { uint32_t Offset, Length; uint16_t Kind, Flags; } x NumTokens
+//   { uint8_t Kind; uint32_t NumTokens; }               x NumDirectives
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/DependencyScanning/DependencyDirectivesDiskCache.h"
+#include "clang/Basic/TokenKinds.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/BLAKE3.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+
+using namespace clang;
+using namespace tooling;
+using namespace dependencies;
+using namespace llvm::support;
+
+static constexpr char EntryMagic[4] = {'C', 'D', 'D', 'C'};
+static constexpr uint32_t EntryFormatVersion = 1;
+
+static constexpr size_t HeaderSize = 4 + 4 + 4 + 8 + 4 + 4;
+static constexpr size_t TokenSize = 4 + 4 + 2 + 2;
+static constexpr size_t DirectiveSize = 1 + 4;
+
+void DependencyDirectivesDiskCache::getEntryPath(
+    StringRef Source, SmallVectorImpl<char> &Path) const {
+  auto Hash = llvm::BLAKE3::hash<16>(llvm::arrayRefFromStringRef(Source));
+  Path.assign(CachePath.begin(), CachePath.end());
+  llvm::sys::path::append(Path, llvm::toHex(Hash, /*LowerCase=*/true) +
+                                    ".ddc");
+}
+
+bool DependencyDirectivesDiskCache::lookup(
+    StringRef Source,
+    SmallVectorImpl<dependency_directives_scan::Token> &Tokens,
+    SmallVectorImpl<dependency_directives_scan::Directive> &Directives) const {
+  SmallString<256> EntryPath;
+  getEntryPath(Source, EntryPath);
+  auto MaybeBuffer = llvm::MemoryBuffer::getFile(
+      EntryPath, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+  if (!MaybeBuffer)
+    return false;
+
+  StringRef Data = (*MaybeBuffer)->getBuffer();
+  if (Data.size() < HeaderSize ||
+      !Data.startswith(StringRef(EntryMagic, sizeof(EntryMagic))))
+    return false;
+
+  const auto *Ptr = reinterpret_cast<const unsigned char *>(Data.data()) +
+                    sizeof(EntryMagic);
+  auto Version = endian::readNext<uint32_t, little, unaligned>(Ptr);
+  auto NumTokenKinds = endian::readNext<uint32_t, little, unaligned>(Ptr);
+  auto SourceSize = endian::readNext<uint64_t, little, unaligned>(Ptr);
+  auto NumTokens = endian::readNext<uint32_t, little, unaligned>(Ptr);
+  auto NumDirectives = endian::readNext<uint32_t, little, unaligned>(Ptr);
+  if (Version != EntryFormatVersion || NumTokenKinds != tok::NUM_TOKENS ||
+      SourceSize != Source.size() ||
+      Data.size() != HeaderSize + uint64_t(NumTokens) * TokenSize +
+                         uint64_t(NumDirectives) * DirectiveSize)
+    return false;
+
+  Tokens.clear();
+  Directives.clear();
+  Tokens.reserve(NumTokens);
+  for (uint32_t I = 0; I != NumTokens; ++I) {
+    auto Offset = endian::readNext<uint32_t, little, unaligned>(Ptr);
+    auto Length = endian::readNext<uint32_t, little, unaligned>(Ptr);
+    auto Kind = endian::readNext<uint16_t, little, unaligned>(Ptr);
+    auto Flags = endian::readNext<uint16_t, little, unaligned>(Ptr);
+    if (Kind >= tok::NUM_TOKENS || uint64_t(Offset) + Length > Source.size()) {
+      Tokens.clear();
+      return false;
+    }
+    Tokens.emplace_back(Offset, Length, static_cast<tok::TokenKind>(Kind),
+                        Flags);
+  }
+
+  // The tokens are final at this point, so the directives can safely refer
+  // into them.
+  ArrayRef<dependency_directives_scan::Token> Remaining = Tokens;
+  Directives.reserve(NumDirectives);
+  for (uint32_t I = 0; I != NumDirectives; ++I) {
+    auto Kind = endian::readNext<uint8_t, little, unaligned>(Ptr);
+    auto Count = endian::readNext<uint32_t, little, unaligned>(Ptr);
+    if (Kind > dependency_directives_scan::pp_eof || Count > Remaining.size()) {
+      Tokens.clear();
+      Directives.clear();
+      return false;
+    }
+    Directives.emplace_back(
+        static_cast<dependency_directives_scan::DirectiveKind>(Kind),
+        Remaining.take_front(Count));
+    Remaining = Remaining.drop_front(Count);
+  }
+  if (!Remaining.empty()) {
+    Tokens.clear();
+    Directives.clear();
+    return false;
+  }
+  return true;
+}
+
+void DependencyDirectivesDiskCache::store(
+    StringRef Source, ArrayRef<dependency_directives_scan::Token> Tokens,
+    ArrayRef<dependency_directives_scan::Directive> Directives) const {
+  if (llvm::sys::fs::create_directories(CachePath))
+    return;
+
+  SmallString<256> EntryPath;
+  getEntryPath(Source, EntryPath);
+
+  SmallString<256> TempModel(CachePath);
+  llvm::sys::path::append(TempModel, "entry-%%%%%%%%.tmp");
+  auto Temp = llvm::sys::fs::TempFile::create(TempModel);
+  if (!Temp) {
+    llvm::consumeError(Temp.takeError());
+    return;
+  }
+
+  {
+    llvm::raw_fd_ostream OS(Temp->FD, /*shouldClose=*/false);
+    endian::Writer W(OS, little);
+    OS.write(EntryMagic, sizeof(EntryMagic));
+    W.write<uint32_t>(EntryFormatVersion);
+    W.write<uint32_t>(tok::NUM_TOKENS);
+    W.write<uint64_t>(Source.size());
+    W.write<uint32_t>(Tokens.size());
+    W.write<uint32_t>(Directives.size());
+    for (const dependency_directives_scan::Token &Tok : Tokens) {
+      W.write<uint32_t>(Tok.Offset);
+      W.write<uint32_t>(Tok.Length);
+      W.write<uint16_t>(Tok.Kind);
+      W.write<uint16_t>(Tok.Flags);
+    }
+    for (const dependency_directives_scan::Directive &D : Directives) {
+      W.write<uint8_t>(D.Kind);
+      W.write<uint32_t>(D.Tokens.size());
+    }
+    OS.flush();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::consumeError(Temp->discard());
+      return;
+    }
+  }
+
+  // Another process may have raced us to store the same entry. Since both
+  // entries were produced from identical contents, either one is fine.
+  if (llvm::Error E = Temp->keep(EntryPath)) {
+    llvm::consumeError(std::move(E));
+    llvm::consumeError(Temp->discard());
+  }
+}
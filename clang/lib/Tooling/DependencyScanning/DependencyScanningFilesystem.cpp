@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Tooling/DependencyScanning/DependencyScanningFilesystem.h"
+#include "clang/Tooling/DependencyScanning/DependencyDirectivesDiskCache.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
 #include "llvm/Support/Threading.h"
@@ -60,10 +61,20 @@ EntryRef DependencyScanningWorkerFilesystem::scanForDirectivesIfNecessary(
     return EntryRef(Filename, Entry);
 
   SmallVector<dependency_directives_scan::Directive, 64> Directives;
-  // Scan the file for preprocessor directives that might affect the
-  // dependencies.
-  if (scanSourceForDependencyDirectives(Contents->Original->getBuffer(),
-                                        Contents->DepDirectiveTokens,
+  StringRef Source = Contents->Original->getBuffer();
+  const DependencyDirectivesDiskCache *DiskCache = SharedCache.getDiskCache();
+
+  // Reuse the directives scanned by a previous scanning service if the
+  // contents are unchanged. Otherwise, scan the file for preprocessor
+  // directives that might affect the dependencies.
+  if (DiskCache &&
+      DiskCache->lookup(Source, Contents->DepDirectiveTokens, Directives)) {
+    Contents->DepDirectives.store(
+        new Optional<DependencyDirectivesTy>(std::move(Directives)));
+    return EntryRef(Filename, Entry);
+  }
+
+  if (scanSourceForDependencyDirectives(Source, Contents->DepDirectiveTokens,
                                         Directives)) {
     Contents->DepDirectiveTokens.clear();
     // FIXME: Propagate the diagnostic if desired by the client.
@@ -71,6 +82,9 @@ EntryRef DependencyScanningWorkerFilesystem::scanForDirectivesIfNecessary(
     return EntryRef(Filename, Entry);
   }
 
+  if (DiskCache)
+    DiskCache->store(Source, Contents->DepDirectiveTokens, Directives);
+
   // This function performed double-checked locking using `DepDirectives`.
   // Assigning it must be the last thing this function does, otherwise other
   // threads may skip the
@@ -81,7 +95,9 @@ EntryRef DependencyScanningWorkerFilesystem::scanForDirectivesIfNecessary(
 }
 
 DependencyScanningFilesystemSharedCache::
-    DependencyScanningFilesystemSharedCache() {
+    DependencyScanningFilesystemSharedCache(
+        const DependencyDirectivesDiskCache *DiskCache)
+    : DiskCache(DiskCache) {
   // This heuristic was chosen using a empirical testing on a
   // reasonably high core machine (iMacPro 18 cores / 36 threads). The cache
   // sharding gives a performance edge by reducing the lock contention.
@@ -105,6 +121,62 @@ DependencyScanningFilesystemSharedCache::getShardForUID(
   return CacheShards[Hash % NumShards];
 }
 
+/// Whether \p CachedEntry no longer describes what \p Stat says about the
+/// file system.
+static bool isOutOfDate(const CachedFileSystemEntry &CachedEntry,
+                        const llvm::ErrorOr<llvm::vfs::Status> &Stat) {
+  if (CachedEntry.isError())
+    return bool(Stat);
+  if (!Stat || Stat->isDirectory() != CachedEntry.isDirectory())
+    return true;
+  // Directory modification times change whenever any file is added to them.
+  // The files that matter have their own entries, so don't treat that as
+  // invalidating.
+  if (CachedEntry.isDirectory())
+    return false;
+  llvm::vfs::Status CachedStat = CachedEntry.getStatus();
+  return Stat->getUniqueID() != CachedStat.getUniqueID() ||
+         Stat->getLastModificationTime() !=
+             CachedStat.getLastModificationTime() ||
+         Stat->getSize() != CachedStat.getSize();
+}
+
+unsigned DependencyScanningFilesystemSharedCache::invalidateOutOfDateEntries(
+    llvm::vfs::FileSystem &UnderlyingFS) {
+  // Names and unique IDs of a file live in different shards, so find all the
+  // stale entries before dropping any of them.
+  llvm::DenseSet<const CachedFileSystemEntry *> StaleEntries;
+  for (unsigned I = 0; I < NumShards; ++I) {
+    CacheShard &Shard = CacheShards[I];
+    std::lock_guard<std::mutex> LockGuard(Shard.CacheLock);
+    for (const auto &Entry : Shard.EntriesByFilename)
+      if (isOutOfDate(*Entry.getValue(), UnderlyingFS.status(Entry.getKey())))
+        StaleEntries.insert(Entry.getValue());
+  }
+  if (StaleEntries.empty())
+    return 0;
+
+  unsigned NumDropped = 0;
+  for (unsigned I = 0; I < NumShards; ++I) {
+    CacheShard &Shard = CacheShards[I];
+    std::lock_guard<std::mutex> LockGuard(Shard.CacheLock);
+    for (auto It = Shard.EntriesByFilename.begin(),
+              End = Shard.EntriesByFilename.end();
+         It != End;) {
+      auto Current = It++;
+      if (StaleEntries.contains(Current->getValue())) {
+        Shard.EntriesByFilename.erase(Current);
+        ++NumDropped;
+      }
+    }
+    for (auto It = Shard.EntriesByUID.begin(), End = Shard.EntriesByUID.end();
+         It != End; ++It)
+      if (StaleEntries.contains(It->getSecond()))
+        Shard.EntriesByUID.erase(It);
+  }
+  return NumDropped;
+}
+
 const CachedFileSystemEntry *
 DependencyScanningFilesystemSharedCache::CacheShard::findEntryByFilename(
     StringRef Filename) const {
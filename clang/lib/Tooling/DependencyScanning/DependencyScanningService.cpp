@@ -15,9 +15,15 @@ using namespace dependencies;
 
 DependencyScanningService::DependencyScanningService(
     ScanningMode Mode, ScanningOutputFormat Format, bool OptimizeArgs,
-    bool EagerLoadModules)
+    bool EagerLoadModules, StringRef DirectivesCachePath)
     : Mode(Mode), Format(Format), OptimizeArgs(OptimizeArgs),
-      EagerLoadModules(EagerLoadModules) {
+      EagerLoadModules(EagerLoadModules),
+      DirectivesDiskCache(
+          DirectivesCachePath.empty()
+              ? nullptr
+              : std::make_unique<DependencyDirectivesDiskCache>(
+                    DirectivesCachePath)),
+      SharedCache(DirectivesDiskCache.get()) {
   // Initialize targets for object file support.
   llvm::InitializeAllTargets();
   llvm::InitializeAllTargetMCs();
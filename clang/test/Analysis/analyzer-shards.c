@@ -0,0 +1,65 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores \
+// RUN:   -analyzer-config shard-count=2,shard-index=0 \
+// RUN:   -verify=shard0 %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores \
+// RUN:   -analyzer-config shard-count=2,shard-index=1 \
+// RUN:   -verify=shard1,toplevel %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores \
+// RUN:   -verify=shard0,shard1 %s
+
+// RUN: not %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config shard-count=2,shard-index=2 %s 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=CHECK-INDEX
+// CHECK-INDEX: (frontend): invalid input for analyzer-config option
+// CHECK-INDEX-SAME:        'shard-index', that expects a smaller than
+// CHECK-INDEX-SAME:        'shard-count' value
+
+// RUN: not %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config shard-count=0 %s 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=CHECK-COUNT
+// CHECK-COUNT: (frontend): invalid input for analyzer-config option
+// CHECK-COUNT-SAME:        'shard-count', that expects a positive value
+
+// Top-level functions are assigned to shards by a hash of their names:
+// 'alpha', 'useDivide' and 'passLocal' belong to shard 0, 'delta', 'divide'
+// and 'checkAndDeref' to shard 1. Syntax checks, such as dead stores, run in
+// shard 0 for all functions. Apart from the 'toplevel' reports, the union of
+// both shards equals the unsharded run.
+
+int alpha(int x) {
+  int zero = 0;
+  return x / zero; // shard0-warning{{Division by zero}}
+}
+
+int delta(int x) {
+  int unused = x; // shard0-warning{{Value stored to 'unused' during its initialization is never read}}
+  int zero = 0;
+  return x / zero; // shard1-warning{{Division by zero}}
+}
+
+// A callee from another shard is still inlined into its caller, so the bug
+// is found through the caller's shard.
+int divide(int x) {
+  return 10 / x; // shard0-warning{{Division by zero}}
+}
+
+int useDivide(void) {
+  return divide(0);
+}
+
+// A single run skips the top-level analysis of 'checkAndDeref' because it
+// was inlined into 'passLocal'. Shard 1 never analyzes 'passLocal', so it
+// analyzes 'checkAndDeref' as a top-level function and reports a path that
+// the unsharded run does not.
+int NullCount;
+
+int checkAndDeref(int *p) {
+  if (!p)
+    ++NullCount;
+  return *p; // toplevel-warning{{Dereference of null pointer (loaded from variable 'p')}}
+}
+
+int passLocal(void) {
+  int local = 0;
+  return checkAndDeref(&local);
+}
@@ -0,0 +1,30 @@
+// Check that clang-scan-deps -server answers one line per request. Invalid
+// requests are answered right away while the valid ones are being scanned, so
+// the order of the responses is not checked.
+
+// RUN: rm -rf %t
+// RUN: split-file %s %t
+// RUN: sed "s|DIR|%/t|g" %t/requests.template > %t/requests.jsonl
+// RUN: clang-scan-deps -server -j 1 < %t/requests.jsonl | FileCheck %s
+
+// CHECK-DAG: {"id":1,"result":"tu1.o: {{.*}}tu1.c{{.*}}a.h{{.*}}"}
+// CHECK-DAG: {"id":"two","result":"tu2.o: {{.*}}tu2.c{{.*}}b.h{{.*}}"}
+// CHECK-DAG: {"error":"{{.*}}"}
+// CHECK-DAG: {"error":"expected an object with 'directory', 'file' and 'arguments'","id":4}
+// CHECK-DAG: {"error":"{{.*}}'missing.h' file not found{{.*}}","id":5}
+
+//--- requests.template
+{"id": 1, "directory": "DIR", "file": "DIR/tu1.c", "arguments": ["clang", "-c", "DIR/tu1.c", "-o", "tu1.o"]}
+{"id": "two", "directory": "DIR", "file": "DIR/tu2.c", "arguments": ["clang", "-c", "DIR/tu2.c", "-o", "tu2.o"]}
+not json
+{"id": 4, "directory": "DIR"}
+{"id": 5, "directory": "DIR", "file": "DIR/tu3.c", "arguments": ["clang", "-c", "DIR/tu3.c", "-o", "tu3.o"]}
+
+//--- a.h
+//--- b.h
+//--- tu1.c
+#include "a.h"
+//--- tu2.c
+#include "b.h"
+//--- tu3.c
+#include "missing.h"
@@ -0,0 +1,18 @@
+// Jobs for a compiler server run through the in-process path, and the option
+// itself is consumed by the driver.
+// RUN: %clang -fno-integrated-cc1 -fcc1-server=%t.sock -fintegrated-as -c -### %s 2>&1 \
+// RUN:     | FileCheck %s
+// CHECK: (in-process)
+// CHECK-NOT: -fcc1-server
+
+// Without a server listening on the socket, the job runs in the driver.
+// RUN: rm -f %t.sock
+// RUN: %clang -fcc1-server=%t.sock -fsyntax-only -Werror %s
+// RUN: not %clang -fcc1-server=%t.sock -fsyntax-only -DERROR %s 2>&1 \
+// RUN:     | FileCheck %s --check-prefix=ERROR
+// ERROR: error: expected error
+
+#ifdef ERROR
+#error expected error
+#endif
+int main(void) { return 0; }
@@ -0,0 +1,36 @@
+// RUN: rm -rf %t && mkdir -p %t/build
+// RUN: %clangxx -S -ftime-trace-summary -o %t/build/check-time-trace-summary %s
+// RUN: not ls %t/build/check-time-trace-summary.json
+// RUN: cat %t/build/check-time-trace-summary.summary.json \
+// RUN:   | %python -c 'import json, sys; json.dump(json.loads(sys.stdin.read()), sys.stdout, sort_keys=True, indent=2)' \
+// RUN:   | FileCheck %s
+
+// The summary is written next to the full trace when both are requested.
+// RUN: %clangxx -S -ftime-trace -ftime-trace-summary -o %t/build/both %s
+// RUN: ls %t/build/both.json %t/build/both.summary.json
+
+// RUN: clang-time-trace-report %t/build | FileCheck %s --check-prefix=REPORT
+// RUN: clang-time-trace-report -json -event=InstantiateClass \
+// RUN:   %t/build/both.summary.json | FileCheck %s --check-prefix=MERGED
+
+// CHECK:      "events": [
+// CHECK:          "detail": "Foo<int>",
+// CHECK-NEXT:     "dur":
+// CHECK-NEXT:     "name": "InstantiateClass"
+// CHECK:      "process":
+// CHECK:      "version": 1
+
+// REPORT:      Merged 2 summaries.
+// REPORT:      === Events ===
+// REPORT:      === InstantiateClass (top 1 of 1) ===
+// REPORT-NEXT: ms 2 2 TUs Foo<int>
+
+// MERGED:     "name": "InstantiateClass",
+// MERGED-NOT: "name": "CodeGen Function"
+
+template <typename T>
+struct Foo {
+  T Value;
+};
+
+Foo<int> Global;
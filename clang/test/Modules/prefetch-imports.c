@@ -0,0 +1,64 @@
+// Check that reading the imports of a module file ahead of time doesn't change
+// how the module is loaded, and that the prefetched files are used.
+
+// RUN: rm -rf %t
+// RUN: split-file %s %t
+
+// The first compilation builds all modules, the second one loads the already
+// built module files from the cache and prefetches the imports of Top.
+// RUN: %clang_cc1 -fsyntax-only -verify -I %t/include %t/test.c \
+// RUN:   -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:   -fmodules-prefetch-imports
+// RUN: %clang_cc1 -fsyntax-only -verify -I %t/include %t/test.c \
+// RUN:   -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:   -fmodules-prefetch-imports -print-stats 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=PREFETCH
+
+// Explicitly built modules are read, and so prefetched, by default.
+// RUN: %clang_cc1 -emit-module -fmodules -fmodule-name=Left \
+// RUN:   %t/include/module.modulemap -o %t/Left.pcm
+// RUN: %clang_cc1 -emit-module -fmodules -fmodule-name=Right \
+// RUN:   %t/include/module.modulemap -o %t/Right.pcm
+// RUN: %clang_cc1 -emit-module -fmodules -fno-implicit-modules \
+// RUN:   -fmodule-name=Top -fmodule-file=%t/Left.pcm -fmodule-file=%t/Right.pcm \
+// RUN:   %t/include/module.modulemap -o %t/Top.pcm
+// RUN: %clang_cc1 -fsyntax-only -verify -fmodules -fno-implicit-modules \
+// RUN:   -fmodule-map-file=%t/include/module.modulemap \
+// RUN:   -fmodule-file=%t/Top.pcm -fmodules-prefetch-imports -print-stats %t/test.c \
+// RUN:   2>&1 | FileCheck %s --check-prefix=PREFETCH
+
+// When the build system promises that they don't change, they are mapped
+// instead, and nothing is prefetched.
+// RUN: %clang_cc1 -fsyntax-only -verify -fmodules -fno-implicit-modules \
+// RUN:   -fmodule-map-file=%t/include/module.modulemap \
+// RUN:   -fmodule-file=%t/Top.pcm -fmodules-prefetch-imports \
+// RUN:   -fmodules-map-explicit-files -print-stats %t/test.c \
+// RUN:   2>&1 | FileCheck %s --check-prefix=MAPPED
+
+// PREFETCH: *** AST File Statistics:
+// PREFETCH: 2/2 prefetched module files used
+
+// MAPPED: *** AST File Statistics:
+// MAPPED-NOT: prefetched module files used
+
+//--- include/module.modulemap
+module Left { header "left.h" }
+module Right { header "right.h" }
+module Top { header "top.h" export * }
+
+//--- include/left.h
+int left(void);
+
+//--- include/right.h
+int right(void);
+
+//--- include/top.h
+#include "left.h"
+#include "right.h"
+int top(void);
+
+//--- test.c
+// expected-no-diagnostics
+#include "top.h"
+
+int test(void) { return left() + right() + top(); }
@@ -0,0 +1,25 @@
+// REQUIRES: shell
+//
+// Check that building the same PCH twice produces identical files, even when
+// the modification times of the inputs differ.
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo 'int m(void);' > %t/m.h
+// RUN: echo '#include "m.h"' > %t/a.h
+// RUN: %clang_cc1 -emit-pch -o %t/a.pch -I %t -x c-header %t/a.h -fdeterministic-ast-output
+// RUN: mv %t/a.pch %t/first.pch
+// RUN: touch -m -a -t 202901010000 %t/m.h
+// RUN: %clang_cc1 -emit-pch -o %t/a.pch -I %t -x c-header %t/a.h -fdeterministic-ast-output
+// RUN: cmp %t/first.pch %t/a.pch
+//
+// Without timestamps, a change that keeps the size is detected by content when
+// the importer also asks for deterministic AST validation. Plain
+// -fvalidate-ast-input-files-content keeps the cheap size check.
+// RUN: %clang_cc1 -fsyntax-only -I %t -include-pch %t/a.pch %s -verify -fvalidate-ast-input-files-content -fdeterministic-ast-output
+// RUN: echo 'int x(void);' > %t/m.h
+// RUN: %clang_cc1 -fsyntax-only -I %t -include-pch %t/a.pch %s -verify -fvalidate-ast-input-files-content
+// RUN: not %clang_cc1 -fsyntax-only -I %t -include-pch %t/a.pch %s -fvalidate-ast-input-files-content -fdeterministic-ast-output 2> %t/stderr
+// RUN: FileCheck %s < %t/stderr
+//
+// CHECK: file '[[M_H:.*[/\\]m\.h]]' has been modified since the precompiled header '[[A_PCH:.*/a\.pch]]' was built: content changed
+// expected-no-diagnostics
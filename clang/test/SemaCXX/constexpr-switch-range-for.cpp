@@ -0,0 +1,79 @@
+// RUN: %clang_cc1 -std=c++20 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -std=c++20 -fsyntax-only -verify -fexperimental-new-constant-interpreter %s
+
+// expected-no-diagnostics
+
+constexpr int classify(int I) {
+  switch (I) {
+  case 0:
+    return 10;
+  case 1:
+  case 2:
+    return 20;
+  case 3: {
+    int R = 0;
+    for (int J = 0; J != 10; ++J) {
+      if (J == 4)
+        break;
+      R += J;
+    }
+    return R;
+  }
+  default:
+    break;
+  }
+  return -1;
+}
+static_assert(classify(0) == 10, "");
+static_assert(classify(1) == 20, "");
+static_assert(classify(2) == 20, "");
+static_assert(classify(3) == 6, "");
+static_assert(classify(4) == -1, "");
+
+constexpr int fallthrough(int I) {
+  int R = 0;
+  switch (int K = I * 2; K) {
+  case 2:
+    R += 1;
+    [[fallthrough]];
+  case 4:
+    R += 2;
+    break;
+  }
+  return R;
+}
+static_assert(fallthrough(1) == 3, "");
+static_assert(fallthrough(2) == 2, "");
+static_assert(fallthrough(3) == 0, "");
+
+constexpr int sum() {
+  int Arr[] = {1, 2, 3, 4, 5};
+  int S = 0;
+  for (int V : Arr)
+    S += V;
+  return S;
+}
+static_assert(sum() == 15, "");
+
+constexpr int sumSkippingOdd() {
+  int Arr[] = {1, 2, 3, 4, 5, 6};
+  int S = 0;
+  for (const int &V : Arr) {
+    if (V % 2)
+      continue;
+    S += V;
+  }
+  return S;
+}
+static_assert(sumSkippingOdd() == 12, "");
+
+constexpr int walkPointers() {
+  int Arr[] = {1, 2, 3};
+  int *P = Arr;
+  int A = *P++;
+  int B = *++P;
+  int C = *P--;
+  int D = *--P;
+  return A * 1000 + B * 100 + C * 10 + D;
+}
+static_assert(walkPointers() == 1331, "");
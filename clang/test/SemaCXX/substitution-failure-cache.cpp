@@ -0,0 +1,46 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -std=c++17 %s
+// RUN: %clang_cc1 -fsyntax-only -verify -std=c++17 -fno-cache-substitution-failures %s
+// RUN: not %clang_cc1 -fsyntax-only -std=c++17 -print-stats %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=STATS
+
+// A candidate whose substitution failed once must be rejected the same way,
+// with the same note, every time it is considered again.
+
+template <typename T> typename T::type get(T); // expected-note 2{{candidate template ignored: substitution failure [with T = int]: type 'int' cannot be used prior to '::' because it has no members}}
+
+struct HasType { using type = int; };
+int a = get(HasType());
+
+void f() {
+  get(0); // expected-error {{no matching function for call to 'get'}}
+  get(1); // expected-error {{no matching function for call to 'get'}}
+}
+
+// The failures below are redone once the declarations they depend on change,
+// and the stale entries are dropped.
+// STATS: 1 failed function template substitutions cached, 1 cache hits.
+
+// An overload found by argument-dependent lookup that is declared after a
+// failed substitution is taken into account.
+namespace late_adl {
+namespace N { struct S {}; }
+
+template <typename T> auto probe(T t) -> decltype(adl(t), char());
+long probe(...);
+
+static_assert(sizeof(probe(N::S())) == sizeof(long), "");
+namespace N { void adl(S); }
+static_assert(sizeof(probe(N::S())) == sizeof(char), "");
+} // namespace late_adl
+
+// So is a type that is completed after a failed substitution.
+namespace late_completion {
+struct Incomplete;
+
+template <typename T> auto measure(T *) -> decltype(sizeof(T), char());
+long measure(...);
+
+static_assert(sizeof(measure((Incomplete *)nullptr)) == sizeof(long), "");
+struct Incomplete {};
+static_assert(sizeof(measure((Incomplete *)nullptr)) == sizeof(char), "");
+} // namespace late_completion
@@ -16,6 +16,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/JSON.h"
@@ -156,6 +157,12 @@ static llvm::cl::opt<bool> EagerLoadModules(
     llvm::cl::desc("Load PCM files eagerly (instead of lazily on import)."),
     llvm::cl::init(false), llvm::cl::cat(DependencyScannerCategory));
 
+static llvm::cl::opt<std::string> DirectivesCachePath(
+    "directives-cache-path",
+    llvm::cl::desc("Directory in which to persist the scanned preprocessor "
+                   "directives of source files across invocations."),
+    llvm::cl::cat(DependencyScannerCategory));
+
 llvm::cl::opt<unsigned>
     NumThreads("j", llvm::cl::Optional,
                llvm::cl::desc("Number of worker threads to use (default: use "
@@ -164,9 +171,16 @@ llvm::cl::opt<unsigned>
 
 llvm::cl::opt<std::string>
     CompilationDB("compilation-database",
-                  llvm::cl::desc("Compilation database"), llvm::cl::Required,
+                  llvm::cl::desc("Compilation database"),
                   llvm::cl::cat(DependencyScannerCategory));
 
+static llvm::cl::opt<bool> Server(
+    "server",
+    llvm::cl::desc("Keep the scanning service alive and serve requests read "
+                   "from stdin, one JSON compile command per line, instead "
+                   "of scanning a compilation database."),
+    llvm::cl::init(false), llvm::cl::cat(DependencyScannerCategory));
+
 llvm::cl::opt<std::string> ModuleName(
     "module-name", llvm::cl::Optional,
     llvm::cl::desc("the module of which the dependencies are to be computed"),
@@ -280,6 +294,10 @@ public:
   }
 
   void printFullOutput(raw_ostream &OS) {
+    OS << llvm::formatv("{0:2}\n", toJSON());
+  }
+
+  llvm::json::Value toJSON() {
     // Sort the modules by name to get a deterministic order.
     std::vector<IndexedModuleID> ModuleIDs;
     for (auto &&M : Modules)
@@ -341,12 +359,10 @@ public:
       });
     }
 
-    Object Output{
+    return Object{
         {"modules", std::move(OutModules)},
         {"translation-units", std::move(TUs)},
     };
-
-    OS << llvm::formatv("{0:2}\n", Value(std::move(Output)));
   }
 
 private:
@@ -437,31 +453,198 @@ static std::string getModuleCachePath(ArrayRef<std::string> Args) {
   return std::string(Path);
 }
 
+/// Writes a single-line JSON response to \p OS.
+static void writeResponse(SharedStream &OS, llvm::json::Object Response) {
+  OS.applyLocked([&](raw_ostream &OS) {
+    OS << llvm::json::Value(std::move(Response)) << "\n";
+  });
+}
+
+namespace {
+/// Reads stdin line by line as the lines arrive, unlike
+/// MemoryBuffer::getSTDIN() which waits for the end of the input.
+class StdinLineReader {
+public:
+  /// Reads the next line into \p Line, without its line terminator. Returns
+  /// false at the end of the input.
+  bool next(std::string &Line) {
+    while (true) {
+      size_t Newline = Pending.find('\n', Scanned);
+      if (Newline != std::string::npos) {
+        Line = StringRef(Pending).take_front(Newline).rtrim('\r').str();
+        Pending.erase(0, Newline + 1);
+        Scanned = 0;
+        return true;
+      }
+      Scanned = Pending.size();
+      if (AtEOF) {
+        if (Pending.empty())
+          return false;
+        Line = std::move(Pending);
+        Pending.clear();
+        Scanned = 0;
+        return true;
+      }
+      char Buf[4096];
+      llvm::Expected<size_t> Read = llvm::sys::fs::readNativeFile(
+          llvm::sys::fs::getStdinHandle(), Buf);
+      if (!Read) {
+        llvm::consumeError(Read.takeError());
+        AtEOF = true;
+      } else if (*Read == 0) {
+        AtEOF = true;
+      } else {
+        Pending.append(Buf, *Read);
+      }
+    }
+  }
+
+private:
+  std::string Pending;
+  /// The prefix of Pending known not to contain a newline.
+  size_t Scanned = 0;
+  bool AtEOF = false;
+};
+} // namespace
+
+/// Serves scanning requests read from stdin until it is closed.
+///
+/// Every line of input is a JSON object with the "directory", "file" and
+/// "arguments" fields of a compilation database entry, plus an optional "id"
+/// that is echoed back. Every request is answered by one line on stdout holding
+/// the "id" and either the "result" (the dependency file text or the full
+/// dependency graph, depending on -format) or an "error". Requests are scanned
+/// concurrently, so responses may arrive out of order.
+///
+/// The scanning service and its filesystem cache are kept alive between
+/// requests. Whenever a request arrives while no other request is in flight,
+/// the cached files are re-stat'ed and only the ones that changed are dropped
+/// from the cache. Paths in requests should be absolute for this to be
+/// reliable.
+static int runServer(const tooling::ArgumentsAdjuster &AdjustArgs) {
+  SharedStream ResponseOS(llvm::outs());
+  llvm::ThreadPool Pool(llvm::hardware_concurrency(NumThreads));
+  auto RealFS = llvm::vfs::createPhysicalFileSystem();
+
+  std::unique_ptr<DependencyScanningService> Service;
+  // Tools that are not used by any running request. Guarded by ToolsLock.
+  std::vector<std::unique_ptr<DependencyScanningTool>> IdleTools;
+  std::mutex ToolsLock;
+  std::atomic<unsigned> InFlight(0);
+
+  StdinLineReader Input;
+  std::string Line;
+  while (Input.next(Line)) {
+    if (StringRef(Line).trim().empty())
+      continue;
+
+    llvm::json::Object Response;
+    llvm::Expected<llvm::json::Value> Request = llvm::json::parse(Line);
+    if (!Request) {
+      Response["error"] = llvm::toString(Request.takeError());
+      writeResponse(ResponseOS, std::move(Response));
+      continue;
+    }
+    if (const llvm::json::Object *Obj = Request->getAsObject())
+      if (const llvm::json::Value *ID = Obj->get("id"))
+        Response["id"] = *ID;
+
+    std::string Directory, Filename;
+    std::vector<std::string> Arguments;
+    llvm::json::Path::Root Root;
+    llvm::json::ObjectMapper O(*Request, Root);
+    if (!O || !O.map("directory", Directory) || !O.map("file", Filename) ||
+        !O.map("arguments", Arguments) || Arguments.empty()) {
+      Response["error"] =
+          "expected an object with 'directory', 'file' and 'arguments'";
+      writeResponse(ResponseOS, std::move(Response));
+      continue;
+    }
+
+    // Only swap the service out when no worker can be holding on to it.
+    if (InFlight == 0) {
+      Pool.wait();
+      if (!Service) {
+        Service = std::make_unique<DependencyScanningService>(
+            ScanMode, Format, OptimizeArgs, EagerLoadModules,
+            DirectivesCachePath);
+      } else if (unsigned NumDropped =
+                     Service->getSharedCache().invalidateOutOfDateEntries(
+                         *RealFS)) {
+        if (Verbose)
+          llvm::errs() << "Files changed, dropped " << NumDropped
+                       << " cached entries\n";
+        // The local caches of the idle tools may refer to dropped entries.
+        IdleTools.clear();
+      }
+    }
+
+    std::vector<std::string> CommandLine = AdjustArgs(Arguments, Filename);
+    ++InFlight;
+    Pool.async([&, Directory = std::move(Directory),
+                Filename = std::move(Filename),
+                CommandLine = std::move(CommandLine),
+                Response = std::move(Response)]() mutable {
+      std::unique_ptr<DependencyScanningTool> Tool;
+      {
+        std::unique_lock<std::mutex> LockGuard(ToolsLock);
+        if (!IdleTools.empty()) {
+          Tool = std::move(IdleTools.back());
+          IdleTools.pop_back();
+        }
+      }
+      if (!Tool)
+        Tool = std::make_unique<DependencyScanningTool>(*Service);
+
+      std::string OutputDir(ModuleFilesDir);
+      if (OutputDir.empty())
+        OutputDir = getModuleCachePath(CommandLine);
+      auto LookupOutput = [&](const ModuleID &MID, ModuleOutputKind MOK) {
+        return ::lookupModuleOutput(MID, MOK, OutputDir);
+      };
+
+      if (Format == ScanningOutputFormat::Make) {
+        auto MaybeFile = Tool->getDependencyFile(CommandLine, Directory);
+        if (MaybeFile)
+          Response["result"] = std::move(*MaybeFile);
+        else
+          Response["error"] = llvm::toString(MaybeFile.takeError());
+      } else {
+        // Every response is self-contained, so don't elide modules reported
+        // for earlier requests.
+        llvm::StringSet<> AlreadySeenModules;
+        auto MaybeFullDeps = Tool->getFullDependencies(
+            CommandLine, Directory, AlreadySeenModules, LookupOutput);
+        if (MaybeFullDeps) {
+          FullDeps FD;
+          FD.mergeDeps(Filename, std::move(*MaybeFullDeps), /*InputIndex=*/0);
+          Response["result"] = FD.toJSON();
+        } else {
+          Response["error"] = llvm::toString(MaybeFullDeps.takeError());
+        }
+      }
+      writeResponse(ResponseOS, std::move(Response));
+
+      {
+        std::unique_lock<std::mutex> LockGuard(ToolsLock);
+        IdleTools.push_back(std::move(Tool));
+      }
+      --InFlight;
+    });
+  }
+  Pool.wait();
+  return 0;
+}
+
 int main(int argc, const char **argv) {
   llvm::InitLLVM X(argc, argv);
   llvm::cl::HideUnrelatedOptions(DependencyScannerCategory);
   if (!llvm::cl::ParseCommandLineOptions(argc, argv))
     return 1;
 
-  std::string ErrorMessage;
-  std::unique_ptr<tooling::JSONCompilationDatabase> Compilations =
-      tooling::JSONCompilationDatabase::loadFromFile(
-          CompilationDB, ErrorMessage,
-          tooling::JSONCommandLineSyntax::AutoDetect);
-  if (!Compilations) {
-    llvm::errs() << "error: " << ErrorMessage << "\n";
-    return 1;
-  }
-
-  llvm::cl::PrintOptionValues();
-
-  // The command options are rewritten to run Clang in preprocessor only mode.
-  auto AdjustingCompilations =
-      std::make_unique<tooling::ArgumentsAdjustingCompilations>(
-          std::move(Compilations));
   ResourceDirectoryCache ResourceDirCache;
-
-  AdjustingCompilations->appendArgumentsAdjuster(
+  // The command options are rewritten to run Clang in preprocessor only mode.
+  tooling::ArgumentsAdjuster AdjustArgs =
       [&ResourceDirCache](const tooling::CommandLineArguments &Args,
                           StringRef FileName) {
         std::string LastO;
@@ -518,14 +701,39 @@ int main(int argc, const char **argv) {
         }
         AdjustedArgs.insert(AdjustedArgs.end(), FlagsEnd, Args.end());
         return AdjustedArgs;
-      });
+      };
+
+  if (Server)
+    return runServer(AdjustArgs);
+
+  if (CompilationDB.empty()) {
+    llvm::errs() << "error: -compilation-database is required\n";
+    return 1;
+  }
+
+  std::string ErrorMessage;
+  std::unique_ptr<tooling::JSONCompilationDatabase> Compilations =
+      tooling::JSONCompilationDatabase::loadFromFile(
+          CompilationDB, ErrorMessage,
+          tooling::JSONCommandLineSyntax::AutoDetect);
+  if (!Compilations) {
+    llvm::errs() << "error: " << ErrorMessage << "\n";
+    return 1;
+  }
+
+  llvm::cl::PrintOptionValues();
+
+  auto AdjustingCompilations =
+      std::make_unique<tooling::ArgumentsAdjustingCompilations>(
+          std::move(Compilations));
+  AdjustingCompilations->appendArgumentsAdjuster(AdjustArgs);
 
   SharedStream Errs(llvm::errs());
   // Print out the dependency results to STDOUT by default.
   SharedStream DependencyOS(llvm::outs());
 
   DependencyScanningService Service(ScanMode, Format, OptimizeArgs,
-                                    EagerLoadModules);
+                                    EagerLoadModules, DirectivesCachePath);
   llvm::ThreadPool Pool(llvm::hardware_concurrency(NumThreads));
   std::vector<std::unique_ptr<DependencyScanningTool>> WorkerTools;
   for (unsigned I = 0; I < Pool.getThreadCount(); ++I)
@@ -0,0 +1,237 @@
+//===-- clang-time-trace-report/ClangTimeTraceReport.cpp ------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool merges the build time summaries written by -ftime-trace-summary
+// for every translation unit of a project and reports where the time went:
+// the total for each kind of event, and for events that carry a detail (the
+// header being parsed, the template being instantiated, the function being
+// code generated, ...) the entries that cost the most across the build.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Version.h"
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/WithColor.h"
+#include <optional>
+#include <tuple>
+
+using namespace llvm;
+
+static cl::OptionCategory
+    ClangTimeTraceReportCategory("clang-time-trace-report options");
+
+static cl::list<std::string>
+    Inputs(cl::Positional, cl::OneOrMore,
+           cl::desc("<summary file or directory>..."),
+           cl::cat(ClangTimeTraceReportCategory));
+
+static cl::opt<unsigned>
+    Top("top", cl::desc("Number of entries to list for each event kind"),
+        cl::init(20), cl::cat(ClangTimeTraceReportCategory));
+
+static cl::list<std::string>
+    Events("event", cl::desc("Only report events with this name"),
+           cl::value_desc("name"), cl::cat(ClangTimeTraceReportCategory));
+
+static cl::opt<bool>
+    EmitJSON("json",
+             cl::desc("Write the merged summary as JSON instead of a report"),
+             cl::cat(ClangTimeTraceReportCategory));
+
+static void PrintVersion(raw_ostream &OS) {
+  OS << clang::getClangToolFullVersion("clang-time-trace-report") << '\n';
+}
+
+namespace {
+struct Total {
+  uint64_t Count = 0;
+  uint64_t Duration = 0;
+  /// Number of summaries in which the entry appeared.
+  unsigned Summaries = 0;
+};
+
+struct Entry {
+  StringRef Name;
+  StringRef Detail;
+  Total T;
+};
+} // namespace
+
+/// Totals per event name, and per detail for events that have one.
+static StringMap<Total> PerName;
+static StringMap<StringMap<Total>> PerDetail;
+static unsigned NumSummaries = 0;
+
+static bool isSelected(StringRef Name) {
+  return Events.empty() || is_contained(Events, Name);
+}
+
+static Error mergeSummary(StringRef Path) {
+  auto Buffer = MemoryBuffer::getFile(Path, /*IsText=*/true);
+  if (!Buffer)
+    return createFileError(Path, Buffer.getError());
+
+  Expected<json::Value> Summary = json::parse((*Buffer)->getBuffer());
+  if (!Summary)
+    return createFileError(Path, Summary.takeError());
+
+  const json::Object *Root = Summary->getAsObject();
+  const json::Array *EventList = Root ? Root->getArray("events") : nullptr;
+  if (!EventList || Root->getInteger("version") != 1)
+    return createFileError(Path, createStringError(inconvertibleErrorCode(),
+                                                   "not a time trace summary"));
+
+  for (const json::Value &V : *EventList) {
+    const json::Object *Event = V.getAsObject();
+    if (!Event)
+      return createFileError(
+          Path, createStringError(inconvertibleErrorCode(), "invalid event"));
+    std::optional<StringRef> Name = Event->getString("name");
+    std::optional<int64_t> Count = Event->getInteger("count");
+    std::optional<int64_t> Dur = Event->getInteger("dur");
+    if (!Name || !Count || !Dur || *Count < 0 || *Dur < 0)
+      return createFileError(
+          Path, createStringError(inconvertibleErrorCode(), "invalid event"));
+    if (!isSelected(*Name))
+      continue;
+
+    std::optional<StringRef> Detail = Event->getString("detail");
+    Total &T = Detail ? PerDetail[*Name][*Detail] : PerName[*Name];
+    T.Count += *Count;
+    T.Duration += *Dur;
+    ++T.Summaries;
+  }
+  ++NumSummaries;
+  return Error::success();
+}
+
+/// Merges \p Path, or every summary found below it if it is a directory.
+static Error mergeInput(StringRef Path) {
+  if (!sys::fs::is_directory(Path))
+    return mergeSummary(Path);
+
+  std::error_code EC;
+  for (sys::fs::recursive_directory_iterator It(Path, EC), End;
+       It != End && !EC; It.increment(EC)) {
+    if (!StringRef(It->path()).endswith(".summary.json"))
+      continue;
+    if (Error E = mergeSummary(It->path()))
+      return E;
+  }
+  if (EC)
+    return createFileError(Path, EC);
+  return Error::success();
+}
+
+static std::vector<Entry> sortedByDuration(const StringMap<Total> &Totals,
+                                           StringRef Name = StringRef()) {
+  std::vector<Entry> Sorted;
+  for (const auto &T : Totals) {
+    if (Name.empty())
+      Sorted.push_back({T.getKey(), StringRef(), T.getValue()});
+    else
+      Sorted.push_back({Name, T.getKey(), T.getValue()});
+  }
+  llvm::sort(Sorted, [](const Entry &A, const Entry &B) {
+    if (A.T.Duration != B.T.Duration)
+      return A.T.Duration > B.T.Duration;
+    return std::tie(A.Name, A.Detail) < std::tie(B.Name, B.Detail);
+  });
+  return Sorted;
+}
+
+static void writeJSON(raw_ostream &OS) {
+  std::vector<Entry> Sorted = sortedByDuration(PerName);
+  for (const auto &Name : PerDetail) {
+    std::vector<Entry> Details =
+        sortedByDuration(Name.getValue(), Name.getKey());
+    Sorted.insert(Sorted.end(), Details.begin(), Details.end());
+  }
+  llvm::stable_sort(Sorted, [](const Entry &A, const Entry &B) {
+    return A.T.Duration > B.T.Duration;
+  });
+
+  json::OStream J(OS, /*IndentSize=*/2);
+  J.object([&] {
+    J.attribute("version", 1);
+    J.attribute("process", "clang-time-trace-report");
+    J.attributeArray("events", [&] {
+      for (const Entry &E : Sorted) {
+        J.object([&] {
+          J.attribute("name", E.Name);
+          if (!E.Detail.empty())
+            J.attribute("detail", E.Detail);
+          J.attribute("count", int64_t(E.T.Count));
+          J.attribute("dur", int64_t(E.T.Duration));
+        });
+      }
+    });
+  });
+  OS << '\n';
+}
+
+static std::string formatMs(uint64_t Microseconds) {
+  return formatv("{0,12:f1} ms", Microseconds / 1000.0).str();
+}
+
+static void writeReport(raw_ostream &OS) {
+  OS << "Merged " << NumSummaries << " summaries.\n";
+
+  OS << "\n=== Events ===\n";
+  for (const Entry &E : sortedByDuration(PerName))
+    OS << formatMs(E.T.Duration) << formatv("{0,10}", E.T.Count) << "  "
+       << E.Name << '\n';
+
+  std::vector<Entry> Names = sortedByDuration(PerName);
+  for (const Entry &N : Names) {
+    auto It = PerDetail.find(N.Name);
+    if (It == PerDetail.end())
+      continue;
+    std::vector<Entry> Details =
+        sortedByDuration(It->getValue(), It->getKey());
+    OS << "\n=== " << N.Name << " (top "
+       << std::min<size_t>(Top, Details.size()) << " of " << Details.size()
+       << ") ===\n";
+    for (const Entry &E : makeArrayRef(Details).take_front(Top))
+      OS << formatMs(E.T.Duration) << formatv("{0,10}", E.T.Count)
+         << formatv("{0,6} TUs", E.T.Summaries) << "  " << E.Detail << '\n';
+  }
+}
+
+int main(int argc, const char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  cl::HideUnrelatedOptions(ClangTimeTraceReportCategory);
+  cl::SetVersionPrinter(PrintVersion);
+  cl::ParseCommandLineOptions(
+      argc, argv,
+      "A utility for merging the summaries written by -ftime-trace-summary.\n"
+      "Directories are searched recursively for *.summary.json files.\n");
+
+  auto reportError = [argv](Error E) {
+    logAllUnhandledErrors(std::move(E), WithColor::error(errs(), argv[0]));
+    return EXIT_FAILURE;
+  };
+
+  for (const std::string &Input : Inputs)
+    if (Error Err = mergeInput(Input))
+      return reportError(std::move(Err));
+
+  if (EmitJSON)
+    writeJSON(outs());
+  else
+    writeReport(outs());
+  return EXIT_SUCCESS;
+}
@@ -182,10 +182,15 @@ static int PrintSupportedCPUs(std::string TargetStr) {
   return 0;
 }
 
-int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
+/// Run a -cc1 job, reusing \p FileMgr and \p ModuleCache if they are
+/// non-null. They are handed in by the compiler server, which keeps them
+/// alive across jobs.
+int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr,
+             FileManager *FileMgr, InMemoryModuleCache *ModuleCache) {
   ensureSufficientStack();
 
-  std::unique_ptr<CompilerInstance> Clang(new CompilerInstance());
+  std::unique_ptr<CompilerInstance> Clang(new CompilerInstance(
+      std::make_shared<PCHContainerOperations>(), ModuleCache));
   IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
 
   // Register the support for object-file-wrapped Clang modules.
@@ -213,11 +218,13 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   bool Success = CompilerInvocation::CreateFromArgs(Clang->getInvocation(),
                                                     Argv, Diags, Argv0);
 
-  if (Clang->getFrontendOpts().TimeTrace ||
-      !Clang->getFrontendOpts().TimeTracePath.empty()) {
+  bool WriteTimeTrace = Clang->getFrontendOpts().TimeTrace ||
+                        !Clang->getFrontendOpts().TimeTracePath.empty();
+  if (WriteTimeTrace || Clang->getFrontendOpts().TimeTraceSummary) {
     Clang->getFrontendOpts().TimeTrace = 1;
     llvm::timeTraceProfilerInitialize(
-        Clang->getFrontendOpts().TimeTraceGranularity, Argv0);
+        Clang->getFrontendOpts().TimeTraceGranularity, Argv0,
+        Clang->getFrontendOpts().TimeTraceSummary);
   }
   // --print-supported-cpus takes priority over the actual compilation.
   if (Clang->getFrontendOpts().PrintSupportedCPUs)
@@ -245,6 +252,13 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
     return 1;
   }
 
+  if (FileMgr) {
+    Clang->setFileManager(FileMgr);
+    // The server outlives the job, so everything it allocated has to be freed.
+    Clang->getFrontendOpts().DisableFree = false;
+    Clang->getCodeGenOpts().DisableFree = false;
+  }
+
   // Execute the frontend actions.
   {
     llvm::TimeTraceScope TimeScope("ExecuteCompiler");
@@ -266,14 +280,24 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
         llvm::sys::path::append(TracePath, llvm::sys::path::filename(Path));
       Path.assign(TracePath);
     }
-    if (auto profilerOutput = Clang->createOutputFile(
-            Path.str(), /*Binary=*/false, /*RemoveFileOnSignal=*/false,
-            /*useTemporary=*/false)) {
-      llvm::timeTraceProfilerWrite(*profilerOutput);
-      profilerOutput.reset();
-      llvm::timeTraceProfilerCleanup();
-      Clang->clearOutputFiles(false);
+    if (Clang->getFrontendOpts().TimeTraceSummary) {
+      SmallString<128> SummaryPath(Path);
+      llvm::sys::path::replace_extension(SummaryPath, "summary.json");
+      if (auto summaryOutput = Clang->createOutputFile(
+              SummaryPath.str(), /*Binary=*/false,
+              /*RemoveFileOnSignal=*/false, /*useTemporary=*/false)) {
+        llvm::timeTraceProfilerWriteSummary(*summaryOutput);
+        summaryOutput.reset();
+      }
+    }
+    if (WriteTimeTrace) {
+      if (auto profilerOutput = Clang->createOutputFile(
+              Path.str(), /*Binary=*/false, /*RemoveFileOnSignal=*/false,
+              /*useTemporary=*/false))
+        llvm::timeTraceProfilerWrite(*profilerOutput);
     }
+    llvm::timeTraceProfilerCleanup();
+    Clang->clearOutputFiles(false);
   }
 
   // Our error handler depends on the Diagnostics object, which we're
@@ -289,3 +313,8 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
 
   return !Success;
 }
+
+int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
+  return cc1_main(Argv, Argv0, MainAddr, /*FileMgr=*/nullptr,
+                  /*ModuleCache=*/nullptr);
+}
@@ -0,0 +1,489 @@
+//===-- cc1server_main.cpp - Clang resident compiler server ---------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This is the entry point to the clang -cc1server functionality, which keeps a
+// compiler process alive and runs the -cc1 jobs that drivers started with
+// -fcc1-server=<socket> send to it. Jobs skip process startup and static
+// initialization, and share the file manager and the in-memory module cache
+// of earlier jobs. Only the files that changed since earlier jobs saw them are
+// looked up again.
+//
+// The server runs one job at a time. A driver that connects while a job is
+// running is told that the server is busy and runs its job itself. Each job
+// gets its own diagnostics and output, which are sent back to the driver. A
+// job that crashes is reported to its driver like an in-process crash, after
+// which the server shuts down, since its caches can't be trusted anymore.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/FileSystemOptions.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/Version.h"
+#include "clang/Serialization/InMemoryModuleCache.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Errno.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/raw_ostream.h"
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if LLVM_ON_UNIX
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace clang;
+
+extern int cc1_main(ArrayRef<const char *> Argv, const char *Argv0,
+                    void *MainAddr, FileManager *FileMgr,
+                    InMemoryModuleCache *ModuleCache);
+
+#if LLVM_ON_UNIX
+/// Identifies the messages below. Requests that start with anything else are
+/// declined, so that the driver runs the job itself.
+static const char ProtocolVersion[] = "clang-cc1-server-1";
+
+/// Whether the -cc1 job \p Args can run in the server. Jobs that change the
+/// global state of the process, or that depend on state of the driver which is
+/// not sent along, have to run in the driver instead.
+static bool canRunInServer(ArrayRef<std::string> Args) {
+  if (Args.empty() || Args[0] != "-cc1")
+    return false;
+  for (size_t I = 1, E = Args.size(); I != E; ++I) {
+    StringRef Arg = Args[I];
+    // LLVM options, plugins and statistics are global to the process.
+    if (Arg == "-mllvm" || Arg == "-load" || Arg.startswith("-fpass-plugin=") ||
+        Arg == "-print-stats" || Arg.startswith("-stats-file="))
+      return false;
+    // The shared file manager only works with the real file system.
+    if (Arg == "-ivfsoverlay" || Arg == "-working-directory" ||
+        Arg.startswith("-working-directory="))
+      return false;
+    // Reading from stdin.
+    if (Arg == "-" && Args[I - 1] != "-o")
+      return false;
+  }
+  return true;
+}
+
+/// How long the server waits for the request of a driver that connected.
+static const unsigned RequestTimeoutSeconds = 10;
+
+namespace {
+/// One end of a connection between a driver and the server. Messages are
+/// lists of strings, each of which is preceded by its length.
+class Connection {
+  int FD;
+
+  bool write(const void *Data, size_t Size) {
+    // A peer that goes away must not kill this process with SIGPIPE.
+#ifdef MSG_NOSIGNAL
+    const int Flags = MSG_NOSIGNAL;
+#else
+    const int Flags = 0;
+#endif
+    const char *Ptr = static_cast<const char *>(Data);
+    while (Size) {
+      ssize_t Written =
+          llvm::sys::RetryAfterSignal(-1, ::send, FD, Ptr, Size, Flags);
+      if (Written <= 0)
+        return false;
+      Ptr += Written;
+      Size -= Written;
+    }
+    return true;
+  }
+
+  bool read(void *Data, size_t Size) {
+    char *Ptr = static_cast<char *>(Data);
+    while (Size) {
+      ssize_t Read = llvm::sys::RetryAfterSignal(-1, ::read, FD, Ptr, Size);
+      if (Read <= 0)
+        return false;
+      Ptr += Read;
+      Size -= Read;
+    }
+    return true;
+  }
+
+  bool writeLength(size_t Length) {
+    char Buffer[4];
+    llvm::support::endian::write32le(Buffer, Length);
+    return write(Buffer, sizeof(Buffer));
+  }
+
+  bool readLength(uint32_t &Length) {
+    char Buffer[4];
+    if (!read(Buffer, sizeof(Buffer)))
+      return false;
+    Length = llvm::support::endian::read32le(Buffer);
+    return true;
+  }
+
+public:
+  explicit Connection(int FD) : FD(FD) {
+#ifdef SO_NOSIGPIPE
+    int On = 1;
+    ::setsockopt(FD, SOL_SOCKET, SO_NOSIGPIPE, &On, sizeof(On));
+#endif
+  }
+  Connection(const Connection &) = delete;
+  Connection &operator=(const Connection &) = delete;
+  ~Connection() { ::close(FD); }
+
+  /// Make reads fail if the peer sends nothing for \p Seconds.
+  void setReadTimeout(unsigned Seconds) {
+    timeval Timeout = {};
+    Timeout.tv_sec = Seconds;
+    ::setsockopt(FD, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout));
+  }
+
+  bool send(ArrayRef<std::string> Strings) {
+    if (!writeLength(Strings.size()))
+      return false;
+    for (const std::string &S : Strings)
+      if (!writeLength(S.size()) || !write(S.data(), S.size()))
+        return false;
+    return true;
+  }
+
+  bool receive(std::vector<std::string> &Strings) {
+    // Anything larger than this is not a message from a peer.
+    const uint32_t MaxLength = 1u << 30;
+    uint32_t Count;
+    if (!readLength(Count) || Count > MaxLength)
+      return false;
+    Strings.clear();
+    for (uint32_t I = 0; I != Count; ++I) {
+      uint32_t Length;
+      if (!readLength(Length) || Length > MaxLength)
+        return false;
+      std::string &S = Strings.emplace_back(Length, '\0');
+      if (!read(S.data(), Length))
+        return false;
+    }
+    return true;
+  }
+};
+
+/// Hands the connections accepted by the listening thread over to the thread
+/// that runs the jobs. Connections that arrive while a job is running are
+/// answered with "busy" right away, so that their drivers don't wait for the
+/// jobs before them.
+class Dispatcher {
+  std::mutex Mutex;
+  std::condition_variable Ready;
+  int PendingFD = -1;
+  bool Busy = false;
+  bool Stopped = false;
+
+public:
+  /// Called by the listening thread for every accepted connection.
+  void offer(int FD) {
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      if (!Busy && !Stopped) {
+        Busy = true;
+        PendingFD = FD;
+        Ready.notify_one();
+        return;
+      }
+    }
+    Connection(FD).send({"busy"});
+  }
+
+  /// Called by the job thread when it is done with the previous connection.
+  /// Returns the next connection, or -1 once the server stops.
+  int next() {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Busy = false;
+    Ready.wait(Lock, [&] { return PendingFD >= 0 || Stopped; });
+    int FD = PendingFD;
+    PendingFD = -1;
+    Busy = FD >= 0;
+    return FD;
+  }
+
+  void stop() {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Stopped = true;
+    Ready.notify_one();
+  }
+
+  bool isStopped() {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return Stopped;
+  }
+};
+
+/// Redirects stdout or stderr to a temporary file for as long as it lives, and
+/// collects what was written to it.
+class OutputCapture {
+  int StdFD;
+  int SavedFD = -1;
+  int TempFD = -1;
+  SmallString<128> TempPath;
+
+public:
+  explicit OutputCapture(int StdFD) : StdFD(StdFD) {
+    if (llvm::sys::fs::createTemporaryFile("cc1server", "out", TempFD,
+                                           TempPath))
+      return;
+    SavedFD = ::dup(StdFD);
+    if (SavedFD < 0 || ::dup2(TempFD, StdFD) < 0) {
+      ::close(TempFD);
+      TempFD = -1;
+    }
+  }
+
+  ~OutputCapture() {
+    if (SavedFD >= 0) {
+      ::dup2(SavedFD, StdFD);
+      ::close(SavedFD);
+    }
+    if (TempFD >= 0)
+      ::close(TempFD);
+    if (!TempPath.empty())
+      llvm::sys::fs::remove(TempPath);
+  }
+
+  bool isValid() const { return TempFD >= 0; }
+
+  /// Restore the original stream and return what was captured.
+  std::string take() {
+    ::dup2(SavedFD, StdFD);
+    auto Buffer = llvm::MemoryBuffer::getOpenFile(
+        llvm::sys::fs::convertFDToNativeFile(TempFD), TempPath, -1);
+    return Buffer ? (*Buffer)->getBuffer().str() : std::string();
+  }
+};
+} // namespace
+
+static bool getSocketAddress(StringRef SocketPath, sockaddr_un &Addr) {
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  if (SocketPath.empty() || SocketPath.size() >= sizeof(Addr.sun_path))
+    return false;
+  memcpy(Addr.sun_path, SocketPath.data(), SocketPath.size());
+  return true;
+}
+#endif
+
+/// Send the -cc1 job \p Argv to the compiler server listening on \p SocketPath
+/// and print its output. Returns false, without having printed anything, if
+/// the job has to run in this process instead: the server can't be reached,
+/// declines the job or goes away before it replies.
+bool cc1server_execute(StringRef SocketPath, ArrayRef<const char *> Argv,
+                       int &Res) {
+#if LLVM_ON_UNIX
+  sockaddr_un Addr;
+  SmallString<128> WorkingDir;
+  if (!getSocketAddress(SocketPath, Addr) ||
+      llvm::sys::fs::current_path(WorkingDir))
+    return false;
+
+  int FD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (FD < 0)
+    return false;
+  Connection Conn(FD);
+  if (llvm::sys::RetryAfterSignal(-1, ::connect, FD,
+                                  reinterpret_cast<sockaddr *>(&Addr),
+                                  sizeof(Addr)) < 0)
+    return false;
+
+  std::vector<std::string> Message = {ProtocolVersion, getClangFullVersion(),
+                                      std::string(WorkingDir)};
+  Message.insert(Message.end(), Argv.begin(), Argv.end());
+  if (!Conn.send(Message) || !Conn.receive(Message) || Message.size() != 4 ||
+      Message[0] != "ok" || !llvm::to_integer(Message[1], Res))
+    return false;
+
+  llvm::outs() << Message[2];
+  llvm::outs().flush();
+  llvm::errs() << Message[3];
+  return true;
+#else
+  return false;
+#endif
+}
+
+int cc1server_main(ArrayRef<const char *> Argv, const char *Argv0,
+                   void *MainAddr) {
+#if LLVM_ON_UNIX
+  if (Argv.size() != 1) {
+    llvm::errs() << "error: usage: clang -cc1server <socket>\n";
+    return 1;
+  }
+  StringRef SocketPath = Argv[0];
+  sockaddr_un Addr;
+  if (!getSocketAddress(SocketPath, Addr)) {
+    llvm::errs() << "error: invalid socket path '" << SocketPath << "'\n";
+    return 1;
+  }
+
+  // Take over the socket of a server that went away. sys::fs::remove() only
+  // removes regular files, directories and links.
+  llvm::sys::fs::file_status Status;
+  if (!llvm::sys::fs::status(SocketPath, Status) &&
+      Status.type() == llvm::sys::fs::file_type::socket_file)
+    ::unlink(Addr.sun_path);
+
+  // Jobs run with the permissions of the server, so only its owner may
+  // connect. The socket file gets its permissions when it is bound.
+  int ListenFD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  mode_t OldMask = ::umask(S_IRWXG | S_IRWXO);
+  bool Bound = ListenFD >= 0 && ::bind(ListenFD,
+                                       reinterpret_cast<sockaddr *>(&Addr),
+                                       sizeof(Addr)) == 0;
+  ::umask(OldMask);
+  if (!Bound || ::listen(ListenFD, SOMAXCONN) < 0) {
+    llvm::errs() << "error: cannot listen on '" << SocketPath
+                 << "': " << llvm::sys::StrError() << '\n';
+    return 1;
+  }
+
+  llvm::CrashRecoveryContext::Enable();
+
+  Dispatcher Jobs;
+  std::thread Listener([&Jobs, ListenFD] {
+    while (true) {
+      int FD = llvm::sys::RetryAfterSignal(-1, ::accept, ListenFD, nullptr,
+                                           nullptr);
+      if (FD < 0 || Jobs.isStopped()) {
+        if (FD >= 0)
+          ::close(FD);
+        Jobs.stop();
+        return;
+      }
+      Jobs.offer(FD);
+    }
+  });
+
+  IntrusiveRefCntPtr<FileManager> FileMgr;
+  IntrusiveRefCntPtr<InMemoryModuleCache> ModuleCache;
+  std::string CachedWorkingDir;
+  std::vector<std::string> ModuleCachePaths;
+  bool Crashed = false;
+  while (!Crashed) {
+    int FD = Jobs.next();
+    if (FD < 0)
+      break;
+    Connection Conn(FD);
+    Conn.setReadTimeout(RequestTimeoutSeconds);
+
+    std::vector<std::string> Request;
+    if (!Conn.receive(Request))
+      continue;
+    if (Request.size() < 3 || Request[0] != ProtocolVersion ||
+        Request[1] != getClangFullVersion() ||
+        !canRunInServer(ArrayRef<std::string>(Request).drop_front(3)) ||
+        llvm::sys::fs::set_current_path(Request[2])) {
+      Conn.send({"declined"});
+      continue;
+    }
+
+    // Module caches are written by the jobs themselves and the PCMs in them
+    // are validated when they are loaded, so changes there don't matter.
+    for (const std::string &Arg : ArrayRef<std::string>(Request).drop_front(3)) {
+      StringRef Path = Arg;
+      if (!Path.consume_front("-fmodules-cache-path="))
+        continue;
+      SmallString<256> AbsPath(Path);
+      llvm::sys::fs::make_absolute(Request[2], AbsPath);
+      llvm::sys::path::remove_dots(AbsPath, /*remove_dot_dot=*/true);
+      if (!llvm::is_contained(ModuleCachePaths, AbsPath))
+        ModuleCachePaths.push_back(std::string(AbsPath));
+    }
+
+    // Relative paths in the file manager are relative to the working
+    // directory, so start over if it changed. Otherwise only forget the files
+    // that changed since the earlier jobs looked them up. The loaded PCMs may
+    // depend on any of them, so they are dropped as soon as one did.
+    if (!FileMgr || Request[2] != CachedWorkingDir) {
+      FileMgr = new FileManager(FileSystemOptions());
+      ModuleCache = new InMemoryModuleCache();
+      CachedWorkingDir = Request[2];
+    } else if (FileMgr->dropStaleEntries(ModuleCachePaths)) {
+      ModuleCache = new InMemoryModuleCache();
+    }
+
+    SmallVector<const char *, 128> Args;
+    for (const std::string &Arg : ArrayRef<std::string>(Request).drop_front(3))
+      Args.push_back(Arg.c_str());
+
+    int Res = 0;
+    std::string Out, Err;
+    {
+      OutputCapture CaptureOut(STDOUT_FILENO), CaptureErr(STDERR_FILENO);
+      if (!CaptureOut.isValid() || !CaptureErr.isValid()) {
+        Conn.send({"declined"});
+        continue;
+      }
+
+      // Options left behind by the previous job.
+      llvm::cl::ResetAllOptionOccurrences();
+
+      llvm::CrashRecoveryContext CRC;
+      CRC.DumpStackAndCleanupOnFailure = true;
+      const void *PrettyState = llvm::SavePrettyStackState();
+      if (!CRC.RunSafely([&]() {
+            Res = cc1_main(Args, Argv0, MainAddr, FileMgr.get(),
+                           ModuleCache.get());
+          })) {
+        llvm::RestorePrettyStackState(PrettyState);
+        Res = CRC.RetCode;
+        Crashed = true;
+      }
+
+      llvm::outs().flush();
+      llvm::errs().flush();
+      Out = CaptureOut.take();
+      Err = CaptureErr.take();
+    }
+    Conn.send({"ok", llvm::itostr(Res), std::move(Out), std::move(Err)});
+  }
+
+  // Wake up the listening thread with a connection of our own.
+  Jobs.stop();
+  int WakeFD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (WakeFD >= 0) {
+    llvm::sys::RetryAfterSignal(-1, ::connect, WakeFD,
+                                reinterpret_cast<sockaddr *>(&Addr),
+                                sizeof(Addr));
+    ::close(WakeFD);
+  }
+  Listener.join();
+
+  ::close(ListenFD);
+  ::unlink(Addr.sun_path);
+  return Crashed ? 1 : 0;
+#else
+  llvm::errs() << "error: -cc1server is not supported on this platform\n";
+  return 1;
+#endif
+}
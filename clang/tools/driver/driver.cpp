@@ -211,6 +211,13 @@ extern int cc1as_main(ArrayRef<const char *> Argv, const char *Argv0,
                       void *MainAddr);
 extern int cc1gen_reproducer_main(ArrayRef<const char *> Argv,
                                   const char *Argv0, void *MainAddr);
+extern int cc1server_main(ArrayRef<const char *> Argv, const char *Argv0,
+                          void *MainAddr);
+extern bool cc1server_execute(StringRef SocketPath, ArrayRef<const char *> Argv,
+                              int &Res);
+
+/// The compiler server that -cc1 jobs are sent to, from -fcc1-server=.
+static std::string CC1ServerPath;
 
 static void insertTargetAndModeArgs(const ParsedClangName &NameParts,
                                     SmallVectorImpl<const char *> &ArgVector,
@@ -349,14 +356,22 @@ static int ExecuteCC1Tool(SmallVectorImpl<const char *> &ArgV) {
   }
   StringRef Tool = ArgV[1];
   void *GetExecutablePathVP = (void *)(intptr_t)GetExecutablePath;
-  if (Tool == "-cc1")
+  if (Tool == "-cc1") {
+    int Res;
+    if (!CC1ServerPath.empty() &&
+        cc1server_execute(CC1ServerPath, makeArrayRef(ArgV).slice(1), Res))
+      return Res;
     return cc1_main(makeArrayRef(ArgV).slice(1), ArgV[0], GetExecutablePathVP);
+  }
   if (Tool == "-cc1as")
     return cc1as_main(makeArrayRef(ArgV).slice(2), ArgV[0],
                       GetExecutablePathVP);
   if (Tool == "-cc1gen-reproducer")
     return cc1gen_reproducer_main(makeArrayRef(ArgV).slice(2), ArgV[0],
                                   GetExecutablePathVP);
+  if (Tool == "-cc1server")
+    return cc1server_main(makeArrayRef(ArgV).slice(2), ArgV[0],
+                          GetExecutablePathVP);
   // Reject unknown tools.
   llvm::errs() << "error: unknown integrated tool '" << Tool << "'. "
                << "Valid tools include '-cc1' and '-cc1as'.\n";
@@ -486,6 +501,14 @@ int clang_main(int Argc, char **Argv) {
                            .Case("-fintegrated-cc1", false)
                            .Default(UseNewCC1Process);
 
+  // Jobs for a compiler server are sent from ExecuteCC1Tool(), which is only
+  // used for in-process jobs.
+  for (const char *Arg : Args)
+    if (Arg && StringRef(Arg).startswith("-fcc1-server="))
+      CC1ServerPath = StringRef(Arg).drop_front(strlen("-fcc1-server="));
+  if (!CC1ServerPath.empty())
+    UseNewCC1Process = false;
+
   IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts =
       CreateAndPopulateDiagOpts(Args);
 
@@ -216,6 +216,36 @@ TEST(MatchFinder, CheckProfiling) {
   EXPECT_EQ("MyID", Records.begin()->getKey());
 }
 
+TEST(MatchFinder, MatcherProfiling) {
+  MatchFinder::MatchFinderOptions Options;
+  llvm::StringMap<llvm::TimeRecord> Records;
+  llvm::StringMap<MatchFinder::MatchFinderOptions::Profiling::MatcherRecord>
+      MatcherRecords;
+  Options.CheckProfiling.emplace(Records);
+  Options.CheckProfiling->MatcherRecords = &MatcherRecords;
+  MatchFinder Finder(std::move(Options));
+
+  struct NamedCallback : public MatchFinder::MatchCallback {
+    void run(const MatchFinder::MatchResult &Result) override {}
+    StringRef getID() const override { return "MyID"; }
+  } Callback;
+  Finder.addMatcher(varDecl(), &Callback);
+  Finder.addMatcher(varDecl(hasName("y")), &Callback);
+  Finder.addMatcher(functionDecl(), &Callback);
+  std::unique_ptr<FrontendActionFactory> Factory(
+      newFrontendActionFactory(&Finder));
+  ASSERT_TRUE(
+      tooling::runToolOnCode(Factory->create(), "int x; int y; void f();"));
+
+  EXPECT_EQ(3u, MatcherRecords.size());
+  // Matchers are only tried on nodes of the kind they are restricted to.
+  EXPECT_EQ(2u, MatcherRecords["MyID.VarDecl.1"].Invocations);
+  EXPECT_EQ(2u, MatcherRecords["MyID.VarDecl.1"].Matches);
+  EXPECT_EQ(2u, MatcherRecords["MyID.VarDecl.2"].Invocations);
+  EXPECT_EQ(1u, MatcherRecords["MyID.VarDecl.2"].Matches);
+  EXPECT_EQ(1u, MatcherRecords["MyID.FunctionDecl.1"].Matches);
+}
+
 class VerifyStartOfTranslationUnit : public MatchFinder::MatchCallback {
 public:
   VerifyStartOfTranslationUnit() : Called(false) {}
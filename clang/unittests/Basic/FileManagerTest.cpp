@@ -10,6 +10,7 @@
 #include "clang/Basic/FileSystemOptions.h"
 #include "clang/Basic/FileSystemStatCache.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Testing/Support/Error.h"
@@ -557,4 +558,70 @@ TEST_F(FileManagerTest, getBypassFile) {
   EXPECT_EQ(&FE, &SearchRef->getFileEntry());
 }
 
+/// Reports a different modification time for the files in \c Touched.
+class TouchingFileSystem : public llvm::vfs::ProxyFileSystem {
+public:
+  using ProxyFileSystem::ProxyFileSystem;
+
+  llvm::ErrorOr<llvm::vfs::Status> status(const Twine &Path) override {
+    llvm::ErrorOr<llvm::vfs::Status> Status = ProxyFileSystem::status(Path);
+    if (!Status || !Touched.count(Path.str()))
+      return Status;
+    return llvm::vfs::Status(
+        Status->getName(), Status->getUniqueID(),
+        Status->getLastModificationTime() + std::chrono::nanoseconds(1),
+        Status->getUser(), Status->getGroup(), Status->getSize(),
+        Status->getType(), Status->getPermissions());
+  }
+
+  llvm::StringSet<> Touched;
+};
+
+TEST_F(FileManagerTest, dropStaleEntries) {
+  auto MemFS = makeIntrusiveRefCnt<llvm::vfs::InMemoryFileSystem>();
+  MemFS->addFile("/tmp/a.h", 0, llvm::MemoryBuffer::getMemBuffer("int a;"));
+  MemFS->addFile("/tmp/c.h", 0, llvm::MemoryBuffer::getMemBuffer("int c;"));
+  MemFS->addFile("/cache/m.pcm", 0, llvm::MemoryBuffer::getMemBuffer("pcm"));
+  auto FS = makeIntrusiveRefCnt<TouchingFileSystem>(MemFS);
+
+  FileSystemOptions Opts;
+  FileManager Manager(Opts, FS);
+  auto A = Manager.getFile("/tmp/a.h");
+  auto C = Manager.getFile("/tmp/c.h");
+  auto PCM = Manager.getFile("/cache/m.pcm");
+  ASSERT_TRUE(A && C && PCM);
+  EXPECT_FALSE(Manager.getFile("/tmp/b.h"));
+  EXPECT_FALSE(Manager.getDirectory("/usr"));
+  EXPECT_EQ(0u, Manager.dropStaleEntries());
+  EXPECT_EQ(*A, *Manager.getFile("/tmp/a.h"));
+
+  // A file that was missing shows up. Only its own entry is dropped.
+  MemFS->addFile("/tmp/b.h", 0, llvm::MemoryBuffer::getMemBuffer("int b;"));
+  EXPECT_EQ(1u, Manager.dropStaleEntries());
+  EXPECT_TRUE(Manager.getFile("/tmp/b.h"));
+  EXPECT_EQ(*A, *Manager.getFile("/tmp/a.h"));
+
+  // A file that was found changes within the same second.
+  FS->Touched.insert("/tmp/a.h");
+  EXPECT_EQ(1u, Manager.dropStaleEntries());
+  auto NewA = Manager.getFile("/tmp/a.h");
+  ASSERT_TRUE(NewA);
+  EXPECT_NE(*A, *NewA);
+  EXPECT_EQ(0u, Manager.dropStaleEntries());
+  EXPECT_EQ(*C, *Manager.getFile("/tmp/c.h"));
+
+  // Entries in skipped directories are forgotten without counting as changes.
+  FS->Touched.insert("/cache/m.pcm");
+  EXPECT_EQ(0u, Manager.dropStaleEntries({std::string("/cache")}));
+  EXPECT_NE(*PCM, *Manager.getFile("/cache/m.pcm"));
+  EXPECT_EQ(*C, *Manager.getFile("/tmp/c.h"));
+
+  // A directory that was found disappears, and so do the files in it.
+  auto EmptyFS = makeIntrusiveRefCnt<llvm::vfs::InMemoryFileSystem>();
+  Manager.setVirtualFileSystem(EmptyFS);
+  EXPECT_NE(0u, Manager.dropStaleEntries());
+  EXPECT_FALSE(Manager.getFile("/tmp/c.h"));
+  EXPECT_FALSE(Manager.getDirectory("/tmp"));
+}
+
 } // anonymous namespace
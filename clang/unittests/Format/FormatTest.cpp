@@ -4217,6 +4217,15 @@ TEST_F(FormatTest, NamespaceMacros) {
                "int foo();\n"
                "} // TESTSUITE(A)",
                Style);
+  EXPECT_EQ("TESTSUITE(A) {\n"
+            "int foo();\n"
+            "int bar();\n"
+            "} // TESTSUITE(A)",
+            format("TESTSUITE(A) {\n"
+                   "int foo();\n"
+                   "int bar();\n"
+                   "}",
+                   Style));
 
   // Properly indent according to NamespaceIndentation style
   Style.NamespaceIndentation = FormatStyle::NI_All;
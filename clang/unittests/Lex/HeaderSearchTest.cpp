@@ -222,6 +222,40 @@ TEST_F(HeaderSearchTest, HeaderFrameworkLookup) {
   EXPECT_EQ(Search.getIncludeNameForHeader(FE), "Foo/Foo.h");
 }
 
+TEST_F(HeaderSearchTest, IndexSearchDirectories) {
+  Search.getHeaderSearchOpts().IndexSearchDirectories = true;
+  addSearchDir("/a");
+  addSearchDir("/b");
+  VFS->addFile("/a/foo.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+  VFS->addFile("/b/x/y.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+
+  auto DirA = FileMgr.getOptionalDirectoryRef("/a");
+  auto DirB = FileMgr.getOptionalDirectoryRef("/b");
+  ASSERT_TRUE(DirA && DirB);
+  EXPECT_TRUE(Search.mayContainFile(*DirA, "foo.h"));
+  EXPECT_FALSE(Search.mayContainFile(*DirA, "x/y.h"));
+  EXPECT_TRUE(Search.mayContainFile(*DirB, "x/y.h"));
+  // The index is conservative about case and never rejects relative paths.
+  EXPECT_TRUE(Search.mayContainFile(*DirB, "X/Y.H"));
+  EXPECT_TRUE(Search.mayContainFile(*DirA, "../b/x/y.h"));
+
+  auto Lookup = [&](StringRef Filename) {
+    return Search.LookupFile(
+        Filename, SourceLocation(), /*isAngled=*/false, /*FromDir=*/nullptr,
+        /*CurDir=*/nullptr, /*Includers=*/{}, /*SearchPath=*/nullptr,
+        /*RelativePath=*/nullptr, /*RequestingModule=*/nullptr,
+        /*SuggestedModule=*/nullptr, /*IsMapped=*/nullptr,
+        /*IsFrameworkFound=*/nullptr);
+  };
+  auto Foo = Lookup("foo.h");
+  ASSERT_TRUE(Foo.has_value());
+  EXPECT_EQ(Foo->getName(), "/a/foo.h");
+  auto Y = Lookup("x/y.h");
+  ASSERT_TRUE(Y.has_value());
+  EXPECT_EQ(Y->getName(), "/b/x/y.h");
+  EXPECT_FALSE(Lookup("missing.h").has_value());
+}
+
 // Helper struct with null terminator character to make MemoryBuffer happy.
 template <class FileTy, class PaddingTy>
 struct NullTerminatedFile : public FileTy {
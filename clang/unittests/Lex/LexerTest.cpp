@@ -423,6 +423,28 @@ TEST_F(LexerTest, HandlesSplitTokens) {
   EXPECT_TRUE(range.isInvalid());
 }
 
+TEST_F(LexerTest, LongRunsCrossingVectorChunks) {
+  // Identifiers, whitespace and line comments long enough to be skipped in
+  // several 16-byte chunks, each ending at an awkward spot.
+  std::string Ident = std::string(37, 'a') + "Z_09" + std::string(30, 'b');
+  std::string Source =
+      Ident + std::string(35, ' ') + "\t\f\v+" + std::string(17, ' ') +
+      "// " + std::string(40, 'c') + "\xc3\xa9" + std::string(20, 'd') +
+      " \\\n continued comment " + std::string(16, 'e') + "\n" +
+      Ident + "-" + std::string(16, '\t') + Ident + "// trailing";
+  std::vector<Token> toks =
+      CheckLex(Source, {tok::identifier, tok::plus, tok::identifier,
+                        tok::minus, tok::identifier});
+  ASSERT_EQ(toks.size(), 5u);
+  EXPECT_EQ(PP->getSpelling(toks[0]), Ident);
+  EXPECT_EQ(PP->getSpelling(toks[2]), Ident);
+  EXPECT_EQ(PP->getSpelling(toks[4]), Ident);
+  EXPECT_TRUE(toks[1].hasLeadingSpace());
+  EXPECT_TRUE(toks[2].isAtStartOfLine());
+  EXPECT_FALSE(toks[3].hasLeadingSpace());
+  EXPECT_TRUE(toks[4].hasLeadingSpace());
+}
+
 TEST_F(LexerTest, DontMergeMacroArgsFromDifferentMacroFiles) {
   std::vector<Token> toks =
       Lex("#define helper1 0\n"
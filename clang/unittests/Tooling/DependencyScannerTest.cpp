@@ -13,7 +13,9 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/FrontendActions.h"
+#include "clang/Lex/DependencyDirectivesScanner.h"
 #include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/DependencyScanning/DependencyDirectivesDiskCache.h"
 #include "clang/Tooling/DependencyScanning/DependencyScanningTool.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/STLExtras.h"
@@ -22,6 +24,7 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Testing/Support/Error.h"
+#include "llvm/Testing/Support/SupportHelpers.h"
 #include "gtest/gtest.h"
 #include <algorithm>
 #include <string>
@@ -239,3 +242,37 @@ TEST(DependencyScanner, ScanDepsWithFS) {
   EXPECT_EQ(convert_to_slash(DepFile),
             "test.cpp.o: /root/test.cpp /root/header.h\n");
 }
+
+TEST(DependencyScanner, DirectivesDiskCacheRoundTrip) {
+  llvm::unittest::TempDir CacheDir("directives-cache", /*Unique=*/true);
+  DependencyDirectivesDiskCache Cache(CacheDir.path());
+
+  StringRef Source = "#include \"a.h\"\n"
+                     "#ifdef FOO\n"
+                     "#define BAR 1\n"
+                     "#endif\n"
+                     "int x;\n";
+  SmallVector<dependency_directives_scan::Token> ScannedTokens;
+  SmallVector<dependency_directives_scan::Directive> ScannedDirectives;
+  ASSERT_FALSE(scanSourceForDependencyDirectives(Source, ScannedTokens,
+                                                 ScannedDirectives));
+
+  SmallVector<dependency_directives_scan::Token> Tokens;
+  SmallVector<dependency_directives_scan::Directive> Directives;
+  EXPECT_FALSE(Cache.lookup(Source, Tokens, Directives));
+
+  Cache.store(Source, ScannedTokens, ScannedDirectives);
+  ASSERT_TRUE(Cache.lookup(Source, Tokens, Directives));
+
+  std::string Expected, Actual;
+  llvm::raw_string_ostream ExpectedOS(Expected), ActualOS(Actual);
+  printDependencyDirectivesAsSource(Source, ScannedDirectives, ExpectedOS);
+  printDependencyDirectivesAsSource(Source, Directives, ActualOS);
+  EXPECT_EQ(Expected, Actual);
+  ASSERT_EQ(Directives.size(), ScannedDirectives.size());
+  for (unsigned I = 0, E = Directives.size(); I != E; ++I)
+    EXPECT_EQ(Directives[I].Kind, ScannedDirectives[I].Kind);
+
+  // Entries are keyed by contents, so a modified file must miss the cache.
+  EXPECT_FALSE(Cache.lookup("#include \"b.h\"\n", Tokens, Directives));
+}
@@ -22,6 +22,7 @@
 #include "lld/Common/Strings.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Demangle/Demangle.h"
+#include "llvm/Support/Parallel.h"
 
 using namespace llvm;
 using namespace llvm::object;
@@ -137,23 +138,35 @@ static bool canBeVersioned(const Symbol &sym) {
 // other than trying to match a pattern against all demangled symbols.
 // So, if "extern C++" feature is used, we need to demangle all known
 // symbols.
+//
+// Demangling dominates the cost, so the names are demangled and hashed in
+// parallel, and then inserted in symbol order to keep the map deterministic.
 StringMap<SmallVector<Symbol *, 0>> &SymbolTable::getDemangledSyms() {
   if (!demangledSyms) {
     demangledSyms.emplace();
-    std::string demangled;
+    SmallVector<Symbol *, 0> syms;
     for (Symbol *sym : symVector)
-      if (canBeVersioned(*sym)) {
-        StringRef name = sym->getName();
-        size_t pos = name.find('@');
-        if (pos == std::string::npos)
-          demangled = demangle(name.str());
-        else if (pos + 1 == name.size() || name[pos + 1] == '@')
-          demangled = demangle(name.substr(0, pos).str());
-        else
-          demangled =
-              (demangle(name.substr(0, pos).str()) + name.substr(pos)).str();
-        (*demangledSyms)[demangled].push_back(sym);
-      }
+      if (canBeVersioned(*sym))
+        syms.push_back(sym);
+
+    SmallVector<std::pair<std::string, uint32_t>, 0> names(syms.size());
+    parallelFor(0, syms.size(), [&](size_t i) {
+      StringRef name = syms[i]->getName();
+      std::string &demangled = names[i].first;
+      size_t pos = name.find('@');
+      if (pos == std::string::npos)
+        demangled = demangle(name.str());
+      else if (pos + 1 == name.size() || name[pos + 1] == '@')
+        demangled = demangle(name.substr(0, pos).str());
+      else
+        demangled =
+            (demangle(name.substr(0, pos).str()) + name.substr(pos)).str();
+      names[i].second = StringMapImpl::hash(demangled);
+    });
+
+    for (size_t i = 0, e = syms.size(); i != e; ++i)
+      demangledSyms->try_emplace_with_hash(names[i].first, names[i].second)
+          .first->second.push_back(syms[i]);
   }
   return *demangledSyms;
 }
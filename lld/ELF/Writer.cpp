@@ -20,7 +20,6 @@
 #include "Symbols.h"
 #include "SyntheticSections.h"
 #include "Target.h"
-#include "lld/Common/Arrays.h"
 #include "lld/Common/CommonLinkerContext.h"
 #include "lld/Common/Filesystem.h"
 #include "lld/Common/Strings.h"
@@ -2901,27 +2900,6 @@ template <class ELFT> void Writer<ELFT>::writeSections() {
   }
 }
 
-// Computes a hash value of Data using a given hash function.
-// In order to utilize multiple cores, we first split data into 1MB
-// chunks, compute a hash for each chunk, and then compute a hash value
-// of the hash values.
-static void
-computeHash(llvm::MutableArrayRef<uint8_t> hashBuf,
-            llvm::ArrayRef<uint8_t> data,
-            std::function<void(uint8_t *dest, ArrayRef<uint8_t> arr)> hashFn) {
-  std::vector<ArrayRef<uint8_t>> chunks = split(data, 1024 * 1024);
-  const size_t hashesSize = chunks.size() * hashBuf.size();
-  std::unique_ptr<uint8_t[]> hashes(new uint8_t[hashesSize]);
-
-  // Compute hash values.
-  parallelFor(0, chunks.size(), [&](size_t i) {
-    hashFn(hashes.get() + i * hashBuf.size(), chunks[i]);
-  });
-
-  // Write to the final output buffer.
-  hashFn(hashBuf.data(), makeArrayRef(hashes.get(), hashesSize));
-}
-
 template <class ELFT> void Writer<ELFT>::writeBuildId() {
   if (!mainPart->buildId || !mainPart->buildId->getParent())
     return;
@@ -2932,7 +2910,9 @@ template <class ELFT> void Writer<ELFT>::writeBuildId() {
     return;
   }
 
-  // Compute a hash of all sections of the output file.
+  // Compute a hash of all sections of the output file. In order to utilize
+  // multiple cores, parallelHash hashes 1MB chunks in parallel and then the
+  // hashes of the chunks.
   size_t hashSize = mainPart->buildId->hashSize;
   std::unique_ptr<uint8_t[]> buildId(new uint8_t[hashSize]);
   MutableArrayRef<uint8_t> output(buildId.get(), hashSize);
@@ -2946,17 +2926,17 @@ template <class ELFT> void Writer<ELFT>::writeBuildId() {
   // efficient BLAKE3.
   switch (config->buildId) {
   case BuildIdKind::Fast:
-    computeHash(output, input, [](uint8_t *dest, ArrayRef<uint8_t> arr) {
-      write64le(dest, xxHash64(arr));
+    parallelHash(output, input, [](uint8_t *dest, ArrayRef<uint8_t> arr) {
+      write64le(dest, xxh3_64bits(arr));
     });
     break;
   case BuildIdKind::Md5:
-    computeHash(output, input, [&](uint8_t *dest, ArrayRef<uint8_t> arr) {
+    parallelHash(output, input, [&](uint8_t *dest, ArrayRef<uint8_t> arr) {
       memcpy(dest, BLAKE3::hash<16>(arr).data(), hashSize);
     });
     break;
   case BuildIdKind::Sha1:
-    computeHash(output, input, [&](uint8_t *dest, ArrayRef<uint8_t> arr) {
+    parallelHash(output, input, [&](uint8_t *dest, ArrayRef<uint8_t> arr) {
       memcpy(dest, BLAKE3::hash<20>(arr).data(), hashSize);
     });
     break;
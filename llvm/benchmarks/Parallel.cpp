@@ -0,0 +1,86 @@
+#include "benchmark/benchmark.h"
+#include "llvm/Support/Parallel.h"
+#include <atomic>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+// Many items with little work each, as in the parallel loops of lld.
+static void BM_ParallelForFineGrained(benchmark::State &State) {
+  std::vector<uint64_t> Values(State.range(0));
+  for (auto _ : State) {
+    parallelFor(0, Values.size(), [&](size_t I) { Values[I] += I * I; });
+    benchmark::DoNotOptimize(Values.data());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_ParallelForFineGrained)->Range(1 << 10, 1 << 20);
+
+// A parallel loop whose body runs another parallel loop.
+static void BM_ParallelForNested(benchmark::State &State) {
+  std::vector<uint64_t> Values(State.range(0) * State.range(0));
+  for (auto _ : State) {
+    parallelFor(0, State.range(0), [&](size_t I) {
+      parallelFor(0, State.range(0), [&](size_t J) {
+        Values[I * State.range(0) + J] += I ^ J;
+      });
+    });
+    benchmark::DoNotOptimize(Values.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Values.size());
+}
+BENCHMARK(BM_ParallelForNested)->Range(16, 1024);
+
+// One task for each item, spawned by the calling thread.
+static void BM_TaskGroupSpawn(benchmark::State &State) {
+  for (auto _ : State) {
+    std::atomic<uint64_t> Sum{0};
+    {
+      parallel::TaskGroup TG;
+      for (int64_t I = 0; I < State.range(0); ++I)
+        TG.spawn([&Sum, I] { Sum += I; });
+    }
+    benchmark::DoNotOptimize(Sum.load());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_TaskGroupSpawn)->Range(1 << 8, 1 << 16);
+
+// Recursive fork/join, where tasks spawn tasks.
+static uint64_t fib(unsigned N) {
+  if (N < 16)
+    return N < 2 ? N : fib(N - 1) + fib(N - 2);
+  uint64_t A, B;
+  {
+    parallel::TaskGroup TG;
+    TG.spawn([&] { A = fib(N - 1); });
+    B = fib(N - 2);
+  }
+  return A + B;
+}
+
+static void BM_TaskGroupRecursive(benchmark::State &State) {
+  for (auto _ : State)
+    benchmark::DoNotOptimize(fib(State.range(0)));
+}
+BENCHMARK(BM_TaskGroupRecursive)->DenseRange(20, 28, 4);
+
+static void BM_ParallelSort(benchmark::State &State) {
+  std::vector<uint32_t> Input(State.range(0));
+  std::mt19937 Engine;
+  for (uint32_t &V : Input)
+    V = Engine();
+  for (auto _ : State) {
+    State.PauseTiming();
+    std::vector<uint32_t> Values = Input;
+    State.ResumeTiming();
+    parallelSort(Values.begin(), Values.end());
+    benchmark::DoNotOptimize(Values.data());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_ParallelSort)->Range(1 << 12, 1 << 22);
+
+BENCHMARK_MAIN();
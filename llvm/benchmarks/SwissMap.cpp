@@ -0,0 +1,95 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SwissMap.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+// Pointer keys spread over the heap in allocation order, as in the maps keyed
+// by Value * or SCEV *.
+static std::vector<int *> makeKeys(size_t N,
+                                   std::vector<std::unique_ptr<int>> &Storage) {
+  std::vector<int *> Keys;
+  for (size_t I = 0; I < N; ++I) {
+    Storage.push_back(std::make_unique<int>(I));
+    Keys.push_back(Storage.back().get());
+  }
+  return Keys;
+}
+
+template <typename MapT> static void BM_Insert(benchmark::State &State) {
+  std::vector<std::unique_ptr<int>> Storage;
+  std::vector<int *> Keys = makeKeys(State.range(0), Storage);
+  for (auto _ : State) {
+    MapT Map;
+    for (int *K : Keys)
+      Map[K] = 1;
+    benchmark::DoNotOptimize(Map.size());
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+
+template <typename MapT> static void BM_LookupHit(benchmark::State &State) {
+  std::vector<std::unique_ptr<int>> Storage;
+  std::vector<int *> Keys = makeKeys(State.range(0), Storage);
+  MapT Map;
+  for (int *K : Keys)
+    Map[K] = 1;
+  std::shuffle(Keys.begin(), Keys.end(), std::mt19937(0));
+  for (auto _ : State) {
+    unsigned Sum = 0;
+    for (int *K : Keys)
+      Sum += Map.find(K)->second;
+    benchmark::DoNotOptimize(Sum);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+
+template <typename MapT> static void BM_LookupMiss(benchmark::State &State) {
+  std::vector<std::unique_ptr<int>> Storage;
+  std::vector<int *> Keys = makeKeys(State.range(0) * 2, Storage);
+  MapT Map;
+  for (size_t I = 0; I < Keys.size(); I += 2)
+    Map[Keys[I]] = 1;
+  for (auto _ : State) {
+    unsigned Count = 0;
+    for (size_t I = 1; I < Keys.size(); I += 2)
+      Count += Map.count(Keys[I]);
+    benchmark::DoNotOptimize(Count);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size() / 2);
+}
+
+// A sliding window of keys, as in maps of worklists or scopes.
+template <typename MapT> static void BM_EraseInsert(benchmark::State &State) {
+  std::vector<std::unique_ptr<int>> Storage;
+  size_t Window = State.range(0);
+  std::vector<int *> Keys = makeKeys(Window * 4, Storage);
+  for (auto _ : State) {
+    MapT Map;
+    for (size_t I = 0; I < Keys.size(); ++I) {
+      Map[Keys[I]] = 1;
+      if (I >= Window)
+        Map.erase(Keys[I - Window]);
+    }
+    benchmark::DoNotOptimize(Map.size());
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+
+using PtrDenseMap = DenseMap<int *, unsigned>;
+using PtrSwissMap = SwissMap<int *, unsigned>;
+
+BENCHMARK_TEMPLATE(BM_Insert, PtrDenseMap)->Range(1 << 6, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, PtrSwissMap)->Range(1 << 6, 1 << 20);
+BENCHMARK_TEMPLATE(BM_LookupHit, PtrDenseMap)->Range(1 << 6, 1 << 20);
+BENCHMARK_TEMPLATE(BM_LookupHit, PtrSwissMap)->Range(1 << 6, 1 << 20);
+BENCHMARK_TEMPLATE(BM_LookupMiss, PtrDenseMap)->Range(1 << 6, 1 << 20);
+BENCHMARK_TEMPLATE(BM_LookupMiss, PtrSwissMap)->Range(1 << 6, 1 << 20);
+BENCHMARK_TEMPLATE(BM_EraseInsert, PtrDenseMap)->Range(1 << 6, 1 << 16);
+BENCHMARK_TEMPLATE(BM_EraseInsert, PtrSwissMap)->Range(1 << 6, 1 << 16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,88 @@
+#include "benchmark/benchmark.h"
+#include "llvm/Support/BLAKE3.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/xxhash.h"
+#include <vector>
+
+using namespace llvm;
+
+static std::vector<uint8_t> makeData(size_t Size) {
+  std::vector<uint8_t> Data(Size);
+  for (size_t I = 0; I < Size; ++I)
+    Data[I] = I * 31 + (I >> 8);
+  return Data;
+}
+
+static void BM_xxHash64(benchmark::State &State) {
+  std::vector<uint8_t> Data = makeData(State.range(0));
+  for (auto _ : State)
+    benchmark::DoNotOptimize(xxHash64(Data));
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+
+static void BM_xxh3_64bits(benchmark::State &State) {
+  std::vector<uint8_t> Data = makeData(State.range(0));
+  for (auto _ : State)
+    benchmark::DoNotOptimize(xxh3_64bits(Data));
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+
+static void BM_xxh3_128bits(benchmark::State &State) {
+  std::vector<uint8_t> Data = makeData(State.range(0));
+  for (auto _ : State)
+    benchmark::DoNotOptimize(xxh3_128bits(Data));
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+
+static void BM_BLAKE3(benchmark::State &State) {
+  std::vector<uint8_t> Data = makeData(State.range(0));
+  for (auto _ : State)
+    benchmark::DoNotOptimize(BLAKE3::hash(Data));
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+
+static void BM_SHA1(benchmark::State &State) {
+  std::vector<uint8_t> Data = makeData(State.range(0));
+  for (auto _ : State)
+    benchmark::DoNotOptimize(SHA1::hash(Data));
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+
+// Hashing an output file for lld's --build-id=fast.
+static void BM_ParallelHash_xxh3(benchmark::State &State) {
+  std::vector<uint8_t> Data = makeData(State.range(0));
+  uint8_t Hash[8];
+  for (auto _ : State) {
+    parallelHash(Hash, Data, [](uint8_t *Dest, ArrayRef<uint8_t> Bytes) {
+      support::endian::write64le(Dest, xxh3_64bits(Bytes));
+    });
+    benchmark::DoNotOptimize(Hash);
+  }
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+
+// Hashing an output file for lld's --build-id=sha1.
+static void BM_ParallelHash_BLAKE3(benchmark::State &State) {
+  std::vector<uint8_t> Data = makeData(State.range(0));
+  uint8_t Hash[20];
+  for (auto _ : State) {
+    parallelHash(Hash, Data, [](uint8_t *Dest, ArrayRef<uint8_t> Bytes) {
+      BLAKE3Result<20> Result = BLAKE3::hash<20>(Bytes);
+      std::copy(Result.begin(), Result.end(), Dest);
+    });
+    benchmark::DoNotOptimize(Hash);
+  }
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+
+BENCHMARK(BM_xxHash64)->Range(8, 1 << 20);
+BENCHMARK(BM_xxh3_64bits)->Range(8, 1 << 20);
+BENCHMARK(BM_xxh3_128bits)->Range(8, 1 << 20);
+BENCHMARK(BM_BLAKE3)->Range(8, 1 << 20);
+BENCHMARK(BM_SHA1)->Range(8, 1 << 20);
+BENCHMARK(BM_ParallelHash_xxh3)->Arg(64 << 20);
+BENCHMARK(BM_ParallelHash_BLAKE3)->Arg(64 << 20);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,133 @@
+//===- ConcurrentStringMap.h - Thread-safe sharded StringMap ----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file defines ConcurrentStringMap, a StringMap that can be used from
+/// several threads at once.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_CONCURRENTSTRINGMAP_H
+#define LLVM_ADT_CONCURRENTSTRINGMAP_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+namespace llvm {
+
+/// ConcurrentStringMap - An insert-only StringMap that can be shared between
+/// threads, e.g. as a symbol or uniquing table filled by parallel workers.
+///
+/// The keys are split between a number of shards by their hash, each shard
+/// being a StringMap with its own mutex and allocator, so threads only contend
+/// when they access keys of the same shard. Entries are never moved or
+/// removed, so the pointers returned by try_emplace() and find() stay valid
+/// as long as the map. Accessing the values they point to is not synchronized
+/// by the map.
+template <typename ValueTy, typename AllocatorTy = MallocAllocator>
+class ConcurrentStringMap {
+public:
+  using MapEntryTy = StringMapEntry<ValueTy>;
+
+  /// Creates a map with \p NumShards shards, rounded up to a power of two.
+  explicit ConcurrentStringMap(unsigned NumShards = 64)
+      : ShardBits(Log2_32_Ceil(std::max(NumShards, 1u))),
+        Shards(new Shard[1u << ShardBits]) {}
+
+  ConcurrentStringMap(const ConcurrentStringMap &) = delete;
+  ConcurrentStringMap &operator=(const ConcurrentStringMap &) = delete;
+
+  /// Inserts a new entry for \p Key constructed from \p Args if the key isn't
+  /// already in the map. Returns the entry of the key and whether it was
+  /// inserted.
+  template <typename... ArgsTy>
+  std::pair<MapEntryTy *, bool> try_emplace(StringRef Key, ArgsTy &&...Args) {
+    return try_emplace_with_hash(Key, StringMapImpl::hash(Key),
+                                 std::forward<ArgsTy>(Args)...);
+  }
+
+  /// Like try_emplace, but takes the precomputed StringMapImpl::hash(Key).
+  template <typename... ArgsTy>
+  std::pair<MapEntryTy *, bool> try_emplace_with_hash(StringRef Key,
+                                                      uint32_t FullHashValue,
+                                                      ArgsTy &&...Args) {
+    Shard &S = getShard(FullHashValue);
+    std::lock_guard<std::mutex> Lock(S.Mutex);
+    auto Result = S.Map.try_emplace_with_hash(Key, FullHashValue,
+                                              std::forward<ArgsTy>(Args)...);
+    return {&*Result.first, Result.second};
+  }
+
+  /// Returns the entry for \p Key, or null if the key is not in the map.
+  MapEntryTy *find(StringRef Key) const {
+    return find(Key, StringMapImpl::hash(Key));
+  }
+
+  /// Overload that explicitly takes precomputed StringMapImpl::hash(Key).
+  MapEntryTy *find(StringRef Key, uint32_t FullHashValue) const {
+    Shard &S = getShard(FullHashValue);
+    std::lock_guard<std::mutex> Lock(S.Mutex);
+    auto I = S.Map.find(Key, FullHashValue);
+    return I == S.Map.end() ? nullptr : &*I;
+  }
+
+  bool contains(StringRef Key) const { return find(Key) != nullptr; }
+
+  /// Returns the number of entries. The result is only exact if no other
+  /// thread inserts concurrently.
+  size_t size() const {
+    size_t Size = 0;
+    for (Shard &S : shards()) {
+      std::lock_guard<std::mutex> Lock(S.Mutex);
+      Size += S.Map.size();
+    }
+    return Size;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  unsigned getNumShards() const { return 1u << ShardBits; }
+
+  /// Calls \p F on every entry of the map. Must not be called while other
+  /// threads insert into the map.
+  template <typename FnTy> void forEach(FnTy F) const {
+    for (Shard &S : shards())
+      for (MapEntryTy &Entry : S.Map)
+        F(Entry);
+  }
+
+private:
+  struct Shard {
+    std::mutex Mutex;
+    StringMap<ValueTy, AllocatorTy> Map;
+  };
+
+  Shard &getShard(uint32_t FullHashValue) const {
+    if (ShardBits == 0)
+      return Shards[0];
+    // The StringMap of the shard picks buckets with the low bits of the hash.
+    // Select the shard with the top bits of a multiplicative hash instead, so
+    // that the keys of a shard still spread over all of its buckets.
+    return Shards[(FullHashValue * 0x9E3779B9u) >> (32 - ShardBits)];
+  }
+
+  MutableArrayRef<Shard> shards() const {
+    return MutableArrayRef<Shard>(Shards.get(), getNumShards());
+  }
+
+  const unsigned ShardBits;
+  std::unique_ptr<Shard[]> Shards;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_ADT_CONCURRENTSTRINGMAP_H
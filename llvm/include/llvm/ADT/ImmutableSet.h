@@ -136,11 +136,21 @@ public:
 
   /// isEqual - Compares two trees for structural equality and returns true
   ///   if they are equal.  This worst case performance of this operation is
-  //    linear in the sizes of the trees.
+  //    linear in the sizes of the trees.  Canonicalized trees of the same
+  //    factory, and trees with different cached digests, compare in constant
+  //    time.
   bool isEqual(const ImutAVLTree& RHS) const {
     if (&RHS == this)
       return true;
 
+    // A factory keeps at most one canonical tree for any set of contents.
+    if (IsCanonicalized && RHS.IsCanonicalized && factory == RHS.factory)
+      return false;
+
+    // The digest only depends on the contents, not on the shape of the tree.
+    if (hasCachedDigest() && RHS.hasCachedDigest() && digest != RHS.digest)
+      return false;
+
     iterator LItr = begin(), LEnd = end();
     iterator RItr = RHS.begin(), REnd = RHS.end();
 
@@ -612,6 +622,9 @@ public:
       if (!entry)
         break;
       for (TreeTy *T = entry ; T != nullptr; T = T->next) {
+        // Trees in the same bucket may still have different digests.
+        if (T->computeDigest() != digest)
+          continue;
         // Compare the Contents('T') with Contents('TNew')
         typename TreeTy::iterator TI = T->begin(), TE = T->end();
         if (!compareTreeWithSection(TNew, TI, TE))
@@ -49,6 +49,11 @@ public:
 
   /// Check if the set contains the given \c key.
   bool contains(StringRef key) const { return Base::FindKey(key) != -1; }
+
+  /// Overload that explicitly takes precomputed hash(key).
+  bool contains(StringRef key, uint32_t FullHashValue) const {
+    return Base::FindKey(key, FullHashValue) != -1;
+  }
 };
 
 } // end namespace llvm
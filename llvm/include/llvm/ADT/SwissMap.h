@@ -0,0 +1,805 @@
+//===- llvm/ADT/SwissMap.h - Hash table probed by groups --------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file defines the SwissMap class, an open addressing hash table with the
+/// interface of DenseMap whose probes test a whole group of slots at once.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_SWISSMAP_H
+#define LLVM_ADT_SWISSMAP_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/EpochTracker.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/MemAlloc.h"
+#include "llvm/Support/type_traits.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LLVM_SWISSMAP_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__) && !defined(__ARM_BIG_ENDIAN)
+#define LLVM_SWISSMAP_NEON
+#include <arm_neon.h>
+#endif
+
+namespace llvm {
+
+namespace detail {
+
+/// Every slot of a SwissMap has a control byte. It is SwissCtrlEmpty or
+/// SwissCtrlDeleted if the slot has no entry, and otherwise holds 7 bits of the
+/// hash of the key in the slot, so most slots holding other keys can be skipped
+/// without looking at their key.
+enum : int8_t { SwissCtrlEmpty = -128, SwissCtrlDeleted = -2 };
+
+/// The control bytes of SwissGroup::Width consecutive slots, which are tested
+/// together. The match functions return a mask with one bit for each matching
+/// slot; the index of the slot of a bit is its position shifted right by
+/// SwissGroup::Shift.
+class SwissGroup {
+public:
+  static constexpr unsigned Width = 16;
+
+#if defined(LLVM_SWISSMAP_SSE2)
+  static constexpr unsigned Shift = 0;
+  using MaskT = uint32_t;
+
+  explicit SwissGroup(const int8_t *Ctrl)
+      : Ctrl(_mm_load_si128(reinterpret_cast<const __m128i *>(Ctrl))) {}
+
+  MaskT match(int8_t H2) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(H2), Ctrl));
+  }
+  MaskT matchEmpty() const { return match(SwissCtrlEmpty); }
+  MaskT matchEmptyOrDeleted() const { return _mm_movemask_epi8(Ctrl); }
+
+private:
+  __m128i Ctrl;
+#elif defined(LLVM_SWISSMAP_NEON)
+  // NEON has no movemask; narrowing the 16 byte lanes by 4 bits gives one
+  // nibble per slot instead.
+  static constexpr unsigned Shift = 2;
+  using MaskT = uint64_t;
+
+  explicit SwissGroup(const int8_t *Ctrl) : Ctrl(vld1q_s8(Ctrl)) {}
+
+  MaskT match(int8_t H2) const {
+    return toMask(vceqq_s8(vdupq_n_s8(H2), Ctrl));
+  }
+  MaskT matchEmpty() const { return match(SwissCtrlEmpty); }
+  MaskT matchEmptyOrDeleted() const {
+    return toMask(vcltq_s8(Ctrl, vdupq_n_s8(0)));
+  }
+
+private:
+  static MaskT toMask(uint8x16_t Lanes) {
+    uint8x8_t Nibbles = vshrn_n_u16(vreinterpretq_u16_u8(Lanes), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(Nibbles), 0) &
+           0x8888888888888888ULL;
+  }
+
+  int8x16_t Ctrl;
+#else
+  static constexpr unsigned Shift = 0;
+  using MaskT = uint32_t;
+
+  explicit SwissGroup(const int8_t *Ctrl) { memcpy(this->Ctrl, Ctrl, Width); }
+
+  MaskT match(int8_t H2) const {
+    MaskT Mask = 0;
+    for (unsigned I = 0; I != Width; ++I)
+      Mask |= MaskT(Ctrl[I] == H2) << I;
+    return Mask;
+  }
+  MaskT matchEmpty() const { return match(SwissCtrlEmpty); }
+  MaskT matchEmptyOrDeleted() const {
+    MaskT Mask = 0;
+    for (unsigned I = 0; I != Width; ++I)
+      Mask |= MaskT(Ctrl[I] < 0) << I;
+    return Mask;
+  }
+
+private:
+  int8_t Ctrl[Width];
+#endif
+
+public:
+  /// Returns the index in the group of the lowest slot set in \p Mask.
+  static unsigned lowestSlot(MaskT Mask) {
+    return countTrailingZeros(Mask) >> Shift;
+  }
+};
+
+} // end namespace detail
+
+template <typename KeyT, typename ValueT,
+          typename KeyInfoT = DenseMapInfo<KeyT>,
+          typename Bucket = llvm::detail::DenseMapPair<KeyT, ValueT>,
+          bool IsConst = false>
+class SwissMapIterator;
+
+/// An open addressing hash table with the interface of DenseMap.
+///
+/// The slots are split in groups of 16, and every slot has a control byte that
+/// says whether it is empty, deleted, or full, and in the latter case holds 7
+/// bits of the hash of its key. A lookup compares the control bytes of a whole
+/// group against the hash bits with one SSE2 or NEON comparison and only
+/// compares the keys of the matching slots, so it usually touches one cache
+/// line of control bytes and one bucket, even at a load factor of 7/8. Groups
+/// are probed quadratically until one with an empty slot.
+///
+/// Keys are hashed and compared with KeyInfoT like DenseMap does, but no empty
+/// or tombstone keys are needed, and buckets without an entry hold no key.
+/// Iteration order is unspecified and differs from DenseMap's.
+///
+/// Iterators and references to entries are invalidated by the operations that
+/// invalidate them in DenseMap: inserting a new key, reserve(), grow(),
+/// clear(), shrink_and_clear() and swap(). Erasing only invalidates the erased
+/// entry. The entries move at different times than in a DenseMap of the same
+/// contents though: a SwissMap only grows when its entries reach 7/8 of the
+/// buckets instead of 3/4, and starts with 16 buckets instead of 64. Code that
+/// checks whether an insertion moved the entries must use
+/// isPointerIntoBucketsArray() or getPointerIntoBucketsArray() rather than
+/// assume DenseMap's growth policy.
+template <typename KeyT, typename ValueT,
+          typename KeyInfoT = DenseMapInfo<KeyT>,
+          typename BucketT = llvm::detail::DenseMapPair<KeyT, ValueT>>
+class SwissMap : public DebugEpochBase {
+  template <typename T>
+  using const_arg_type_t = typename const_pointer_or_const_ref<T>::type;
+
+  using Group = detail::SwissGroup;
+
+  /// Control bytes, one for each bucket, followed by the buckets.
+  int8_t *Ctrl = nullptr;
+  unsigned NumEntries = 0;
+  unsigned NumDeleted = 0;
+  unsigned NumBuckets = 0;
+
+public:
+  using size_type = unsigned;
+  using key_type = KeyT;
+  using mapped_type = ValueT;
+  using value_type = BucketT;
+
+  using iterator = SwissMapIterator<KeyT, ValueT, KeyInfoT, BucketT>;
+  using const_iterator =
+      SwissMapIterator<KeyT, ValueT, KeyInfoT, BucketT, true>;
+
+  /// Create a SwissMap with an optional \p InitialReserve that guarantee that
+  /// this number of elements can be inserted in the map without grow()
+  explicit SwissMap(unsigned InitialReserve = 0) { init(InitialReserve); }
+
+  SwissMap(const SwissMap &Other) : DebugEpochBase() { copyFrom(Other); }
+
+  SwissMap(SwissMap &&Other) : DebugEpochBase() { swap(Other); }
+
+  template <typename InputIt> SwissMap(const InputIt &I, const InputIt &E) {
+    init(std::distance(I, E));
+    insert(I, E);
+  }
+
+  SwissMap(std::initializer_list<value_type> Vals) {
+    init(Vals.size());
+    insert(Vals.begin(), Vals.end());
+  }
+
+  ~SwissMap() {
+    destroyAll();
+    deallocateTable();
+  }
+
+  SwissMap &operator=(const SwissMap &Other) {
+    if (&Other != this) {
+      destroyAll();
+      deallocateTable();
+      copyFrom(Other);
+    }
+    return *this;
+  }
+
+  SwissMap &operator=(SwissMap &&Other) {
+    destroyAll();
+    deallocateTable();
+    init(0);
+    swap(Other);
+    return *this;
+  }
+
+  void swap(SwissMap &RHS) {
+    incrementEpoch();
+    RHS.incrementEpoch();
+    std::swap(Ctrl, RHS.Ctrl);
+    std::swap(NumEntries, RHS.NumEntries);
+    std::swap(NumDeleted, RHS.NumDeleted);
+    std::swap(NumBuckets, RHS.NumBuckets);
+  }
+
+  inline iterator begin() {
+    if (empty())
+      return end();
+    return iterator(Ctrl, getBuckets(), getBucketsEnd(), *this);
+  }
+  inline iterator end() {
+    return iterator(nullptr, getBucketsEnd(), getBucketsEnd(), *this, true);
+  }
+  inline const_iterator begin() const {
+    if (empty())
+      return end();
+    return const_iterator(Ctrl, getBuckets(), getBucketsEnd(), *this);
+  }
+  inline const_iterator end() const {
+    return const_iterator(nullptr, getBucketsEnd(), getBucketsEnd(), *this,
+                          true);
+  }
+
+  [[nodiscard]] bool empty() const { return NumEntries == 0; }
+  unsigned size() const { return NumEntries; }
+
+  /// Grow the map so that it can contain at least \p NumEntries items before
+  /// resizing again.
+  void reserve(size_type NumEntries) {
+    unsigned MinBuckets = getMinBucketsToReserveForEntries(NumEntries);
+    incrementEpoch();
+    if (MinBuckets > NumBuckets)
+      rehash(MinBuckets);
+  }
+
+  /// Grow the map to at least \p AtLeast buckets, rounded up to a power of
+  /// two, but never fewer than its entries need.
+  void grow(unsigned AtLeast) {
+    incrementEpoch();
+    rehash(std::max<unsigned>(
+        {Group::Width, unsigned(NextPowerOf2(AtLeast - 1)),
+         getMinBucketsToReserveForEntries(NumEntries)}));
+  }
+
+  void clear() {
+    incrementEpoch();
+    if (NumEntries == 0 && NumDeleted == 0)
+      return;
+
+    destroyAll();
+    // If the capacity of the table is huge, and the # elements used is small,
+    // shrink the table.
+    if (NumEntries * 4 < NumBuckets && NumBuckets > 64) {
+      unsigned NewNumBuckets = getMinBucketsToReserveForEntries(NumEntries);
+      deallocateTable();
+      allocateTable(NewNumBuckets);
+    } else {
+      memset(Ctrl, detail::SwissCtrlEmpty, NumBuckets);
+    }
+    NumEntries = 0;
+    NumDeleted = 0;
+  }
+
+  /// Remove all entries and shrink the table to a size suited to the number of
+  /// entries the map had, like DenseMap::shrink_and_clear().
+  void shrink_and_clear() {
+    incrementEpoch();
+    unsigned OldNumEntries = NumEntries;
+    destroyAll();
+    NumEntries = 0;
+    NumDeleted = 0;
+
+    unsigned NewNumBuckets = 0;
+    if (OldNumEntries)
+      NewNumBuckets = std::max(64, 1 << (Log2_32_Ceil(OldNumEntries) + 1));
+    if (NewNumBuckets == NumBuckets) {
+      if (NumBuckets)
+        memset(Ctrl, detail::SwissCtrlEmpty, NumBuckets);
+      return;
+    }
+    deallocateTable();
+    allocateTable(NewNumBuckets);
+  }
+
+  /// Return 1 if the specified key is in the map, 0 otherwise.
+  size_type count(const_arg_type_t<KeyT> Val) const {
+    return lookupBucket(Val, getHashValue(Val)) ? 1 : 0;
+  }
+
+  iterator find(const_arg_type_t<KeyT> Val) { return find_as(Val); }
+  const_iterator find(const_arg_type_t<KeyT> Val) const { return find_as(Val); }
+
+  /// Alternate version of find() which allows a different, and possibly
+  /// less expensive, key type.
+  /// The DenseMapInfo is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, KeyT) for each key
+  /// type used.
+  template <class LookupKeyT> iterator find_as(const LookupKeyT &Val) {
+    if (BucketT *TheBucket = lookupBucket(Val, getHashValue(Val)))
+      return makeIterator(TheBucket);
+    return end();
+  }
+  template <class LookupKeyT>
+  const_iterator find_as(const LookupKeyT &Val) const {
+    if (const BucketT *TheBucket = lookupBucket(Val, getHashValue(Val)))
+      return makeConstIterator(TheBucket);
+    return end();
+  }
+
+  /// lookup - Return the entry for the specified key, or a default
+  /// constructed value if no such entry exists.
+  ValueT lookup(const_arg_type_t<KeyT> Val) const {
+    if (const BucketT *TheBucket = lookupBucket(Val, getHashValue(Val)))
+      return TheBucket->getSecond();
+    return ValueT();
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(const std::pair<KeyT, ValueT> &KV) {
+    return try_emplace(KV.first, KV.second);
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(std::pair<KeyT, ValueT> &&KV) {
+    return try_emplace(std::move(KV.first), std::move(KV.second));
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // The value is constructed in-place if the key is not in the map, otherwise
+  // it is not moved.
+  template <typename... Ts>
+  std::pair<iterator, bool> try_emplace(KeyT &&Key, Ts &&...Args) {
+    return tryEmplaceAs(Key, std::move(Key), std::forward<Ts>(Args)...);
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // The value is constructed in-place if the key is not in the map, otherwise
+  // it is not moved.
+  template <typename... Ts>
+  std::pair<iterator, bool> try_emplace(const KeyT &Key, Ts &&...Args) {
+    return tryEmplaceAs(Key, Key, std::forward<Ts>(Args)...);
+  }
+
+  /// Alternate version of insert() which allows a different, and possibly
+  /// less expensive, key type.
+  /// The DenseMapInfo is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, KeyT) for each key
+  /// type used.
+  template <typename LookupKeyT>
+  std::pair<iterator, bool> insert_as(std::pair<KeyT, ValueT> &&KV,
+                                      const LookupKeyT &Val) {
+    return tryEmplaceAs(Val, std::move(KV.first), std::move(KV.second));
+  }
+
+  /// insert - Range insertion of pairs.
+  template <typename InputIt> void insert(InputIt I, InputIt E) {
+    for (; I != E; ++I)
+      insert(*I);
+  }
+
+  bool erase(const KeyT &Val) {
+    BucketT *TheBucket = lookupBucket(Val, getHashValue(Val));
+    if (!TheBucket)
+      return false; // not in map.
+    eraseBucket(TheBucket);
+    return true;
+  }
+  void erase(iterator I) { eraseBucket(&*I); }
+
+  value_type &FindAndConstruct(const KeyT &Key) {
+    return *try_emplace(Key).first;
+  }
+
+  ValueT &operator[](const KeyT &Key) { return FindAndConstruct(Key).second; }
+
+  value_type &FindAndConstruct(KeyT &&Key) {
+    return *try_emplace(std::move(Key)).first;
+  }
+
+  ValueT &operator[](KeyT &&Key) {
+    return FindAndConstruct(std::move(Key)).second;
+  }
+
+  /// Return the approximate size (in bytes) of the actual map.
+  /// This is just the raw memory used by the table.
+  /// If entries are pointers to objects, the size of the referenced objects
+  /// are not included.
+  size_t getMemorySize() const { return getAllocationSize(NumBuckets); }
+
+  /// isPointerIntoBucketsArray - Return true if the specified pointer points
+  /// somewhere into the SwissMap's array of buckets (i.e. either to a key or
+  /// value in the SwissMap).
+  bool isPointerIntoBucketsArray(const void *Ptr) const {
+    return Ptr >= getBuckets() && Ptr < getBucketsEnd();
+  }
+
+  /// getPointerIntoBucketsArray() - Return an opaque pointer into the buckets
+  /// array.  In conjunction with the previous method, this can be used to
+  /// determine whether an insertion caused the SwissMap to reallocate.
+  const void *getPointerIntoBucketsArray() const { return getBuckets(); }
+
+private:
+  static unsigned getHashValue(const KeyT &Val) {
+    return KeyInfoT::getHashValue(Val);
+  }
+
+  template <typename LookupKeyT>
+  static unsigned getHashValue(const LookupKeyT &Val) {
+    return KeyInfoT::getHashValue(Val);
+  }
+
+  /// Spreads the bits of \p Hash, which for DenseMapInfo hashes of pointers
+  /// are mostly in the low bits, over both the group index and the 7 bits
+  /// stored in the control byte.
+  static uint64_t mixHash(unsigned Hash) {
+    return uint64_t(Hash) * 0x9E3779B97F4A7C15ULL;
+  }
+  static size_t getH1(uint64_t Mixed) { return size_t(Mixed >> 32); }
+  static int8_t getH2(uint64_t Mixed) { return int8_t((Mixed >> 25) & 0x7F); }
+
+  static size_t getBucketsOffset(unsigned Num) {
+    return alignTo(Num, alignof(BucketT));
+  }
+  static size_t getAllocationSize(unsigned Num) {
+    return Num ? getBucketsOffset(Num) + sizeof(BucketT) * Num : 0;
+  }
+  static size_t getAllocationAlignment() {
+    return std::max<size_t>(alignof(BucketT), Group::Width);
+  }
+
+  BucketT *getBuckets() const {
+    return reinterpret_cast<BucketT *>(reinterpret_cast<char *>(Ctrl) +
+                                       getBucketsOffset(NumBuckets));
+  }
+  BucketT *getBucketsEnd() const { return getBuckets() + NumBuckets; }
+
+  static bool isFull(int8_t C) { return C >= 0; }
+
+  /// The maximum number of full and deleted slots in a table of \p Num slots.
+  static unsigned getMaxLoad(unsigned Num) { return Num - Num / 8; }
+
+  /// Returns the number of buckets to allocate to ensure that the map can
+  /// accommodate \p NumEntries without need to grow.
+  static unsigned getMinBucketsToReserveForEntries(unsigned NumEntries) {
+    if (NumEntries == 0)
+      return 0;
+    return std::max<unsigned>(Group::Width,
+                              PowerOf2Ceil((uint64_t(NumEntries) * 8 + 6) / 7));
+  }
+
+  void init(unsigned InitNumEntries) {
+    NumEntries = 0;
+    NumDeleted = 0;
+    allocateTable(getMinBucketsToReserveForEntries(InitNumEntries));
+  }
+
+  /// Allocates a table of \p Num buckets, all empty. NumEntries and NumDeleted
+  /// are not updated.
+  void allocateTable(unsigned Num) {
+    assert((Num == 0 || (isPowerOf2_32(Num) && Num >= Group::Width)) &&
+           "# buckets must be a power of two and at least a group!");
+    NumBuckets = Num;
+    if (Num == 0) {
+      Ctrl = nullptr;
+      return;
+    }
+    Ctrl = static_cast<int8_t *>(
+        allocate_buffer(getAllocationSize(Num), getAllocationAlignment()));
+    memset(Ctrl, detail::SwissCtrlEmpty, Num);
+  }
+
+  void deallocateTable() {
+    if (Ctrl)
+      deallocate_buffer(Ctrl, getAllocationSize(NumBuckets),
+                        getAllocationAlignment());
+  }
+
+  static void destroyBucket(BucketT *B) {
+    B->getSecond().~ValueT();
+    B->getFirst().~KeyT();
+  }
+
+  void destroyAll() {
+    if (std::is_trivially_destructible<KeyT>::value &&
+        std::is_trivially_destructible<ValueT>::value)
+      return;
+    BucketT *Buckets = getBuckets();
+    for (unsigned I = 0; I != NumBuckets; ++I)
+      if (isFull(Ctrl[I]))
+        destroyBucket(&Buckets[I]);
+  }
+
+  void copyFrom(const SwissMap &Other) {
+    allocateTable(Other.NumBuckets);
+    NumEntries = Other.NumEntries;
+    NumDeleted = Other.NumDeleted;
+    if (NumBuckets == 0)
+      return;
+    memcpy(Ctrl, Other.Ctrl, NumBuckets);
+    if (std::is_trivially_copyable<KeyT>::value &&
+        std::is_trivially_copyable<ValueT>::value) {
+      memcpy(reinterpret_cast<void *>(getBuckets()), Other.getBuckets(),
+             NumBuckets * sizeof(BucketT));
+      return;
+    }
+    BucketT *Buckets = getBuckets();
+    const BucketT *OtherBuckets = Other.getBuckets();
+    for (unsigned I = 0; I != NumBuckets; ++I) {
+      if (!isFull(Ctrl[I]))
+        continue;
+      ::new (&Buckets[I].getFirst()) KeyT(OtherBuckets[I].getFirst());
+      ::new (&Buckets[I].getSecond()) ValueT(OtherBuckets[I].getSecond());
+    }
+  }
+
+  iterator makeIterator(BucketT *TheBucket) {
+    return iterator(Ctrl + (TheBucket - getBuckets()), TheBucket,
+                    getBucketsEnd(), *this, true);
+  }
+  const_iterator makeConstIterator(const BucketT *TheBucket) const {
+    return const_iterator(Ctrl + (TheBucket - getBuckets()), TheBucket,
+                          getBucketsEnd(), *this, true);
+  }
+
+  /// Returns the bucket holding \p Val, or nullptr.
+  template <typename LookupKeyT>
+  BucketT *lookupBucket(const LookupKeyT &Val, unsigned Hash) const {
+    if (NumBuckets == 0)
+      return nullptr;
+    uint64_t Mixed = mixHash(Hash);
+    int8_t H2 = getH2(Mixed);
+    size_t GroupMask = NumBuckets / Group::Width - 1;
+    size_t GroupNo = getH1(Mixed) & GroupMask;
+    BucketT *Buckets = getBuckets();
+    for (size_t ProbeAmt = 1;; ++ProbeAmt) {
+      size_t GroupStart = GroupNo * Group::Width;
+      Group G(Ctrl + GroupStart);
+      for (auto Mask = G.match(H2); Mask; Mask &= Mask - 1) {
+        BucketT *ThisBucket = Buckets + GroupStart + Group::lowestSlot(Mask);
+        if (LLVM_LIKELY(KeyInfoT::isEqual(Val, ThisBucket->getFirst())))
+          return ThisBucket;
+      }
+      // A group with an empty slot ends every probe sequence through it.
+      if (LLVM_LIKELY(G.matchEmpty()))
+        return nullptr;
+      GroupNo = (GroupNo + ProbeAmt) & GroupMask;
+    }
+  }
+
+  /// Returns the first empty or deleted slot in the probe sequence of \p Hash.
+  size_t findInsertSlot(unsigned Hash) const {
+    uint64_t Mixed = mixHash(Hash);
+    size_t GroupMask = NumBuckets / Group::Width - 1;
+    size_t GroupNo = getH1(Mixed) & GroupMask;
+    for (size_t ProbeAmt = 1;; ++ProbeAmt) {
+      size_t GroupStart = GroupNo * Group::Width;
+      if (auto Mask = Group(Ctrl + GroupStart).matchEmptyOrDeleted())
+        return GroupStart + Group::lowestSlot(Mask);
+      GroupNo = (GroupNo + ProbeAmt) & GroupMask;
+    }
+  }
+
+  template <typename LookupKeyT, typename KeyArg, typename... ValueArgs>
+  std::pair<iterator, bool> tryEmplaceAs(const LookupKeyT &Lookup,
+                                         KeyArg &&Key, ValueArgs &&...Values) {
+    unsigned Hash = getHashValue(Lookup);
+    if (BucketT *TheBucket = lookupBucket(Lookup, Hash))
+      return std::make_pair(makeIterator(TheBucket), false); // Already in map.
+
+    incrementEpoch();
+    size_t Slot = NumBuckets ? findInsertSlot(Hash) : 0;
+    // Only filling an empty slot adds to the load, reusing a deleted one is
+    // always fine.
+    if (NumBuckets == 0 ||
+        (Ctrl[Slot] == detail::SwissCtrlEmpty &&
+         NumEntries + NumDeleted + 1 > getMaxLoad(NumBuckets))) {
+      // Rehash in place if most of the load is deleted slots.
+      unsigned NewNumBuckets = NumBuckets;
+      if ((NumEntries + 1) * 16 > NumBuckets * 7)
+        NewNumBuckets = std::max<unsigned>(NumBuckets * 2, Group::Width);
+      rehash(NewNumBuckets);
+      Slot = findInsertSlot(Hash);
+    }
+
+    if (Ctrl[Slot] == detail::SwissCtrlDeleted)
+      --NumDeleted;
+    Ctrl[Slot] = getH2(mixHash(Hash));
+    ++NumEntries;
+    BucketT *TheBucket = getBuckets() + Slot;
+    ::new (&TheBucket->getFirst()) KeyT(std::forward<KeyArg>(Key));
+    ::new (&TheBucket->getSecond()) ValueT(std::forward<ValueArgs>(Values)...);
+    return std::make_pair(makeIterator(TheBucket), true);
+  }
+
+  void eraseBucket(BucketT *TheBucket) {
+    size_t Slot = TheBucket - getBuckets();
+    destroyBucket(TheBucket);
+    --NumEntries;
+    // If the group of the slot has an empty slot, no probe sequence continued
+    // past it, so the slot can be marked empty rather than deleted.
+    size_t GroupStart = Slot & ~size_t(Group::Width - 1);
+    if (Group(Ctrl + GroupStart).matchEmpty()) {
+      Ctrl[Slot] = detail::SwissCtrlEmpty;
+    } else {
+      Ctrl[Slot] = detail::SwissCtrlDeleted;
+      ++NumDeleted;
+    }
+  }
+
+  /// Moves all entries to a new table of \p NewNumBuckets buckets, which drops
+  /// the deleted slots.
+  void rehash(unsigned NewNumBuckets) {
+    int8_t *OldCtrl = Ctrl;
+    BucketT *OldBuckets = getBuckets();
+    unsigned OldNumBuckets = NumBuckets;
+
+    allocateTable(NewNumBuckets);
+    NumDeleted = 0;
+    BucketT *Buckets = getBuckets();
+    for (unsigned I = 0; I != OldNumBuckets; ++I) {
+      if (!isFull(OldCtrl[I]))
+        continue;
+      BucketT &B = OldBuckets[I];
+      unsigned Hash = getHashValue(B.getFirst());
+      size_t Slot = findInsertSlot(Hash);
+      Ctrl[Slot] = getH2(mixHash(Hash));
+      ::new (&Buckets[Slot].getFirst()) KeyT(std::move(B.getFirst()));
+      ::new (&Buckets[Slot].getSecond()) ValueT(std::move(B.getSecond()));
+      destroyBucket(&B);
+    }
+
+    if (OldCtrl)
+      deallocate_buffer(OldCtrl, getAllocationSize(OldNumBuckets),
+                        getAllocationAlignment());
+  }
+};
+
+/// Equality comparison for SwissMap.
+///
+/// Iterates over elements of LHS confirming that each (key, value) pair in LHS
+/// is also in RHS, and that no additional pairs are in RHS.
+/// Equivalent to N calls to RHS.find and N value comparisons. Amortized
+/// complexity is linear, worst case is O(N^2) (if every hash collides).
+template <typename KeyT, typename ValueT, typename KeyInfoT, typename BucketT>
+bool operator==(const SwissMap<KeyT, ValueT, KeyInfoT, BucketT> &LHS,
+                const SwissMap<KeyT, ValueT, KeyInfoT, BucketT> &RHS) {
+  if (LHS.size() != RHS.size())
+    return false;
+
+  for (auto &KV : LHS) {
+    auto I = RHS.find(KV.first);
+    if (I == RHS.end() || I->second != KV.second)
+      return false;
+  }
+
+  return true;
+}
+
+/// Inequality comparison for SwissMap.
+///
+/// Equivalent to !(LHS == RHS). See operator== for performance notes.
+template <typename KeyT, typename ValueT, typename KeyInfoT, typename BucketT>
+bool operator!=(const SwissMap<KeyT, ValueT, KeyInfoT, BucketT> &LHS,
+                const SwissMap<KeyT, ValueT, KeyInfoT, BucketT> &RHS) {
+  return !(LHS == RHS);
+}
+
+template <typename KeyT, typename ValueT, typename KeyInfoT, typename Bucket,
+          bool IsConst>
+class SwissMapIterator : DebugEpochBase::HandleBase {
+  friend class SwissMapIterator<KeyT, ValueT, KeyInfoT, Bucket, true>;
+  friend class SwissMapIterator<KeyT, ValueT, KeyInfoT, Bucket, false>;
+
+public:
+  using difference_type = ptrdiff_t;
+  using value_type = std::conditional_t<IsConst, const Bucket, Bucket>;
+  using pointer = value_type *;
+  using reference = value_type &;
+  using iterator_category = std::forward_iterator_tag;
+
+private:
+  const int8_t *Ctrl = nullptr;
+  pointer Ptr = nullptr;
+  pointer End = nullptr;
+
+public:
+  SwissMapIterator() = default;
+
+  SwissMapIterator(const int8_t *Ctrl, pointer Pos, pointer E,
+                   const DebugEpochBase &Epoch, bool NoAdvance = false)
+      : DebugEpochBase::HandleBase(&Epoch), Ctrl(Ctrl), Ptr(Pos), End(E) {
+    assert(isHandleInSync() && "invalid construction!");
+
+    if (NoAdvance)
+      return;
+    AdvancePastEmptyBuckets();
+  }
+
+  // Converting ctor from non-const iterators to const iterators. SFINAE'd out
+  // for const iterator destinations so it doesn't end up as a user defined copy
+  // constructor.
+  template <bool IsConstSrc,
+            typename = std::enable_if_t<!IsConstSrc && IsConst>>
+  SwissMapIterator(
+      const SwissMapIterator<KeyT, ValueT, KeyInfoT, Bucket, IsConstSrc> &I)
+      : DebugEpochBase::HandleBase(I), Ctrl(I.Ctrl), Ptr(I.Ptr), End(I.End) {}
+
+  reference operator*() const {
+    assert(isHandleInSync() && "invalid iterator access!");
+    assert(Ptr != End && "dereferencing end() iterator");
+    return *Ptr;
+  }
+  pointer operator->() const {
+    assert(isHandleInSync() && "invalid iterator access!");
+    assert(Ptr != End && "dereferencing end() iterator");
+    return Ptr;
+  }
+
+  friend bool operator==(const SwissMapIterator &LHS,
+                         const SwissMapIterator &RHS) {
+    assert((!LHS.Ptr || LHS.isHandleInSync()) && "handle not in sync!");
+    assert((!RHS.Ptr || RHS.isHandleInSync()) && "handle not in sync!");
+    assert(LHS.getEpochAddress() == RHS.getEpochAddress() &&
+           "comparing incomparable iterators!");
+    return LHS.Ptr == RHS.Ptr;
+  }
+
+  friend bool operator!=(const SwissMapIterator &LHS,
+                         const SwissMapIterator &RHS) {
+    return !(LHS == RHS);
+  }
+
+  inline SwissMapIterator &operator++() { // Preincrement
+    assert(isHandleInSync() && "invalid iterator access!");
+    assert(Ptr != End && "incrementing end() iterator");
+    ++Ptr;
+    ++Ctrl;
+    AdvancePastEmptyBuckets();
+    return *this;
+  }
+  SwissMapIterator operator++(int) { // Postincrement
+    assert(isHandleInSync() && "invalid iterator access!");
+    SwissMapIterator tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+private:
+  void AdvancePastEmptyBuckets() {
+    assert(Ptr <= End);
+    while (Ptr != End && *Ctrl < 0) {
+      ++Ptr;
+      ++Ctrl;
+    }
+  }
+};
+
+template <typename KeyT, typename ValueT, typename KeyInfoT, typename BucketT>
+inline size_t
+capacity_in_bytes(const SwissMap<KeyT, ValueT, KeyInfoT, BucketT> &X) {
+  return X.getMemorySize();
+}
+
+} // end namespace llvm
+
+#undef LLVM_SWISSMAP_SSE2
+#undef LLVM_SWISSMAP_NEON
+
+#endif // LLVM_ADT_SWISSMAP_H
@@ -9,6 +9,7 @@
 #ifndef LLVM_SUPPORT_PARALLEL_H
 #define LLVM_SUPPORT_PARALLEL_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Error.h"
@@ -72,6 +73,11 @@ public:
     std::unique_lock<std::mutex> lock(Mutex);
     Cond.wait(lock, [&] { return Count == 0; });
   }
+
+  bool isZero() const {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Count == 0;
+  }
 };
 } // namespace detail
 
@@ -103,7 +109,9 @@ public:
   // }
   void execute(std::function<void()> f);
 
-  void sync() const { L.sync(); }
+  // Wait for all spawned tasks to finish. If called from a task, the thread
+  // runs other tasks in the meantime, so task groups can be nested.
+  void sync() const;
 };
 
 namespace detail {
@@ -229,6 +237,15 @@ void parallelSort(RandomAccessIterator Start, RandomAccessIterator End,
 
 void parallelFor(size_t Begin, size_t End, function_ref<void(size_t)> Fn);
 
+/// Hashes \p Data into \p Hash using all threads. The data is split into
+/// chunks of \p ChunkSize bytes whose hashes are computed in parallel, then
+/// the concatenated hashes of the chunks are hashed into \p Hash. HashFn(Dest,
+/// Bytes) must write Hash.size() bytes to Dest. The result does not depend on
+/// the number of threads, but it is not HashFn(Data).
+void parallelHash(MutableArrayRef<uint8_t> Hash, ArrayRef<uint8_t> Data,
+                  function_ref<void(uint8_t *, ArrayRef<uint8_t>)> HashFn,
+                  size_t ChunkSize = 1024 * 1024);
+
 template <class IterTy, class FuncTy>
 void parallelForEach(IterTy Begin, IterTy End, FuncTy Fn) {
   parallelFor(0, End - Begin, [&](size_t I) { Fn(Begin[I]); });
@@ -21,9 +21,11 @@
 
 #include <future>
 
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <utility>
@@ -49,6 +51,12 @@ class ThreadPoolTaskGroup;
 /// available threads are used up by tasks waiting for a task that has no thread
 /// left to run on (this includes waiting on the returned future). It should be
 /// generally safe to wait() for a group as long as groups do not form a cycle.
+///
+/// Tasks of a group with a higher priority are started before the queued tasks
+/// of groups with a lower priority, and a group can limit how many of its tasks
+/// run at the same time (see ThreadPoolTaskGroup). A task submitted with
+/// asyncAfter() is not started before all tasks of another group have
+/// finished. It stays in the queue until then, so it does not block a thread.
 class ThreadPool {
 public:
   /// Construct a pool using the hardware strategy \p S for mapping hardware
@@ -92,6 +100,26 @@ public:
                      &Group);
   }
 
+  /// Asynchronous submission of a task that is started once all tasks in
+  /// \p Dependency have finished, including the ones added to \p Dependency
+  /// after this call but before it finishes. Waiting for such a task only
+  /// returns after \p Dependency has finished, so the groups must not form a
+  /// cycle.
+  template <typename Func>
+  auto asyncAfter(ThreadPoolTaskGroup &Dependency, Func &&F)
+      -> std::shared_future<decltype(F())> {
+    return asyncImpl(std::function<decltype(F())()>(std::forward<Func>(F)),
+                     nullptr, &Dependency);
+  }
+
+  /// Overload, task will be in the given task group.
+  template <typename Func>
+  auto asyncAfter(ThreadPoolTaskGroup &Dependency, ThreadPoolTaskGroup &Group,
+                  Func &&F) -> std::shared_future<decltype(F())> {
+    return asyncImpl(std::function<decltype(F())()>(std::forward<Func>(F)),
+                     &Group, &Dependency);
+  }
+
   /// Blocking wait for all the threads to complete and the queue to be empty.
   /// It is an error to try to add new tasks while blocking on this call.
   /// Calling wait() from a task would deadlock waiting for itself.
@@ -113,6 +141,17 @@ public:
   bool isWorkerThread() const;
 
 private:
+  /// A task waiting for execution in the pool.
+  struct QueuedTask {
+    std::function<void()> Run;
+    ThreadPoolTaskGroup *Group;
+    /// The group that has to finish before the task can start, or nullptr.
+    ThreadPoolTaskGroup *Dependency;
+    /// The priority of Group, copied so the task can be queued without
+    /// dereferencing Group.
+    unsigned Priority;
+  };
+
   /// Helpers to create a promise and a callable wrapper of \p Task that sets
   /// the result of the promise. Returns the callable and a future to access the
   /// result.
@@ -145,26 +184,15 @@ private:
   /// Asynchronous submission of a task to the pool. The returned future can be
   /// used to wait for the task to finish and is *non-blocking* on destruction.
   template <typename ResTy>
-  std::shared_future<ResTy> asyncImpl(std::function<ResTy()> Task,
-                                      ThreadPoolTaskGroup *Group) {
+  std::shared_future<ResTy>
+  asyncImpl(std::function<ResTy()> Task, ThreadPoolTaskGroup *Group,
+            ThreadPoolTaskGroup *Dependency = nullptr) {
 
 #if LLVM_ENABLE_THREADS
     /// Wrap the Task in a std::function<void()> that sets the result of the
     /// corresponding future.
     auto R = createTaskAndFuture(Task);
-
-    int requestedThreads;
-    {
-      // Lock the queue and push the new task
-      std::unique_lock<std::mutex> LockGuard(QueueLock);
-
-      // Don't allow enqueueing after disabling the pool
-      assert(EnableFlag && "Queuing a thread during ThreadPool destruction");
-      Tasks.emplace_back(std::make_pair(std::move(R.first), Group));
-      requestedThreads = ActiveThreads + Tasks.size();
-    }
-    QueueCondition.notify_one();
-    grow(requestedThreads);
+    enqueueTask(std::move(R.first), Group, Dependency);
     return R.second.share();
 
 #else // LLVM_ENABLE_THREADS Disabled
@@ -173,11 +201,37 @@ private:
     auto Future = std::async(std::launch::deferred, std::move(Task)).share();
     // Wrap the future so that both ThreadPool::wait() can operate and the
     // returned future can be sync'ed on.
-    Tasks.emplace_back(std::make_pair([Future]() { Future.get(); }, Group));
+    enqueueTask([Future]() { Future.get(); }, Group, Dependency);
     return Future;
 #endif
   }
 
+  /// Pushes a task to the queue and, with threads enabled, makes sure a thread
+  /// is available to run it.
+  void enqueueTask(std::function<void()> Task, ThreadPoolTaskGroup *Group,
+                   ThreadPoolTaskGroup *Dependency);
+
+  /// Adds \p Task to the tasks waiting for execution. QueueLock must be
+  /// locked.
+  void insertTaskUnlocked(QueuedTask Task);
+
+  /// Puts a queued task in ReadyTasks, or in BlockedTasks or ThrottledTasks if
+  /// it cannot start yet. QueueLock must be locked.
+  void scheduleTaskUnlocked(QueuedTask Task);
+
+  /// Removes and returns the oldest task of the highest priority that can be
+  /// started. ReadyTasks must not be empty. QueueLock must be locked.
+  QueuedTask popReadyTaskUnlocked();
+
+  /// Makes the tasks waiting for \p Group to finish ready. Returns true if
+  /// there were any. QueueLock must be locked.
+  bool releaseBlockedTasksUnlocked(ThreadPoolTaskGroup *Group);
+
+  /// Records that a task of \p Group has finished, and lets the next task of
+  /// the group start if the group limits its concurrency. Returns true if a
+  /// task was made ready. QueueLock must be locked.
+  bool taskFinishedUnlocked(ThreadPoolTaskGroup *Group);
+
 #if LLVM_ENABLE_THREADS
   // Grow to ensure that we have at least `requested` Threads, but do not go
   // over MaxThreadCount.
@@ -191,10 +245,26 @@ private:
   /// Lock protecting access to the Threads vector.
   mutable llvm::sys::RWMutex ThreadsLock;
 
-  /// Tasks waiting for execution in the pool.
-  std::deque<std::pair<std::function<void()>, ThreadPoolTaskGroup *>> Tasks;
-
-  /// Locking and signaling for accessing the Tasks queue.
+  /// Tasks that can be started, in FIFO queues by decreasing priority (only
+  /// non-empty queues). Picking the next task is thus independent of the
+  /// number of queued tasks.
+  std::map<unsigned, std::deque<QueuedTask>, std::greater<unsigned>>
+      ReadyTasks;
+  /// Tasks submitted with asyncAfter() whose dependency has not finished yet,
+  /// by dependency.
+  DenseMap<ThreadPoolTaskGroup *, std::vector<QueuedTask>> BlockedTasks;
+  /// Tasks of groups that limit their concurrency and already have as many
+  /// tasks running or ready as they allow, by group.
+  DenseMap<ThreadPoolTaskGroup *, std::deque<QueuedTask>> ThrottledTasks;
+  /// Number of tasks running or in ReadyTasks for the groups that limit their
+  /// concurrency (only non-zero).
+  DenseMap<ThreadPoolTaskGroup *, unsigned> AdmittedGroups;
+  /// Number of queued tasks, ready, blocked or throttled.
+  unsigned NumQueuedTasks = 0;
+  /// Number of queued tasks in the given group (only non-zero).
+  DenseMap<ThreadPoolTaskGroup *, unsigned> QueuedGroups;
+
+  /// Locking and signaling for accessing the task queues.
   std::mutex QueueLock;
   std::condition_variable QueueCondition;
 
@@ -221,10 +291,16 @@ private:
 /// groups can run on the same threadpool but can be waited for separately.
 /// It is even possible for tasks of one group to submit and wait for tasks
 /// of another group, as long as this does not form a loop.
+///
+/// Queued tasks of groups with a higher \p Priority are started first. If
+/// \p MaxConcurrency is not 0, at most that many tasks of the group run at the
+/// same time.
 class ThreadPoolTaskGroup {
 public:
   /// The ThreadPool argument is the thread pool to forward calls to.
-  ThreadPoolTaskGroup(ThreadPool &Pool) : Pool(Pool) {}
+  ThreadPoolTaskGroup(ThreadPool &Pool, unsigned Priority = 0,
+                      unsigned MaxConcurrency = 0)
+      : Pool(Pool), Priority(Priority), MaxConcurrency(MaxConcurrency) {}
 
   /// Blocking destructor: will wait for all the tasks in the group to complete
   /// by calling ThreadPool::wait().
@@ -237,11 +313,29 @@ public:
                       std::forward<Args>(ArgList)...);
   }
 
+  /// Calls ThreadPool::asyncAfter() for this group.
+  template <typename Func>
+  inline auto asyncAfter(ThreadPoolTaskGroup &Dependency, Func &&F) {
+    return Pool.asyncAfter(Dependency, *this, std::forward<Func>(F));
+  }
+
   /// Calls ThreadPool::wait() for this group.
   void wait() { Pool.wait(*this); }
 
+  /// Asks the tasks of the group to stop. Cancellation is cooperative: queued
+  /// tasks still run, and it is up to the tasks to check isCancelled() and
+  /// return early.
+  void cancel() { Cancelled = true; }
+  bool isCancelled() const { return Cancelled; }
+
+  unsigned getPriority() const { return Priority; }
+  unsigned getMaxConcurrency() const { return MaxConcurrency; }
+
 private:
   ThreadPool &Pool;
+  const unsigned Priority;
+  const unsigned MaxConcurrency;
+  std::atomic<bool> Cancelled{false};
 };
 
 } // namespace llvm
@@ -88,9 +88,10 @@ TimeTraceProfiler *getTimeTraceProfilerInstance();
 
 /// Initialize the time trace profiler.
 /// This sets up the global \p TimeTraceProfilerInstance
-/// variable to be the profiler instance.
+/// variable to be the profiler instance. If \p Summary is set, the profiler
+/// also keeps the totals needed by timeTraceProfilerWriteSummary().
 void timeTraceProfilerInitialize(unsigned TimeTraceGranularity,
-                                 StringRef ProcName);
+                                 StringRef ProcName, bool Summary = false);
 
 /// Cleanup the time trace profiler, if it was initialized.
 void timeTraceProfilerCleanup();
@@ -116,6 +117,18 @@ void timeTraceProfilerWrite(raw_pwrite_stream &OS);
 Error timeTraceProfilerWrite(StringRef PreferredFileName,
                              StringRef FallbackFileName);
 
+/// Write a compact summary of the profiled events to \p OS. The profiler must
+/// have been initialized with \p Summary set.
+///
+/// The summary is a JSON object holding the number of occurrences and the
+/// total time of every event name and, for events that have a detail, of every
+/// name and detail pair; e.g. the inclusive time spent in each source file.
+/// Nested occurrences of the same event are only counted once. Unlike the
+/// trace, the summary also accounts for events shorter than the time trace
+/// granularity. Summaries of several processes can be combined by adding up
+/// the entries with the same name and detail.
+void timeTraceProfilerWriteSummary(raw_pwrite_stream &OS);
+
 /// Manually begin a time section, with the given \p Name and \p Detail.
 /// Profiler copies the string data, so the pointers can be given into
 /// temporaries. Time sections can be hierarchical; every Begin must have a
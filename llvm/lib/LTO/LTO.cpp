@@ -35,13 +35,13 @@
 #include "llvm/Linker/IRMover.h"
 #include "llvm/MC/TargetRegistry.h"
 #include "llvm/Object/IRObjectFile.h"
+#include "llvm/Support/BLAKE3.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
-#include "llvm/Support/SHA1.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Threading.h"
@@ -90,7 +90,9 @@ void llvm::computeLTOCacheKey(
   // This is based on the current compiler version, the module itself, the
   // export list, the hash for every single module in the import list, the
   // list of ResolvedODR for the module, and the list of preserved symbols.
-  SHA1 Hasher;
+  // BLAKE3 is used rather than SHA1 as it is much faster on the large inputs,
+  // e.g. the sample profile, which is hashed again for every module.
+  BLAKE3 Hasher;
 
   // Start with the compiler revision
   Hasher.update(LLVM_VERSION_STRING);
@@ -319,7 +321,8 @@ void llvm::computeLTOCacheKey(
     }
   }
 
-  Key = toHex(Hasher.result());
+  // Keep the 40 hex digits of the SHA1 keys.
+  Key = toHex(Hasher.result<20>());
 }
 
 static void thinLTOResolvePrevailingGUID(
@@ -11,9 +11,10 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Threading.h"
 
+#include <algorithm>
 #include <atomic>
+#include <deque>
 #include <future>
-#include <stack>
 #include <thread>
 #include <vector>
 
@@ -39,23 +40,49 @@ namespace {
 class Executor {
 public:
   virtual ~Executor() = default;
-  virtual void add(std::function<void()> func) = 0;
+  /// Queues \p func, a task of the TaskGroup whose latch is \p L.
+  virtual void add(std::function<void()> func, const Latch &L) = 0;
+  /// Waits until \p L is zero. Threads of the executor run the queued tasks
+  /// of the TaskGroup of \p L while they wait.
+  virtual void wait(const Latch &L) = 0;
+  /// Wakes up the threads that wait for a latch, after one was decremented.
+  virtual void notifyWaiters() = 0;
+  virtual unsigned getThreadCount() const = 0;
 
   static Executor *getDefaultExecutor();
 };
 
-/// An implementation of an Executor that runs closures on a thread pool
-///   in filo order.
+/// Set for the threads of the ThreadPoolExecutor.
+thread_local bool IsWorker = false;
+
+/// An implementation of an Executor that runs closures on a thread pool.
+///
+/// Every thread has its own queue. Tasks added by a thread of the pool go to
+/// the back of its queue, and the thread runs them in filo order. Idle
+/// threads steal the oldest task from the front of the other queues. Tasks
+/// added by other threads go to a shared queue. Each queue has its own mutex,
+/// so threads only contend when they steal or take a task from the shared
+/// queue.
+///
+/// A thread of the pool that waits for a TaskGroup, e.g. because a parallel
+/// algorithm is used from a task, runs the queued tasks of that group in the
+/// meantime. That makes nested parallelism possible without running out of
+/// threads. It never runs tasks of other groups while it waits: those could
+/// take arbitrarily long, or reenter a lock held by the waiting task. A task
+/// is thus only ever run on top of a task that (transitively) spawned it.
+/// This cannot deadlock: a queued task of the group can be run by the waiter
+/// itself, and a running one only waits for groups it created.
 class ThreadPoolExecutor : public Executor {
 public:
-  explicit ThreadPoolExecutor(ThreadPoolStrategy S = hardware_concurrency()) {
-    unsigned ThreadCount = S.compute_thread_count();
+  explicit ThreadPoolExecutor(ThreadPoolStrategy S = hardware_concurrency())
+      : ThreadCount(S.compute_thread_count()),
+        Queues(new TaskQueue[ThreadCount + 1]) {
     // Spawn all but one of the threads in another thread as spawning threads
     // can take a while.
     Threads.reserve(ThreadCount);
     Threads.resize(1);
     std::lock_guard<std::mutex> Lock(Mutex);
-    Threads[0] = std::thread([this, ThreadCount, S] {
+    Threads[0] = std::thread([this, S] {
       for (unsigned I = 1; I < ThreadCount; ++I) {
         Threads.emplace_back([=] { work(S, I); });
         if (Stop)
@@ -94,34 +121,141 @@ public:
     static void call(void *Ptr) { ((ThreadPoolExecutor *)Ptr)->stop(); }
   };
 
-  void add(std::function<void()> F) override {
+  void add(std::function<void()> F, const Latch &L) override {
+    TaskQueue &Queue = Queues[IsWorker ? threadIndex : ThreadCount];
     {
+      std::lock_guard<std::mutex> Lock(Queue.Mutex);
+      Queue.Tasks.push_back({std::move(F), &L});
+    }
+    ++QueuedTasks;
+    ++AddedTasks;
+    // Sleeping threads increment Sleepers or Waiters before they check
+    // QueuedTasks or AddedTasks, so either they see the new task or we see
+    // them.
+    if (Sleepers || Waiters) {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Cond.notify_one();
+      if (Waiters)
+        WaitCond.notify_all();
+    }
+  }
+
+  void wait(const Latch &L) override {
+    if (!IsWorker) {
+      L.sync();
+      return;
+    }
+    std::function<void()> Task;
+    while (!L.isZero()) {
+      unsigned Added = AddedTasks;
+      if (takeTask(threadIndex, Task, &L)) {
+        Task();
+        Task = nullptr;
+        continue;
+      }
+      // Keep running tasks after stop() as well, as no other thread may be
+      // left to run the ones L is waiting for. Sleep until a task was added
+      // since we looked, as it may belong to the group, or until the running
+      // tasks of the group are done.
+      std::unique_lock<std::mutex> Lock(Mutex);
+      ++Waiters;
+      WaitCond.wait(Lock, [&] { return AddedTasks != Added || L.isZero(); });
+      --Waiters;
+    }
+  }
+
+  void notifyWaiters() override {
+    if (Waiters) {
       std::lock_guard<std::mutex> Lock(Mutex);
-      WorkStack.push(std::move(F));
+      WaitCond.notify_all();
     }
-    Cond.notify_one();
   }
 
+  unsigned getThreadCount() const override { return ThreadCount; }
+
 private:
+  struct QueuedTask {
+    std::function<void()> Run;
+    /// The latch of the TaskGroup the task belongs to.
+    const Latch *Group;
+  };
+
+  struct TaskQueue {
+    std::mutex Mutex;
+    std::deque<QueuedTask> Tasks;
+  };
+
+  /// Takes a task from the back of the queue of \p ThreadID, or else from the
+  /// front of one of the other queues. If \p Group is set, only takes the
+  /// newest (own queue) or oldest (other queues) task of that group.
+  bool takeTask(unsigned ThreadID, std::function<void()> &Task,
+                const Latch *Group = nullptr) {
+    if (QueuedTasks == 0)
+      return false;
+    auto InGroup = [&](const QueuedTask &T) {
+      return !Group || T.Group == Group;
+    };
+    for (unsigned I = 0; I <= ThreadCount; ++I) {
+      TaskQueue &Queue = Queues[(ThreadID + I) % (ThreadCount + 1)];
+      std::lock_guard<std::mutex> Lock(Queue.Mutex);
+      if (Queue.Tasks.empty())
+        continue;
+      if (I == 0) {
+        // The group's tasks were most likely just spawned by this thread.
+        auto It = std::find_if(Queue.Tasks.rbegin(), Queue.Tasks.rend(),
+                               InGroup);
+        if (It == Queue.Tasks.rend())
+          continue;
+        Task = std::move(It->Run);
+        Queue.Tasks.erase(std::next(It).base());
+      } else {
+        auto It = std::find_if(Queue.Tasks.begin(), Queue.Tasks.end(),
+                               InGroup);
+        if (It == Queue.Tasks.end())
+          continue;
+        Task = std::move(It->Run);
+        Queue.Tasks.erase(It);
+      }
+      --QueuedTasks;
+      return true;
+    }
+    return false;
+  }
+
   void work(ThreadPoolStrategy S, unsigned ThreadID) {
     threadIndex = ThreadID;
+    IsWorker = true;
     S.apply_thread_strategy(ThreadID);
-    while (true) {
+    std::function<void()> Task;
+    while (!Stop) {
+      if (takeTask(ThreadID, Task)) {
+        Task();
+        Task = nullptr;
+        continue;
+      }
       std::unique_lock<std::mutex> Lock(Mutex);
-      Cond.wait(Lock, [&] { return Stop || !WorkStack.empty(); });
-      if (Stop)
-        break;
-      auto Task = std::move(WorkStack.top());
-      WorkStack.pop();
-      Lock.unlock();
-      Task();
+      ++Sleepers;
+      Cond.wait(Lock, [&] { return Stop || QueuedTasks != 0; });
+      --Sleepers;
     }
   }
 
+  const unsigned ThreadCount;
+  /// The queues of the threads, followed by the shared queue.
+  std::unique_ptr<TaskQueue[]> Queues;
   std::atomic<bool> Stop{false};
-  std::stack<std::function<void()>> WorkStack;
+  /// The number of tasks in all queues.
+  std::atomic<unsigned> QueuedTasks{0};
+  /// The number of tasks added so far (wrapping), so that a thread waiting
+  /// for a latch can tell whether a task was added since it last looked.
+  std::atomic<unsigned> AddedTasks{0};
+  /// The number of idle threads waiting on Cond.
+  std::atomic<unsigned> Sleepers{0};
+  /// The number of threads waiting on WaitCond for a latch.
+  std::atomic<unsigned> Waiters{0};
   std::mutex Mutex;
   std::condition_variable Cond;
+  std::condition_variable WaitCond;
   std::promise<void> ThreadsCreated;
   std::vector<std::thread> Threads;
 };
@@ -155,34 +289,46 @@ Executor *Executor::getDefaultExecutor() {
 } // namespace detail
 #endif
 
-static std::atomic<int> TaskGroupInstances;
+#if LLVM_ENABLE_THREADS
+TaskGroup::TaskGroup() : Parallel(strategy.ThreadsRequested != 1) {}
+#else
+TaskGroup::TaskGroup() : Parallel(false) {}
+#endif
 
-// Latch::sync() called by the dtor may cause one thread to block. If is a dead
-// lock if all threads in the default executor are blocked. To prevent the dead
-// lock, only allow the first TaskGroup to run tasks parallelly. In the scenario
-// of nested parallel_for_each(), only the outermost one runs parallelly.
-TaskGroup::TaskGroup() : Parallel(TaskGroupInstances++ == 0) {}
 TaskGroup::~TaskGroup() {
-  // We must ensure that all the workloads have finished before decrementing the
-  // instances count.
-  L.sync();
-  --TaskGroupInstances;
+  // We must ensure that all the workloads have finished before the latch is
+  // destroyed.
+  sync();
 }
 
 void TaskGroup::spawn(std::function<void()> F) {
 #if LLVM_ENABLE_THREADS
   if (Parallel) {
     L.inc();
-    detail::Executor::getDefaultExecutor()->add([&, F = std::move(F)] {
-      F();
-      L.dec();
-    });
+    detail::Executor *Exec = detail::Executor::getDefaultExecutor();
+    Exec->add(
+        [&, Exec, F = std::move(F)] {
+          F();
+          L.dec();
+          Exec->notifyWaiters();
+        },
+        L);
     return;
   }
 #endif
   F();
 }
 
+void TaskGroup::sync() const {
+#if LLVM_ENABLE_THREADS
+  if (Parallel) {
+    detail::Executor::getDefaultExecutor()->wait(L);
+    return;
+  }
+#endif
+  L.sync();
+}
+
 void TaskGroup::execute(std::function<void()> F) {
   if (parallel::strategy.ThreadsRequested == 1)
     F();
@@ -195,9 +341,7 @@ void TaskGroup::execute(std::function<void()> F) {
 void llvm::parallelFor(size_t Begin, size_t End,
                        llvm::function_ref<void(size_t)> Fn) {
   // If we have zero or one items, then do not incur the overhead of spinning up
-  // a task group.  They are surprisingly expensive, and because they do not
-  // support nested parallelism, a single entry task group can block parallel
-  // execution underneath them.
+  // a task group.  They are surprisingly expensive.
 #if LLVM_ENABLE_THREADS
   auto NumItems = End - Begin;
   if (NumItems > 1 && parallel::strategy.ThreadsRequested != 1) {
@@ -207,15 +351,25 @@ void llvm::parallelFor(size_t Begin, size_t End,
     if (TaskSize == 0)
       TaskSize = 1;
 
-    parallel::TaskGroup TG;
-    for (; Begin + TaskSize < End; Begin += TaskSize) {
-      TG.spawn([=, &Fn] {
-        for (size_t I = Begin, E = Begin + TaskSize; I != E; ++I)
+    // Rather than spawning a task for each batch of TaskSize items, spawn one
+    // task for each thread. The tasks and the calling thread take batches
+    // from a shared counter until all items are done.
+    std::atomic<size_t> Next(Begin);
+    auto RunBatches = [&] {
+      for (size_t I = Next.fetch_add(TaskSize); I < End;
+           I = Next.fetch_add(TaskSize))
+        for (size_t E = std::min(I + TaskSize, End); I != E; ++I)
           Fn(I);
-      });
-    }
-    for (; Begin != End; ++Begin)
-      Fn(Begin);
+    };
+    size_t NumBatches = (NumItems + TaskSize - 1) / TaskSize;
+    size_t NumTasks = std::min<size_t>(
+        parallel::detail::Executor::getDefaultExecutor()->getThreadCount(),
+        NumBatches);
+
+    parallel::TaskGroup TG;
+    for (size_t I = 1; I < NumTasks; ++I)
+      TG.spawn(RunBatches);
+    RunBatches();
     return;
   }
 #endif
@@ -223,3 +377,19 @@ void llvm::parallelFor(size_t Begin, size_t End,
   for (; Begin != End; ++Begin)
     Fn(Begin);
 }
+
+void llvm::parallelHash(
+    MutableArrayRef<uint8_t> Hash, ArrayRef<uint8_t> Data,
+    function_ref<void(uint8_t *, ArrayRef<uint8_t>)> HashFn, size_t ChunkSize) {
+  assert(ChunkSize != 0 && "Chunks must not be empty");
+  size_t HashSize = Hash.size();
+  size_t NumChunks = divideCeil(Data.size(), ChunkSize);
+  std::unique_ptr<uint8_t[]> Hashes(new uint8_t[NumChunks * HashSize]);
+
+  parallelFor(0, NumChunks, [&](size_t I) {
+    HashFn(Hashes.get() + I * HashSize, Data.slice(I * ChunkSize).take_front(
+                                            ChunkSize));
+  });
+
+  HashFn(Hash.data(), makeArrayRef(Hashes.get(), NumChunks * HashSize));
+}
@@ -22,15 +22,92 @@
 
 using namespace llvm;
 
+void ThreadPool::insertTaskUnlocked(QueuedTask Task) {
+  if (Task.Group != nullptr)
+    ++QueuedGroups[Task.Group];
+  ++NumQueuedTasks;
+  scheduleTaskUnlocked(std::move(Task));
+}
+
+void ThreadPool::scheduleTaskUnlocked(QueuedTask Task) {
+  if (Task.Dependency != nullptr) {
+    BlockedTasks[Task.Dependency].push_back(std::move(Task));
+    return;
+  }
+  ThreadPoolTaskGroup *Group = Task.Group;
+  if (Group != nullptr && Group->getMaxConcurrency() != 0) {
+    unsigned &Admitted = AdmittedGroups[Group];
+    if (Admitted == Group->getMaxConcurrency()) {
+      ThrottledTasks[Group].push_back(std::move(Task));
+      return;
+    }
+    ++Admitted;
+  }
+  unsigned Priority = Task.Priority;
+  ReadyTasks[Priority].push_back(std::move(Task));
+}
+
+ThreadPool::QueuedTask ThreadPool::popReadyTaskUnlocked() {
+  auto Queue = ReadyTasks.begin();
+  QueuedTask Task = std::move(Queue->second.front());
+  Queue->second.pop_front();
+  if (Queue->second.empty())
+    ReadyTasks.erase(Queue);
+  --NumQueuedTasks;
+  if (Task.Group != nullptr) {
+    auto Q = QueuedGroups.find(Task.Group);
+    if (--(Q->second) == 0)
+      QueuedGroups.erase(Q);
+  }
+  return Task;
+}
+
+bool ThreadPool::releaseBlockedTasksUnlocked(ThreadPoolTaskGroup *Group) {
+  auto Blocked = BlockedTasks.find(Group);
+  if (Blocked == BlockedTasks.end())
+    return false;
+  std::vector<QueuedTask> Released = std::move(Blocked->second);
+  BlockedTasks.erase(Blocked);
+  for (QueuedTask &T : Released) {
+    T.Dependency = nullptr;
+    scheduleTaskUnlocked(std::move(T));
+  }
+  return true;
+}
+
+bool ThreadPool::taskFinishedUnlocked(ThreadPoolTaskGroup *Group) {
+  if (Group == nullptr || Group->getMaxConcurrency() == 0)
+    return false;
+  auto A = AdmittedGroups.find(Group);
+  if (--(A->second) == 0)
+    AdmittedGroups.erase(A);
+  auto Throttled = ThrottledTasks.find(Group);
+  if (Throttled == ThrottledTasks.end())
+    return false;
+  QueuedTask Task = std::move(Throttled->second.front());
+  Throttled->second.pop_front();
+  if (Throttled->second.empty())
+    ThrottledTasks.erase(Throttled);
+  scheduleTaskUnlocked(std::move(Task));
+  return true;
+}
+
 #if LLVM_ENABLE_THREADS
 
 // A note on thread groups: Tasks are by default in no group (represented
-// by nullptr ThreadPoolTaskGroup pointer in the Tasks queue) and functionality
+// by nullptr ThreadPoolTaskGroup pointer in the task queues) and functionality
 // here normally works on all tasks regardless of their group (functions
 // in that case receive nullptr ThreadPoolTaskGroup pointer as argument).
-// A task in a group has a pointer to that ThreadPoolTaskGroup in the Tasks
-// queue, and functions called to work only on tasks from one group take that
+// A task in a group has a pointer to that ThreadPoolTaskGroup in the task
+// queues, and functions called to work only on tasks from one group take that
 // pointer.
+//
+// A task submitted with asyncAfter() waits in BlockedTasks until the last task
+// of its Dependency finishes, at which point processTasks() moves it to
+// ReadyTasks. A Dependency pointer is thus never used after its group has
+// finished (and may have been destroyed). Likewise, a task of a group that
+// limits its concurrency waits in ThrottledTasks until a task of the group
+// finishes. Every task in ReadyTasks can be started right away.
 
 ThreadPool::ThreadPool(ThreadPoolStrategy S)
     : Strategy(S), MaxThreadCount(S.compute_thread_count()) {}
@@ -49,6 +126,28 @@ void ThreadPool::grow(int requested) {
   }
 }
 
+void ThreadPool::enqueueTask(std::function<void()> Task,
+                             ThreadPoolTaskGroup *Group,
+                             ThreadPoolTaskGroup *Dependency) {
+  assert((Group == nullptr || Group != Dependency) &&
+         "A task cannot wait for its own group");
+  int requestedThreads;
+  {
+    // Lock the queue and push the new task
+    std::unique_lock<std::mutex> LockGuard(QueueLock);
+
+    // Don't allow enqueueing after disabling the pool
+    assert(EnableFlag && "Queuing a thread during ThreadPool destruction");
+    if (Dependency != nullptr && workCompletedUnlocked(Dependency))
+      Dependency = nullptr;
+    unsigned Priority = Group != nullptr ? Group->getPriority() : 0;
+    insertTaskUnlocked({std::move(Task), Group, Dependency, Priority});
+    requestedThreads = ActiveThreads + NumQueuedTasks;
+  }
+  QueueCondition.notify_one();
+  grow(requestedThreads);
+}
+
 #ifndef NDEBUG
 // The group of the tasks run by the current thread.
 static LLVM_THREAD_LOCAL std::vector<ThreadPoolTaskGroup *>
@@ -62,18 +161,15 @@ void ThreadPool::processTasks(ThreadPoolTaskGroup *WaitingForGroup) {
     ThreadPoolTaskGroup *GroupOfTask;
     {
       std::unique_lock<std::mutex> LockGuard(QueueLock);
-      bool workCompletedForGroup = false; // Result of workCompletedUnlocked()
-      // Wait for tasks to be pushed in the queue
+      // Wait for a task that can be started to be pushed in the queue, or for
+      // the group to finish.
       QueueCondition.wait(LockGuard, [&] {
-        return !EnableFlag || !Tasks.empty() ||
+        return !ReadyTasks.empty() || (!EnableFlag && NumQueuedTasks == 0) ||
                (WaitingForGroup != nullptr &&
-                (workCompletedForGroup =
-                     workCompletedUnlocked(WaitingForGroup)));
+                workCompletedUnlocked(WaitingForGroup));
       });
       // Exit condition
-      if (!EnableFlag && Tasks.empty())
-        return;
-      if (WaitingForGroup != nullptr && workCompletedForGroup)
+      if (ReadyTasks.empty())
         return;
       // Yeah, we have a task, grab it and release the lock on the queue
 
@@ -81,13 +177,13 @@ void ThreadPool::processTasks(ThreadPoolTaskGroup *WaitingForGroup) {
       // in order for wait() to properly detect that even if the queue is
       // empty, there is still a task in flight.
       ++ActiveThreads;
-      Task = std::move(Tasks.front().first);
-      GroupOfTask = Tasks.front().second;
+      QueuedTask Next = popReadyTaskUnlocked();
+      Task = std::move(Next.Run);
+      GroupOfTask = Next.Group;
       // Need to count active threads in each group separately, ActiveThreads
       // would never be 0 if waiting for another group inside a wait.
       if (GroupOfTask != nullptr)
         ++ActiveGroups[GroupOfTask]; // Increment or set to 1 if new item
-      Tasks.pop_front();
     }
 #ifndef NDEBUG
     if (CurrentThreadTaskGroups == nullptr)
@@ -108,6 +204,7 @@ void ThreadPool::processTasks(ThreadPoolTaskGroup *WaitingForGroup) {
 
     bool Notify;
     bool NotifyGroup;
+    bool NotifyLimitedGroup;
     {
       // Adjust `ActiveThreads`, in case someone waits on ThreadPool::wait()
       std::lock_guard<std::mutex> LockGuard(QueueLock);
@@ -117,8 +214,13 @@ void ThreadPool::processTasks(ThreadPoolTaskGroup *WaitingForGroup) {
         if (--(A->second) == 0)
           ActiveGroups.erase(A);
       }
+      // Another task of the group may be waiting for this one to finish.
+      NotifyLimitedGroup = taskFinishedUnlocked(GroupOfTask);
       Notify = workCompletedUnlocked(GroupOfTask);
       NotifyGroup = GroupOfTask != nullptr && Notify;
+      // The tasks waiting for this group can start now.
+      if (NotifyGroup)
+        releaseBlockedTasksUnlocked(GroupOfTask);
     }
     // Notify task completion if this is the last active thread, in case
     // someone waits on ThreadPool::wait().
@@ -126,18 +228,19 @@ void ThreadPool::processTasks(ThreadPoolTaskGroup *WaitingForGroup) {
       CompletionCondition.notify_all();
     // If this was a task in a group, notify also threads waiting for tasks
     // in this function on QueueCondition, to make a recursive wait() return
-    // after the group it's been waiting for has finished.
+    // after the group it's been waiting for has finished, and to start the
+    // tasks that were waiting for the group.
     if (NotifyGroup)
       QueueCondition.notify_all();
+    else if (NotifyLimitedGroup)
+      QueueCondition.notify_one();
   }
 }
 
 bool ThreadPool::workCompletedUnlocked(ThreadPoolTaskGroup *Group) const {
   if (Group == nullptr)
-    return !ActiveThreads && Tasks.empty();
-  return ActiveGroups.count(Group) == 0 &&
-         !llvm::any_of(Tasks,
-                       [Group](const auto &T) { return T.second == Group; });
+    return !ActiveThreads && NumQueuedTasks == 0;
+  return ActiveGroups.count(Group) == 0 && QueuedGroups.count(Group) == 0;
 }
 
 void ThreadPool::wait() {
@@ -197,12 +300,28 @@ ThreadPool::ThreadPool(ThreadPoolStrategy S) : MaxThreadCount(1) {
   }
 }
 
+void ThreadPool::enqueueTask(std::function<void()> Task,
+                             ThreadPoolTaskGroup *Group,
+                             ThreadPoolTaskGroup *Dependency) {
+  assert((Group == nullptr || Group != Dependency) &&
+         "A task cannot wait for its own group");
+  if (Dependency != nullptr && QueuedGroups.count(Dependency) == 0)
+    Dependency = nullptr;
+  unsigned Priority = Group != nullptr ? Group->getPriority() : 0;
+  insertTaskUnlocked({std::move(Task), Group, Dependency, Priority});
+}
+
 void ThreadPool::wait() {
-  // Sequential implementation running the tasks
-  while (!Tasks.empty()) {
-    auto Task = std::move(Tasks.front().first);
-    Tasks.pop_front();
-    Task();
+  // Sequential implementation running the tasks, a task submitted with
+  // asyncAfter() after the queued tasks of its dependency.
+  while (NumQueuedTasks != 0) {
+    assert(!ReadyTasks.empty() && "Task groups depend on each other");
+    QueuedTask Next = popReadyTaskUnlocked();
+    ThreadPoolTaskGroup *Group = Next.Group;
+    Next.Run();
+    taskFinishedUnlocked(Group);
+    if (Group != nullptr && QueuedGroups.count(Group) == 0)
+      releaseBlockedTasksUnlocked(Group);
   }
 }
 
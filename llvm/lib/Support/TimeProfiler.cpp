@@ -22,6 +22,7 @@
 #include <chrono>
 #include <mutex>
 #include <string>
+#include <tuple>
 #include <vector>
 
 using namespace llvm;
@@ -95,10 +96,12 @@ struct TimeTraceProfilerEntry {
 } // anonymous namespace
 
 struct llvm::TimeTraceProfiler {
-  TimeTraceProfiler(unsigned TimeTraceGranularity = 0, StringRef ProcName = "")
+  TimeTraceProfiler(unsigned TimeTraceGranularity = 0, StringRef ProcName = "",
+                    bool Summary = false)
       : BeginningOfTime(system_clock::now()), StartTime(ClockType::now()),
         ProcName(ProcName), Pid(sys::Process::getProcessId()),
-        Tid(llvm::get_threadid()), TimeTraceGranularity(TimeTraceGranularity) {
+        Tid(llvm::get_threadid()), TimeTraceGranularity(TimeTraceGranularity),
+        Summary(Summary) {
     llvm::get_thread_name(ThreadName);
   }
 
@@ -140,9 +143,49 @@ struct llvm::TimeTraceProfiler {
       CountAndTotal.second += Duration;
     }
 
+    // Likewise, track the total time taken by each "name" and "detail" pair,
+    // e.g. the inclusive time spent in a source file, counting only the
+    // topmost entry if the same pair is open more than once. These are only
+    // needed for the summary.
+    if (Summary && !E.Detail.empty() &&
+        llvm::none_of(llvm::drop_begin(llvm::reverse(Stack)),
+                      [&](const TimeTraceProfilerEntry &Val) {
+                        return Val.Name == E.Name && Val.Detail == E.Detail;
+                      })) {
+      auto &CountAndTotal = CountAndTotalPerDetail[E.Name][E.Detail];
+      CountAndTotal.first++;
+      CountAndTotal.second += Duration;
+    }
+
     Stack.pop_back();
   }
 
+  // Combine the totals of this and all finished thread instances. The caller
+  // must hold the lock of the instances.
+  void combineTotals(
+      const TimeTraceProfilerInstances &Instances,
+      StringMap<CountAndDurationType> &PerName,
+      StringMap<StringMap<CountAndDurationType>> *PerDetail) const {
+    auto combineStat = [](StringMap<CountAndDurationType> &Totals,
+                          const auto &Stat) {
+      auto &CountAndTotal = Totals[Stat.getKey()];
+      CountAndTotal.first += Stat.getValue().first;
+      CountAndTotal.second += Stat.getValue().second;
+    };
+    auto combine = [&](const TimeTraceProfiler &TTP) {
+      for (const auto &Stat : TTP.CountAndTotalPerName)
+        combineStat(PerName, Stat);
+      if (!PerDetail)
+        return;
+      for (const auto &Name : TTP.CountAndTotalPerDetail)
+        for (const auto &Stat : Name.getValue())
+          combineStat((*PerDetail)[Name.getKey()], Stat);
+    };
+    combine(*this);
+    for (const TimeTraceProfiler *TTP : Instances.List)
+      combine(*TTP);
+  }
+
   // Write events from this TimeTraceProfilerInstance and
   // ThreadTimeTraceProfilerInstances.
   void write(raw_pwrite_stream &OS) {
@@ -192,18 +235,7 @@ struct llvm::TimeTraceProfiler {
 
     // Combine all CountAndTotalPerName from threads into one.
     StringMap<CountAndDurationType> AllCountAndTotalPerName;
-    auto combineStat = [&](const auto &Stat) {
-      StringRef Key = Stat.getKey();
-      auto Value = Stat.getValue();
-      auto &CountAndTotal = AllCountAndTotalPerName[Key];
-      CountAndTotal.first += Value.first;
-      CountAndTotal.second += Value.second;
-    };
-    for (const auto &Stat : CountAndTotalPerName)
-      combineStat(Stat);
-    for (const TimeTraceProfiler *TTP : Instances.List)
-      for (const auto &Stat : TTP->CountAndTotalPerName)
-        combineStat(Stat);
+    combineTotals(Instances, AllCountAndTotalPerName, /*PerDetail=*/nullptr);
 
     std::vector<NameAndCountAndDurationType> SortedTotals;
     SortedTotals.reserve(AllCountAndTotalPerName.size());
@@ -269,9 +301,63 @@ struct llvm::TimeTraceProfiler {
     J.objectEnd();
   }
 
+  // Write the totals from this TimeTraceProfilerInstance and
+  // ThreadTimeTraceProfilerInstances.
+  void writeSummary(raw_pwrite_stream &OS) {
+    auto &Instances = getTimeTraceProfilerInstances();
+    std::lock_guard<std::mutex> Lock(Instances.Lock);
+    assert(Summary && "Summary was not requested at initialization");
+    assert(Stack.empty() &&
+           "All profiler sections should be ended when calling writeSummary");
+
+    StringMap<CountAndDurationType> PerName;
+    StringMap<StringMap<CountAndDurationType>> PerDetail;
+    combineTotals(Instances, PerName, &PerDetail);
+
+    struct SummaryEntry {
+      StringRef Name;
+      StringRef Detail;
+      CountAndDurationType CountAndTotal;
+    };
+    std::vector<SummaryEntry> Sorted;
+    for (const auto &Total : PerName)
+      Sorted.push_back({Total.getKey(), StringRef(), Total.getValue()});
+    for (const auto &Name : PerDetail)
+      for (const auto &Total : Name.getValue())
+        Sorted.push_back({Name.getKey(), Total.getKey(), Total.getValue()});
+
+    // Longest first; ties are broken by name and detail to keep the output
+    // stable.
+    llvm::sort(Sorted, [](const SummaryEntry &A, const SummaryEntry &B) {
+      if (A.CountAndTotal.second != B.CountAndTotal.second)
+        return A.CountAndTotal.second > B.CountAndTotal.second;
+      return std::tie(A.Name, A.Detail) < std::tie(B.Name, B.Detail);
+    });
+
+    json::OStream J(OS);
+    J.object([&] {
+      J.attribute("version", 1);
+      J.attribute("process", ProcName);
+      J.attributeArray("events", [&] {
+        for (const SummaryEntry &E : Sorted) {
+          J.object([&] {
+            J.attribute("name", E.Name);
+            if (!E.Detail.empty())
+              J.attribute("detail", E.Detail);
+            J.attribute("count", int64_t(E.CountAndTotal.first));
+            J.attribute(
+                "dur",
+                duration_cast<microseconds>(E.CountAndTotal.second).count());
+          });
+        }
+      });
+    });
+  }
+
   SmallVector<TimeTraceProfilerEntry, 16> Stack;
   SmallVector<TimeTraceProfilerEntry, 128> Entries;
   StringMap<CountAndDurationType> CountAndTotalPerName;
+  StringMap<StringMap<CountAndDurationType>> CountAndTotalPerDetail;
   // System clock time when the session was begun.
   const time_point<system_clock> BeginningOfTime;
   // Profiling clock time when the session was begun.
@@ -283,14 +369,17 @@ struct llvm::TimeTraceProfiler {
 
   // Minimum time granularity (in microseconds)
   const unsigned TimeTraceGranularity;
+
+  // Whether to track the totals per name and detail for writeSummary().
+  const bool Summary;
 };
 
 void llvm::timeTraceProfilerInitialize(unsigned TimeTraceGranularity,
-                                       StringRef ProcName) {
+                                       StringRef ProcName, bool Summary) {
   assert(TimeTraceProfilerInstance == nullptr &&
          "Profiler should not be initialized");
   TimeTraceProfilerInstance = new TimeTraceProfiler(
-      TimeTraceGranularity, llvm::sys::path::filename(ProcName));
+      TimeTraceGranularity, llvm::sys::path::filename(ProcName), Summary);
 }
 
 // Removes all TimeTraceProfilerInstances.
@@ -321,6 +410,12 @@ void llvm::timeTraceProfilerWrite(raw_pwrite_stream &OS) {
   TimeTraceProfilerInstance->write(OS);
 }
 
+void llvm::timeTraceProfilerWriteSummary(raw_pwrite_stream &OS) {
+  assert(TimeTraceProfilerInstance != nullptr &&
+         "Profiler object can't be null");
+  TimeTraceProfilerInstance->writeSummary(OS);
+}
+
 Error llvm::timeTraceProfilerWrite(StringRef PreferredFileName,
                                    StringRef FallbackFileName) {
   assert(TimeTraceProfilerInstance != nullptr &&
@@ -33,13 +33,19 @@
 */
 
 /* based on revision d2df04efcbef7d7f6886d345861e5dfda4edacc1 Removed
- * everything but a simple interface for computing XXh64. */
+ * everything but a simple interface for computing XXh64. XXH3 is based on
+ * release 0.8.1, with only the default secret and seed. */
 
 #include "llvm/Support/xxhash.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/Endian.h"
 
 #include <stdlib.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using namespace llvm;
 using namespace support;
 
@@ -135,3 +141,459 @@ uint64_t llvm::xxHash64(StringRef Data) {
 uint64_t llvm::xxHash64(ArrayRef<uint8_t> Data) {
   return xxHash64({(const char *)Data.data(), Data.size()});
 }
+
+//===----------------------------------------------------------------------===//
+// XXH3
+//===----------------------------------------------------------------------===//
+
+static const uint32_t PRIME32_1 = 0x9E3779B1U;
+static const uint32_t PRIME32_2 = 0x85EBCA77U;
+static const uint32_t PRIME32_3 = 0xC2B2AE3DU;
+static const uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+static const uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+// The default secret of XXH3.
+static const size_t SecretSize = 192;
+alignas(64) static const uint8_t Secret[SecretSize] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+    0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+    0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+    0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+    0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+    0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+    0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+    0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+    0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+    0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+    0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+    0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+    0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+// Constants of the midsize and long hashes.
+static const size_t StripeLen = 64;
+static const size_t SecretConsumeRate = 8;
+static const size_t NumStripesPerBlock =
+    (SecretSize - StripeLen) / SecretConsumeRate;
+static const size_t BlockLen = StripeLen * NumStripesPerBlock;
+static const size_t SecretLastAccStart = 7;
+static const size_t SecretMergeAccsStart = 11;
+static const size_t SecretSizeMin = 136;
+static const size_t MidSizeStartOffset = 3;
+static const size_t MidSizeLastOffset = 17;
+
+static uint32_t rotl32(uint32_t X, size_t R) {
+  return (X << R) | (X >> (32 - R));
+}
+
+static XXH128_hash_t mult64to128(uint64_t LHS, uint64_t RHS) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t Product = (__uint128_t)LHS * RHS;
+  return {uint64_t(Product), uint64_t(Product >> 64)};
+#else
+  uint64_t LoLo = (LHS & 0xFFFFFFFF) * (RHS & 0xFFFFFFFF);
+  uint64_t HiLo = (LHS >> 32) * (RHS & 0xFFFFFFFF);
+  uint64_t LoHi = (LHS & 0xFFFFFFFF) * (RHS >> 32);
+  uint64_t HiHi = (LHS >> 32) * (RHS >> 32);
+  uint64_t Cross = (LoLo >> 32) + (HiLo & 0xFFFFFFFF) + LoHi;
+  uint64_t Upper = (HiLo >> 32) + (Cross >> 32) + HiHi;
+  uint64_t Lower = (Cross << 32) | (LoLo & 0xFFFFFFFF);
+  return {Lower, Upper};
+#endif
+}
+
+/// Multiplies two 64-bit values into 128 bits and folds the halves together.
+static uint64_t mul128Fold64(uint64_t LHS, uint64_t RHS) {
+  XXH128_hash_t Product = mult64to128(LHS, RHS);
+  return Product.low64 ^ Product.high64;
+}
+
+static uint64_t XXH64_avalanche(uint64_t Hash) {
+  Hash ^= Hash >> 33;
+  Hash *= PRIME64_2;
+  Hash ^= Hash >> 29;
+  Hash *= PRIME64_3;
+  Hash ^= Hash >> 32;
+  return Hash;
+}
+
+static uint64_t XXH3_avalanche(uint64_t Hash) {
+  Hash ^= Hash >> 37;
+  Hash *= PRIME_MX1;
+  Hash ^= Hash >> 32;
+  return Hash;
+}
+
+// A stronger avalanche than XXH3_avalanche for the 4 to 8 bytes inputs.
+static uint64_t rrmxmx(uint64_t H64, uint64_t Len) {
+  H64 ^= rotl64(H64, 49) ^ rotl64(H64, 24);
+  H64 *= PRIME_MX2;
+  H64 ^= (H64 >> 35) + Len;
+  H64 *= PRIME_MX2;
+  H64 ^= H64 >> 28;
+  return H64;
+}
+
+static uint64_t mix16B(const uint8_t *Input, const uint8_t *Sec, uint64_t Seed) {
+  uint64_t InputLo = endian::read64le(Input);
+  uint64_t InputHi = endian::read64le(Input + 8);
+  return mul128Fold64(InputLo ^ (endian::read64le(Sec) + Seed),
+                      InputHi ^ (endian::read64le(Sec + 8) - Seed));
+}
+
+// The 128-bit hashes mix two 16-byte blocks into both halves of the hash.
+static XXH128_hash_t mix32B(XXH128_hash_t Acc, const uint8_t *Input1,
+                            const uint8_t *Input2, const uint8_t *Sec,
+                            uint64_t Seed) {
+  Acc.low64 += mix16B(Input1, Sec, Seed);
+  Acc.low64 ^= endian::read64le(Input2) + endian::read64le(Input2 + 8);
+  Acc.high64 += mix16B(Input2, Sec + 16, Seed);
+  Acc.high64 ^= endian::read64le(Input1) + endian::read64le(Input1 + 8);
+  return Acc;
+}
+
+#if defined(__SSE2__)
+// Adds 16 bytes of a stripe to their two accumulators.
+static inline __m128i accumulate128(__m128i Acc, const uint8_t *Input,
+                                    const uint8_t *Sec) {
+  __m128i DataVec = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Input));
+  __m128i KeyVec = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Sec));
+  __m128i DataKey = _mm_xor_si128(DataVec, KeyVec);
+  // Multiply the low and high 32 bits of each 64-bit lane.
+  __m128i DataKeyHi = _mm_shuffle_epi32(DataKey, _MM_SHUFFLE(0, 3, 0, 1));
+  __m128i Product = _mm_mul_epu32(DataKey, DataKeyHi);
+  // Add the input to the other lane of the pair.
+  __m128i DataSwap = _mm_shuffle_epi32(DataVec, _MM_SHUFFLE(1, 0, 3, 2));
+  return _mm_add_epi64(Product, _mm_add_epi64(Acc, DataSwap));
+}
+
+// Adds NumStripes 64-byte stripes of the input to the accumulators.
+static void accumulate(uint64_t *Acc, const uint8_t *Input, const uint8_t *Sec,
+                       size_t NumStripes) {
+  // Keep the accumulators in registers for the whole loop. Compilers do not
+  // always unroll a loop over them, which leaves them in memory.
+  __m128i *XAcc = reinterpret_cast<__m128i *>(Acc);
+  __m128i Acc0 = XAcc[0], Acc1 = XAcc[1], Acc2 = XAcc[2], Acc3 = XAcc[3];
+  for (size_t N = 0; N < NumStripes; ++N) {
+    const uint8_t *In = Input + N * StripeLen;
+    const uint8_t *Key = Sec + N * SecretConsumeRate;
+    Acc0 = accumulate128(Acc0, In, Key);
+    Acc1 = accumulate128(Acc1, In + 16, Key + 16);
+    Acc2 = accumulate128(Acc2, In + 32, Key + 32);
+    Acc3 = accumulate128(Acc3, In + 48, Key + 48);
+  }
+  XAcc[0] = Acc0;
+  XAcc[1] = Acc1;
+  XAcc[2] = Acc2;
+  XAcc[3] = Acc3;
+}
+
+// Scrambles the accumulators after every block.
+static void scrambleAcc(uint64_t *Acc, const uint8_t *Sec) {
+  __m128i *XAcc = reinterpret_cast<__m128i *>(Acc);
+  const __m128i Prime32 = _mm_set1_epi32(int(PRIME32_1));
+  for (size_t I = 0; I < StripeLen / 16; ++I) {
+    __m128i AccVec = XAcc[I];
+    __m128i Shifted = _mm_srli_epi64(AccVec, 47);
+    __m128i DataVec = _mm_xor_si128(AccVec, Shifted);
+    __m128i KeyVec = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Sec) + I);
+    __m128i DataKey = _mm_xor_si128(DataVec, KeyVec);
+    // Multiply each 64-bit lane by PRIME32_1 with 32-bit multiplications.
+    __m128i DataKeyHi = _mm_shuffle_epi32(DataKey, _MM_SHUFFLE(0, 3, 0, 1));
+    __m128i ProdLo = _mm_mul_epu32(DataKey, Prime32);
+    __m128i ProdHi = _mm_mul_epu32(DataKeyHi, Prime32);
+    XAcc[I] = _mm_add_epi64(ProdLo, _mm_slli_epi64(ProdHi, 32));
+  }
+}
+#else
+// Adds a 64-byte stripe of the input to the accumulators.
+static void accumulate512(uint64_t *Acc, const uint8_t *Input,
+                          const uint8_t *Sec) {
+  for (size_t I = 0; I < 8; ++I) {
+    uint64_t DataVal = endian::read64le(Input + 8 * I);
+    uint64_t DataKey = DataVal ^ endian::read64le(Sec + 8 * I);
+    Acc[I ^ 1] += DataVal;
+    Acc[I] += uint32_t(DataKey) * (DataKey >> 32);
+  }
+}
+
+static void accumulate(uint64_t *Acc, const uint8_t *Input, const uint8_t *Sec,
+                       size_t NumStripes) {
+  for (size_t N = 0; N < NumStripes; ++N)
+    accumulate512(Acc, Input + N * StripeLen, Sec + N * SecretConsumeRate);
+}
+
+// Scrambles the accumulators after every block.
+static void scrambleAcc(uint64_t *Acc, const uint8_t *Sec) {
+  for (size_t I = 0; I < 8; ++I) {
+    uint64_t Acc64 = Acc[I];
+    Acc64 ^= Acc64 >> 47;
+    Acc64 ^= endian::read64le(Sec + 8 * I);
+    Acc64 *= PRIME32_1;
+    Acc[I] = Acc64;
+  }
+}
+#endif
+
+// Computes the accumulators of an input longer than 240 bytes.
+static void hashLongInternalLoop(uint64_t *Acc, const uint8_t *Input,
+                                 size_t Len) {
+  size_t NumBlocks = (Len - 1) / BlockLen;
+  for (size_t N = 0; N < NumBlocks; ++N) {
+    accumulate(Acc, Input + N * BlockLen, Secret, NumStripesPerBlock);
+    scrambleAcc(Acc, Secret + SecretSize - StripeLen);
+  }
+
+  // The last partial block, and the last stripe.
+  size_t NumStripes = ((Len - 1) - BlockLen * NumBlocks) / StripeLen;
+  accumulate(Acc, Input + NumBlocks * BlockLen, Secret, NumStripes);
+  accumulate(Acc, Input + Len - StripeLen,
+             Secret + SecretSize - StripeLen - SecretLastAccStart, 1);
+}
+
+static uint64_t mergeAccs(const uint64_t *Acc, const uint8_t *Sec,
+                          uint64_t Start) {
+  uint64_t Result = Start;
+  for (size_t I = 0; I < 4; ++I)
+    Result += mul128Fold64(Acc[2 * I] ^ endian::read64le(Sec + 16 * I),
+                           Acc[2 * I + 1] ^ endian::read64le(Sec + 16 * I + 8));
+  return XXH3_avalanche(Result);
+}
+
+#define XXH3_INIT_ACC                                                          \
+  {                                                                            \
+    PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2,          \
+        PRIME64_5, PRIME32_1                                                   \
+  }
+
+LLVM_ATTRIBUTE_NOINLINE
+static uint64_t XXH3_hashLong_64b(const uint8_t *Input, size_t Len) {
+  alignas(16) uint64_t Acc[8] = XXH3_INIT_ACC;
+  hashLongInternalLoop(Acc, Input, Len);
+  return mergeAccs(Acc, Secret + SecretMergeAccsStart,
+                   uint64_t(Len) * PRIME64_1);
+}
+
+static uint64_t XXH3_len_1to3_64b(const uint8_t *Input, size_t Len) {
+  uint8_t C1 = Input[0];
+  uint8_t C2 = Input[Len >> 1];
+  uint8_t C3 = Input[Len - 1];
+  uint32_t Combined = (uint32_t(C1) << 16) | (uint32_t(C2) << 24) |
+                      (uint32_t(C3) << 0) | (uint32_t(Len) << 8);
+  uint64_t Bitflip =
+      uint64_t(endian::read32le(Secret) ^ endian::read32le(Secret + 4));
+  return XXH64_avalanche(uint64_t(Combined) ^ Bitflip);
+}
+
+static uint64_t XXH3_len_4to8_64b(const uint8_t *Input, size_t Len) {
+  uint32_t Input1 = endian::read32le(Input);
+  uint32_t Input2 = endian::read32le(Input + Len - 4);
+  uint64_t Bitflip = endian::read64le(Secret + 8) ^ endian::read64le(Secret + 16);
+  uint64_t Input64 = Input2 + (uint64_t(Input1) << 32);
+  return rrmxmx(Input64 ^ Bitflip, Len);
+}
+
+static uint64_t XXH3_len_9to16_64b(const uint8_t *Input, size_t Len) {
+  uint64_t Bitflip1 =
+      endian::read64le(Secret + 24) ^ endian::read64le(Secret + 32);
+  uint64_t Bitflip2 =
+      endian::read64le(Secret + 40) ^ endian::read64le(Secret + 48);
+  uint64_t InputLo = endian::read64le(Input) ^ Bitflip1;
+  uint64_t InputHi = endian::read64le(Input + Len - 8) ^ Bitflip2;
+  uint64_t Acc = Len + ByteSwap_64(InputLo) + InputHi +
+                 mul128Fold64(InputLo, InputHi);
+  return XXH3_avalanche(Acc);
+}
+
+static uint64_t XXH3_len_0to16_64b(const uint8_t *Input, size_t Len) {
+  if (LLVM_LIKELY(Len > 8))
+    return XXH3_len_9to16_64b(Input, Len);
+  if (LLVM_LIKELY(Len >= 4))
+    return XXH3_len_4to8_64b(Input, Len);
+  if (Len)
+    return XXH3_len_1to3_64b(Input, Len);
+  return XXH64_avalanche(endian::read64le(Secret + 56) ^
+                         endian::read64le(Secret + 64));
+}
+
+static uint64_t XXH3_len_17to128_64b(const uint8_t *Input, size_t Len) {
+  uint64_t Acc = Len * PRIME64_1;
+  if (Len > 32) {
+    if (Len > 64) {
+      if (Len > 96) {
+        Acc += mix16B(Input + 48, Secret + 96, 0);
+        Acc += mix16B(Input + Len - 64, Secret + 112, 0);
+      }
+      Acc += mix16B(Input + 32, Secret + 64, 0);
+      Acc += mix16B(Input + Len - 48, Secret + 80, 0);
+    }
+    Acc += mix16B(Input + 16, Secret + 32, 0);
+    Acc += mix16B(Input + Len - 32, Secret + 48, 0);
+  }
+  Acc += mix16B(Input + 0, Secret + 0, 0);
+  Acc += mix16B(Input + Len - 16, Secret + 16, 0);
+  return XXH3_avalanche(Acc);
+}
+
+LLVM_ATTRIBUTE_NOINLINE
+static uint64_t XXH3_len_129to240_64b(const uint8_t *Input, size_t Len) {
+  uint64_t Acc = Len * PRIME64_1;
+  size_t NumRounds = Len / 16;
+  for (size_t I = 0; I < 8; ++I)
+    Acc += mix16B(Input + 16 * I, Secret + 16 * I, 0);
+  Acc = XXH3_avalanche(Acc);
+
+  for (size_t I = 8; I < NumRounds; ++I)
+    Acc += mix16B(Input + 16 * I, Secret + 16 * (I - 8) + MidSizeStartOffset, 0);
+  // Last 16 bytes.
+  Acc += mix16B(Input + Len - 16, Secret + SecretSizeMin - MidSizeLastOffset, 0);
+  return XXH3_avalanche(Acc);
+}
+
+uint64_t llvm::xxh3_64bits(ArrayRef<uint8_t> Data) {
+  size_t Len = Data.size();
+  const uint8_t *Input = Data.data();
+  if (Len <= 16)
+    return XXH3_len_0to16_64b(Input, Len);
+  if (Len <= 128)
+    return XXH3_len_17to128_64b(Input, Len);
+  if (Len <= 240)
+    return XXH3_len_129to240_64b(Input, Len);
+  return XXH3_hashLong_64b(Input, Len);
+}
+
+static XXH128_hash_t XXH3_len_1to3_128b(const uint8_t *Input, size_t Len) {
+  uint8_t C1 = Input[0];
+  uint8_t C2 = Input[Len >> 1];
+  uint8_t C3 = Input[Len - 1];
+  uint32_t CombinedLo = (uint32_t(C1) << 16) | (uint32_t(C2) << 24) |
+                        (uint32_t(C3) << 0) | (uint32_t(Len) << 8);
+  uint32_t CombinedHi = rotl32(ByteSwap_32(CombinedLo), 13);
+  uint64_t BitflipLo =
+      uint64_t(endian::read32le(Secret) ^ endian::read32le(Secret + 4));
+  uint64_t BitflipHi =
+      uint64_t(endian::read32le(Secret + 8) ^ endian::read32le(Secret + 12));
+  return {XXH64_avalanche(uint64_t(CombinedLo) ^ BitflipLo),
+          XXH64_avalanche(uint64_t(CombinedHi) ^ BitflipHi)};
+}
+
+static XXH128_hash_t XXH3_len_4to8_128b(const uint8_t *Input, size_t Len) {
+  uint32_t InputLo = endian::read32le(Input);
+  uint32_t InputHi = endian::read32le(Input + Len - 4);
+  uint64_t Input64 = InputLo + (uint64_t(InputHi) << 32);
+  uint64_t Bitflip =
+      endian::read64le(Secret + 16) ^ endian::read64le(Secret + 24);
+  uint64_t Keyed = Input64 ^ Bitflip;
+
+  // Shift len to the left to ensure it is even, this avoids even multiplies.
+  XXH128_hash_t M128 = mult64to128(Keyed, PRIME64_1 + (Len << 2));
+  M128.high64 += (M128.low64 << 1);
+  M128.low64 ^= (M128.high64 >> 3);
+  M128.low64 ^= M128.low64 >> 35;
+  M128.low64 *= PRIME_MX2;
+  M128.low64 ^= M128.low64 >> 28;
+  M128.high64 = XXH3_avalanche(M128.high64);
+  return M128;
+}
+
+static XXH128_hash_t XXH3_len_9to16_128b(const uint8_t *Input, size_t Len) {
+  uint64_t BitflipLo =
+      endian::read64le(Secret + 32) ^ endian::read64le(Secret + 40);
+  uint64_t BitflipHi =
+      endian::read64le(Secret + 48) ^ endian::read64le(Secret + 56);
+  uint64_t InputLo = endian::read64le(Input);
+  uint64_t InputHi = endian::read64le(Input + Len - 8);
+  XXH128_hash_t M128 = mult64to128(InputLo ^ InputHi ^ BitflipLo, PRIME64_1);
+  M128.low64 += uint64_t(Len - 1) << 54;
+  InputHi ^= BitflipHi;
+  M128.high64 += InputHi + uint64_t(uint32_t(InputHi)) * (PRIME32_2 - 1);
+  M128.low64 ^= ByteSwap_64(M128.high64);
+
+  XXH128_hash_t H128 = mult64to128(M128.low64, PRIME64_2);
+  H128.high64 += M128.high64 * PRIME64_2;
+  H128.low64 = XXH3_avalanche(H128.low64);
+  H128.high64 = XXH3_avalanche(H128.high64);
+  return H128;
+}
+
+static XXH128_hash_t XXH3_len_0to16_128b(const uint8_t *Input, size_t Len) {
+  if (Len > 8)
+    return XXH3_len_9to16_128b(Input, Len);
+  if (Len >= 4)
+    return XXH3_len_4to8_128b(Input, Len);
+  if (Len)
+    return XXH3_len_1to3_128b(Input, Len);
+  uint64_t BitflipLo =
+      endian::read64le(Secret + 64) ^ endian::read64le(Secret + 72);
+  uint64_t BitflipHi =
+      endian::read64le(Secret + 80) ^ endian::read64le(Secret + 88);
+  return {XXH64_avalanche(BitflipLo), XXH64_avalanche(BitflipHi)};
+}
+
+// Combines the two halves of the accumulator of the 17 to 240 bytes hashes.
+static XXH128_hash_t finalizeMidSize128(XXH128_hash_t Acc, size_t Len) {
+  XXH128_hash_t H128;
+  H128.low64 = Acc.low64 + Acc.high64;
+  H128.high64 = (Acc.low64 * PRIME64_1) + (Acc.high64 * PRIME64_4) +
+                (uint64_t(Len) * PRIME64_2);
+  H128.low64 = XXH3_avalanche(H128.low64);
+  H128.high64 = 0 - XXH3_avalanche(H128.high64);
+  return H128;
+}
+
+static XXH128_hash_t XXH3_len_17to128_128b(const uint8_t *Input, size_t Len) {
+  XXH128_hash_t Acc = {Len * PRIME64_1, 0};
+  if (Len > 32) {
+    if (Len > 64) {
+      if (Len > 96)
+        Acc = mix32B(Acc, Input + 48, Input + Len - 64, Secret + 96, 0);
+      Acc = mix32B(Acc, Input + 32, Input + Len - 48, Secret + 64, 0);
+    }
+    Acc = mix32B(Acc, Input + 16, Input + Len - 32, Secret + 32, 0);
+  }
+  Acc = mix32B(Acc, Input, Input + Len - 16, Secret, 0);
+  return finalizeMidSize128(Acc, Len);
+}
+
+LLVM_ATTRIBUTE_NOINLINE
+static XXH128_hash_t XXH3_len_129to240_128b(const uint8_t *Input, size_t Len) {
+  XXH128_hash_t Acc = {Len * PRIME64_1, 0};
+  size_t I;
+  for (I = 32; I < 160; I += 32)
+    Acc = mix32B(Acc, Input + I - 32, Input + I - 16, Secret + I - 32, 0);
+  Acc.low64 = XXH3_avalanche(Acc.low64);
+  Acc.high64 = XXH3_avalanche(Acc.high64);
+
+  for (I = 160; I <= Len; I += 32)
+    Acc = mix32B(Acc, Input + I - 32, Input + I - 16,
+                 Secret + MidSizeStartOffset + I - 160, 0);
+  // Last bytes.
+  Acc = mix32B(Acc, Input + Len - 16, Input + Len - 32,
+               Secret + SecretSizeMin - MidSizeLastOffset - 16, 0);
+  return finalizeMidSize128(Acc, Len);
+}
+
+LLVM_ATTRIBUTE_NOINLINE
+static XXH128_hash_t XXH3_hashLong_128b(const uint8_t *Input, size_t Len) {
+  alignas(16) uint64_t Acc[8] = XXH3_INIT_ACC;
+  hashLongInternalLoop(Acc, Input, Len);
+  return {mergeAccs(Acc, Secret + SecretMergeAccsStart,
+                    uint64_t(Len) * PRIME64_1),
+          mergeAccs(Acc, Secret + SecretSize - StripeLen - SecretMergeAccsStart,
+                    ~(uint64_t(Len) * PRIME64_2))};
+}
+
+XXH128_hash_t llvm::xxh3_128bits(ArrayRef<uint8_t> Data) {
+  size_t Len = Data.size();
+  const uint8_t *Input = Data.data();
+  if (Len <= 16)
+    return XXH3_len_0to16_128b(Input, Len);
+  if (Len <= 128)
+    return XXH3_len_17to128_128b(Input, Len);
+  if (Len <= 240)
+    return XXH3_len_129to240_128b(Input, Len);
+  return XXH3_hashLong_128b(Input, Len);
+}
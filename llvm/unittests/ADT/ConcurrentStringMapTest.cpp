@@ -0,0 +1,98 @@
+//===- llvm/unittest/ADT/ConcurrentStringMapTest.cpp ----------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/ConcurrentStringMap.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/ThreadPool.h"
+#include "gtest/gtest.h"
+#include <atomic>
+
+using namespace llvm;
+
+namespace {
+
+TEST(ConcurrentStringMapTest, Basic) {
+  ConcurrentStringMap<int> Map;
+  EXPECT_TRUE(Map.empty());
+  EXPECT_EQ(nullptr, Map.find("a"));
+
+  auto Result = Map.try_emplace("a", 1);
+  EXPECT_TRUE(Result.second);
+  EXPECT_EQ("a", Result.first->getKey());
+  EXPECT_EQ(1, Result.first->getValue());
+
+  auto Again = Map.try_emplace("a", 2);
+  EXPECT_FALSE(Again.second);
+  EXPECT_EQ(Result.first, Again.first);
+  EXPECT_EQ(1, Again.first->getValue());
+
+  EXPECT_EQ(Result.first, Map.find("a"));
+  EXPECT_EQ(Result.first, Map.find("a", StringMapImpl::hash("a")));
+  EXPECT_TRUE(Map.contains("a"));
+  EXPECT_FALSE(Map.contains("b"));
+  EXPECT_EQ(1u, Map.size());
+}
+
+TEST(ConcurrentStringMapTest, NumShards) {
+  EXPECT_EQ(1u, ConcurrentStringMap<int>(0).getNumShards());
+  EXPECT_EQ(1u, ConcurrentStringMap<int>(1).getNumShards());
+  EXPECT_EQ(8u, ConcurrentStringMap<int>(5).getNumShards());
+
+  // A single shard works as a plain StringMap.
+  ConcurrentStringMap<int> Map(1);
+  for (int I = 0; I < 100; ++I)
+    EXPECT_TRUE(Map.try_emplace(Twine(I).str(), I).second);
+  EXPECT_EQ(100u, Map.size());
+  for (int I = 0; I < 100; ++I)
+    EXPECT_EQ(I, Map.find(Twine(I).str())->getValue());
+}
+
+TEST(ConcurrentStringMapTest, EntriesAreStable) {
+  ConcurrentStringMap<int, BumpPtrAllocator> Map(4);
+  auto *First = Map.try_emplace("first", 1).first;
+  for (int I = 0; I < 1000; ++I)
+    Map.try_emplace(Twine(I).str(), I);
+  EXPECT_EQ(First, Map.find("first"));
+
+  int Sum = 0;
+  unsigned Count = 0;
+  Map.forEach([&](StringMapEntry<int> &Entry) {
+    Sum += Entry.getValue();
+    ++Count;
+  });
+  EXPECT_EQ(1001u, Count);
+  EXPECT_EQ(1 + 999 * 1000 / 2, Sum);
+}
+
+TEST(ConcurrentStringMapTest, ConcurrentInsert) {
+  constexpr int NumTasks = 8;
+  constexpr int NumKeys = 1000;
+  ConcurrentStringMap<int> Map(16);
+  std::atomic<int> Inserted(0);
+
+  // Every task inserts the same keys, only one of them inserts each key.
+  ThreadPool Pool;
+  for (int T = 0; T < NumTasks; ++T)
+    Pool.async([&] {
+      for (int I = 0; I < NumKeys; ++I) {
+        auto Result = Map.try_emplace(Twine(I).str(), I);
+        if (Result.second)
+          ++Inserted;
+        EXPECT_EQ(I, Result.first->getValue());
+      }
+    });
+  Pool.wait();
+
+  EXPECT_EQ(NumKeys, Inserted);
+  EXPECT_EQ(static_cast<size_t>(NumKeys), Map.size());
+  for (int I = 0; I < NumKeys; ++I)
+    EXPECT_EQ(I, Map.find(Twine(I).str())->getValue());
+}
+
+} // end anonymous namespace
@@ -164,4 +164,33 @@ TEST_F(ImmutableSetTest, IterLongSetTest) {
   ASSERT_EQ(6, i);
 }
 
+TEST_F(ImmutableSetTest, EqualityTest) {
+  ImmutableSet<int>::Factory f;
+  ImmutableSet<int> S = f.getEmptySet();
+
+  // Same contents added in different orders give differently shaped trees
+  // before canonicalization.
+  ImmutableSet<int> S1 = f.add(f.add(f.add(f.add(S, 1), 2), 3), 4);
+  ImmutableSet<int> S2 = f.add(f.add(f.add(f.add(S, 4), 3), 2), 1);
+  ImmutableSet<int> S3 = f.add(f.add(f.add(f.add(S, 1), 2), 3), 5);
+  EXPECT_TRUE(S1 == S2);
+  EXPECT_FALSE(S1 == S3);
+  EXPECT_TRUE(S1 != S3);
+
+  // Without canonicalization equal sets are distinct trees and have to be
+  // compared element by element.
+  ImmutableSet<int>::Factory NoCanon(/*canonicalize=*/false);
+  ImmutableSet<int> N = NoCanon.getEmptySet();
+  ImmutableSet<int> N1 =
+      NoCanon.add(NoCanon.add(NoCanon.add(NoCanon.add(N, 1), 2), 3), 4);
+  ImmutableSet<int> N2 =
+      NoCanon.add(NoCanon.add(NoCanon.add(NoCanon.add(N, 4), 3), 2), 1);
+  ImmutableSet<int> N3 =
+      NoCanon.add(NoCanon.add(NoCanon.add(NoCanon.add(N, 1), 2), 3), 5);
+  EXPECT_TRUE(N1 == N2);
+  EXPECT_FALSE(N1 == N3);
+  EXPECT_TRUE(N1 == S1);
+  EXPECT_FALSE(N3 == S1);
+}
+
 }
@@ -527,6 +527,34 @@ TEST_F(StringMapTest, StructuredBindings) {
   }
 }
 
+TEST_F(StringMapTest, PrecomputedHash) {
+  StringMap<int> A;
+  uint32_t Hash = StringMapImpl::hash("key");
+  EXPECT_EQ(A.end(), A.find("key", Hash));
+  EXPECT_EQ(0u, A.count("key", Hash));
+
+  auto Result = A.try_emplace_with_hash("key", Hash, 42);
+  EXPECT_TRUE(Result.second);
+  EXPECT_EQ(42, Result.first->second);
+  Result = A.try_emplace_with_hash("key", Hash, 43);
+  EXPECT_FALSE(Result.second);
+  EXPECT_EQ(42, Result.first->second);
+
+  // Both kinds of lookup find the same entry.
+  EXPECT_EQ(A.find("key"), A.find("key", Hash));
+  EXPECT_EQ(1u, A.count("key", Hash));
+  EXPECT_EQ(42, A.lookup("key"));
+
+  // The hash stays valid when the table grows.
+  for (int I = 0; I < 100; ++I)
+    A.try_emplace_with_hash(Twine(I).str(), StringMapImpl::hash(Twine(I).str()),
+                            I);
+  EXPECT_EQ(101u, A.size());
+  EXPECT_EQ(42, A.find("key", Hash)->second);
+  for (int I = 0; I < 100; ++I)
+    EXPECT_EQ(I, A.lookup(Twine(I).str()));
+}
+
 namespace {
 // Simple class that counts how many moves and copy happens when growing a map
 struct CountCtorCopyAndMove {
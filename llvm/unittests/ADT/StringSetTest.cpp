@@ -73,4 +73,14 @@ TEST_F(StringSetTest, Contains) {
   EXPECT_FALSE(Set.contains("test"));
 }
 
+TEST_F(StringSetTest, ContainsPrecomputedHash) {
+  StringSet<> Set;
+  uint32_t Hash = StringMapImpl::hash("test");
+  EXPECT_FALSE(Set.contains("test", Hash));
+
+  Set.try_emplace_with_hash("test", Hash);
+  EXPECT_TRUE(Set.contains("test", Hash));
+  EXPECT_TRUE(Set.contains("test"));
+}
+
 } // end anonymous namespace
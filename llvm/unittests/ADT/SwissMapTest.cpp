@@ -0,0 +1,496 @@
+//===- llvm/unittest/ADT/SwissMapTest.cpp - SwissMap unit tests -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SwissMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "gtest/gtest.h"
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+
+using namespace llvm;
+
+namespace {
+
+uint32_t getTestKey(int i, uint32_t *) { return i; }
+uint32_t getTestValue(int i, uint32_t *) { return 42 + i; }
+
+uint32_t *getTestKey(int i, uint32_t **) {
+  static uint32_t dummy_arr1[8192];
+  assert(i < 8192 && "Only support 8192 dummy keys.");
+  return &dummy_arr1[i];
+}
+uint32_t *getTestValue(int i, uint32_t **) {
+  static uint32_t dummy_arr1[8192];
+  assert(i < 8192 && "Only support 8192 dummy keys.");
+  return &dummy_arr1[i];
+}
+
+/// A test class that tries to check that construction and destruction
+/// occur correctly.
+class CtorTester {
+  static std::set<CtorTester *> Constructed;
+  int Value;
+
+public:
+  explicit CtorTester(int Value = 0) : Value(Value) {
+    EXPECT_TRUE(Constructed.insert(this).second);
+  }
+  CtorTester(const CtorTester &Arg) : Value(Arg.Value) {
+    EXPECT_TRUE(Constructed.insert(this).second);
+  }
+  CtorTester &operator=(const CtorTester &) = default;
+  ~CtorTester() { EXPECT_EQ(1u, Constructed.erase(this)); }
+
+  int getValue() const { return Value; }
+  bool operator==(const CtorTester &RHS) const { return Value == RHS.Value; }
+  bool operator!=(const CtorTester &RHS) const { return Value != RHS.Value; }
+  bool operator<(const CtorTester &RHS) const { return Value < RHS.Value; }
+
+  static size_t getNumConstructed() { return Constructed.size(); }
+};
+
+std::set<CtorTester *> CtorTester::Constructed;
+
+// SwissMap only needs getHashValue and isEqual.
+struct CtorTesterMapInfo {
+  static unsigned getHashValue(const CtorTester &Val) {
+    return Val.getValue() * 37u;
+  }
+  static bool isEqual(const CtorTester &LHS, const CtorTester &RHS) {
+    return LHS == RHS;
+  }
+};
+
+CtorTester getTestKey(int i, CtorTester *) { return CtorTester(i); }
+CtorTester getTestValue(int i, CtorTester *) { return CtorTester(42 + i); }
+
+// Test fixture, with helper functions implemented by forwarding to global
+// function overloads selected by component types of the type parameter.
+template <typename T> class SwissMapTest : public testing::Test {
+protected:
+  T Map;
+
+  static typename T::key_type *const dummy_key_ptr;
+  static typename T::mapped_type *const dummy_value_ptr;
+
+  typename T::key_type getKey(int i = 0) {
+    return getTestKey(i, dummy_key_ptr);
+  }
+  typename T::mapped_type getValue(int i = 0) {
+    return getTestValue(i, dummy_value_ptr);
+  }
+};
+
+template <typename T>
+typename T::key_type *const SwissMapTest<T>::dummy_key_ptr = nullptr;
+template <typename T>
+typename T::mapped_type *const SwissMapTest<T>::dummy_value_ptr = nullptr;
+
+// Register these types for testing.
+typedef ::testing::Types<SwissMap<uint32_t, uint32_t>,
+                         SwissMap<uint32_t *, uint32_t *>,
+                         SwissMap<CtorTester, CtorTester, CtorTesterMapInfo>>
+    SwissMapTestTypes;
+TYPED_TEST_SUITE(SwissMapTest, SwissMapTestTypes, );
+
+// Empty map tests
+TYPED_TEST(SwissMapTest, EmptyMapTest) {
+  const TypeParam &ConstMap = this->Map;
+  EXPECT_EQ(0u, this->Map.size());
+  EXPECT_TRUE(this->Map.empty());
+  EXPECT_TRUE(this->Map.begin() == this->Map.end());
+  EXPECT_TRUE(ConstMap.begin() == ConstMap.end());
+  EXPECT_FALSE(this->Map.count(this->getKey()));
+  EXPECT_TRUE(this->Map.find(this->getKey()) == this->Map.end());
+  EXPECT_EQ(typename TypeParam::mapped_type(),
+            this->Map.lookup(this->getKey()));
+  EXPECT_FALSE(this->Map.erase(this->getKey()));
+}
+
+// A map with a single entry
+TYPED_TEST(SwissMapTest, SingleEntryMapTest) {
+  this->Map[this->getKey()] = this->getValue();
+
+  EXPECT_EQ(1u, this->Map.size());
+  EXPECT_FALSE(this->Map.begin() == this->Map.end());
+  EXPECT_FALSE(this->Map.empty());
+
+  typename TypeParam::iterator it = this->Map.begin();
+  EXPECT_EQ(this->getKey(), it->first);
+  EXPECT_EQ(this->getValue(), it->second);
+  ++it;
+  EXPECT_TRUE(it == this->Map.end());
+
+  EXPECT_TRUE(this->Map.count(this->getKey()));
+  EXPECT_TRUE(this->Map.find(this->getKey()) == this->Map.begin());
+  EXPECT_EQ(this->getValue(), this->Map.lookup(this->getKey()));
+  EXPECT_EQ(this->getValue(), this->Map[this->getKey()]);
+}
+
+TYPED_TEST(SwissMapTest, ClearTest) {
+  for (int I = 0; I < 100; ++I)
+    this->Map[this->getKey(I)] = this->getValue(I);
+  this->Map.clear();
+
+  EXPECT_EQ(0u, this->Map.size());
+  EXPECT_TRUE(this->Map.empty());
+  EXPECT_TRUE(this->Map.begin() == this->Map.end());
+  EXPECT_FALSE(this->Map.count(this->getKey(3)));
+}
+
+TYPED_TEST(SwissMapTest, ShrinkAndClearTest) {
+  // The table is sized for the entries left when it is cleared.
+  for (int I = 0; I < 1000; ++I)
+    this->Map[this->getKey(I)] = this->getValue(I);
+  for (int I = 10; I < 1000; ++I)
+    this->Map.erase(this->getKey(I));
+  size_t LargeSize = this->Map.getMemorySize();
+  this->Map.shrink_and_clear();
+
+  EXPECT_EQ(0u, this->Map.size());
+  EXPECT_TRUE(this->Map.begin() == this->Map.end());
+  EXPECT_FALSE(this->Map.count(this->getKey(3)));
+  EXPECT_LT(this->Map.getMemorySize(), LargeSize);
+
+  this->Map[this->getKey(3)] = this->getValue(3);
+  EXPECT_EQ(this->getValue(3), this->Map.lookup(this->getKey(3)));
+  this->Map.shrink_and_clear();
+  this->Map.shrink_and_clear();
+  EXPECT_EQ(0u, this->Map.getMemorySize());
+}
+
+TYPED_TEST(SwissMapTest, EraseTest) {
+  this->Map[this->getKey()] = this->getValue();
+  EXPECT_TRUE(this->Map.erase(this->getKey()));
+  EXPECT_FALSE(this->Map.erase(this->getKey()));
+
+  EXPECT_EQ(0u, this->Map.size());
+  EXPECT_TRUE(this->Map.empty());
+  EXPECT_TRUE(this->Map.begin() == this->Map.end());
+
+  this->Map[this->getKey(1)] = this->getValue(1);
+  this->Map.erase(this->Map.find(this->getKey(1)));
+  EXPECT_TRUE(this->Map.empty());
+}
+
+TYPED_TEST(SwissMapTest, InsertTest) {
+  auto Inserted = this->Map.insert(
+      std::make_pair(this->getKey(), this->getValue()));
+  EXPECT_TRUE(Inserted.second);
+  EXPECT_EQ(this->getValue(), Inserted.first->second);
+  Inserted = this->Map.insert(
+      std::make_pair(this->getKey(), this->getValue(1)));
+  EXPECT_FALSE(Inserted.second);
+  EXPECT_EQ(1u, this->Map.size());
+  EXPECT_EQ(this->getValue(), this->Map[this->getKey()]);
+}
+
+// Enough entries to fill many groups and grow several times.
+TYPED_TEST(SwissMapTest, GrowTest) {
+  for (int I = 0; I < 1000; ++I)
+    this->Map[this->getKey(I)] = this->getValue(I);
+  EXPECT_EQ(1000u, this->Map.size());
+  for (int I = 0; I < 1000; ++I)
+    EXPECT_EQ(this->getValue(I), this->Map.lookup(this->getKey(I)));
+  EXPECT_FALSE(this->Map.count(this->getKey(1000)));
+}
+
+TYPED_TEST(SwissMapTest, CopyConstructorTest) {
+  for (int I = 0; I < 100; ++I)
+    this->Map[this->getKey(I)] = this->getValue(I);
+  TypeParam copyMap(this->Map);
+
+  EXPECT_EQ(100u, copyMap.size());
+  for (int I = 0; I < 100; ++I)
+    EXPECT_EQ(this->getValue(I), copyMap[this->getKey(I)]);
+}
+
+TYPED_TEST(SwissMapTest, CopyConstructorFromEmptyTest) {
+  TypeParam copyMap(this->Map);
+  EXPECT_TRUE(copyMap.empty());
+}
+
+TYPED_TEST(SwissMapTest, AssignmentTest) {
+  for (int I = 0; I < 100; ++I)
+    this->Map[this->getKey(I)] = this->getValue(I);
+  TypeParam copyMap;
+  copyMap[this->getKey(200)] = this->getValue(200);
+  copyMap = this->Map;
+
+  EXPECT_EQ(100u, copyMap.size());
+  for (int I = 0; I < 100; ++I)
+    EXPECT_EQ(this->getValue(I), copyMap[this->getKey(I)]);
+  EXPECT_FALSE(copyMap.count(this->getKey(200)));
+
+  // test self-assignment.
+  copyMap = static_cast<TypeParam &>(copyMap);
+  EXPECT_EQ(100u, copyMap.size());
+}
+
+TYPED_TEST(SwissMapTest, MoveTest) {
+  for (int I = 0; I < 100; ++I)
+    this->Map[this->getKey(I)] = this->getValue(I);
+  TypeParam movedMap(std::move(this->Map));
+  EXPECT_EQ(100u, movedMap.size());
+  EXPECT_TRUE(this->Map.empty());
+
+  TypeParam otherMap;
+  otherMap[this->getKey(200)] = this->getValue(200);
+  otherMap = std::move(movedMap);
+  EXPECT_EQ(100u, otherMap.size());
+  EXPECT_EQ(this->getValue(5), otherMap.lookup(this->getKey(5)));
+  EXPECT_FALSE(otherMap.count(this->getKey(200)));
+}
+
+TYPED_TEST(SwissMapTest, SwapTest) {
+  this->Map[this->getKey()] = this->getValue();
+  TypeParam otherMap;
+
+  this->Map.swap(otherMap);
+  EXPECT_EQ(0u, this->Map.size());
+  EXPECT_TRUE(this->Map.empty());
+  EXPECT_EQ(1u, otherMap.size());
+  EXPECT_EQ(this->getValue(), otherMap[this->getKey()]);
+
+  this->Map.swap(otherMap);
+  EXPECT_EQ(0u, otherMap.size());
+  EXPECT_TRUE(otherMap.empty());
+  EXPECT_EQ(1u, this->Map.size());
+  EXPECT_EQ(this->getValue(), this->Map[this->getKey()]);
+}
+
+// A more complex iteration test
+TYPED_TEST(SwissMapTest, IterationTest) {
+  bool visited[100];
+  std::map<typename TypeParam::key_type, unsigned> visitedIndex;
+
+  // Insert 100 numbers into the map
+  for (int i = 0; i < 100; ++i) {
+    visited[i] = false;
+    visitedIndex[this->getKey(i)] = i;
+
+    this->Map[this->getKey(i)] = this->getValue(i);
+  }
+
+  // Iterate over all numbers and mark each one found.
+  for (typename TypeParam::iterator it = this->Map.begin();
+       it != this->Map.end(); ++it)
+    visited[visitedIndex[it->first]] = true;
+
+  // Ensure every number was visited.
+  for (int i = 0; i < 100; ++i)
+    ASSERT_TRUE(visited[i]) << "Entry #" << i << " was never visited";
+}
+
+// const_iterator test
+TYPED_TEST(SwissMapTest, ConstIteratorTest) {
+  // Check conversion from iterator to const_iterator.
+  typename TypeParam::iterator it = this->Map.begin();
+  typename TypeParam::const_iterator cit(it);
+  EXPECT_TRUE(it == cit);
+
+  // Check copying of const_iterators.
+  typename TypeParam::const_iterator cit2(cit);
+  EXPECT_TRUE(cit == cit2);
+}
+
+// Erasing and inserting different keys must reuse the deleted slots instead
+// of growing the table without bounds. The table may double once, as it only
+// drops deleted slots in place when at most 7/16 of it is in use.
+TYPED_TEST(SwissMapTest, EraseReinsertTest) {
+  for (int I = 0; I < 100; ++I)
+    this->Map[this->getKey(I)] = this->getValue(I);
+  size_t MemorySize = this->Map.getMemorySize();
+  for (int I = 100; I < 5000; ++I) {
+    EXPECT_TRUE(this->Map.erase(this->getKey(I - 100)));
+    this->Map[this->getKey(I)] = this->getValue(I);
+  }
+  EXPECT_EQ(100u, this->Map.size());
+  EXPECT_LE(this->Map.getMemorySize(), 2 * MemorySize);
+  for (int I = 4900; I < 5000; ++I)
+    EXPECT_EQ(this->getValue(I), this->Map.lookup(this->getKey(I)));
+  EXPECT_FALSE(this->Map.count(this->getKey(4899)));
+}
+
+TEST(SwissMapCustomTest, InitializerList) {
+  SwissMap<int, int> M({{0, 1}, {1, 2}});
+  EXPECT_EQ(2u, M.size());
+  EXPECT_EQ(1, M.lookup(0));
+  EXPECT_EQ(2, M.lookup(1));
+}
+
+TEST(SwissMapCustomTest, EqualityComparison) {
+  SwissMap<int, int> M1({{0, 0}, {1, 1}});
+  SwissMap<int, int> M2({{0, 0}, {1, 1}});
+  SwissMap<int, int> M3({{0, 0}, {1, 2}});
+
+  EXPECT_EQ(M1, M2);
+  EXPECT_NE(M1, M3);
+}
+
+TEST(SwissMapCustomTest, ReserveTest) {
+  for (unsigned Size : {1, 14, 15, 100, 1000}) {
+    SwissMap<unsigned, unsigned> Map(Size);
+    size_t MemorySize = Map.getMemorySize();
+    for (unsigned I = 0; I < Size; ++I)
+      Map[I] = I;
+    EXPECT_EQ(MemorySize, Map.getMemorySize()) << "Size " << Size;
+
+    SwissMap<unsigned, unsigned> Reserved;
+    Reserved.reserve(Size);
+    EXPECT_EQ(MemorySize, Reserved.getMemorySize()) << "Size " << Size;
+  }
+}
+
+TEST(SwissMapCustomTest, GrowAndBucketsArrayTest) {
+  SwissMap<int, int> Map;
+  EXPECT_FALSE(Map.isPointerIntoBucketsArray(&Map));
+  Map[1] = 1;
+  EXPECT_TRUE(Map.isPointerIntoBucketsArray(&Map.find(1)->second));
+  EXPECT_FALSE(Map.isPointerIntoBucketsArray(&Map));
+
+  // Growing moves the entries to a new table, reserving for the entries that
+  // already fit does not.
+  const void *Buckets = Map.getPointerIntoBucketsArray();
+  Map.reserve(1);
+  EXPECT_EQ(Buckets, Map.getPointerIntoBucketsArray());
+  Map.grow(1000);
+  EXPECT_NE(Buckets, Map.getPointerIntoBucketsArray());
+  EXPECT_GE(Map.getMemorySize(), 1024 * sizeof(std::pair<int, int>));
+  EXPECT_EQ(1, Map.lookup(1));
+
+  // Entries that don't fit the requested size are kept.
+  for (int I = 0; I < 100; ++I)
+    Map[I] = I;
+  Map.grow(1);
+  EXPECT_EQ(100u, Map.size());
+  for (int I = 0; I < 100; ++I)
+    EXPECT_EQ(I, Map.lookup(I));
+}
+
+TEST(SwissMapCustomTest, StringRefTest) {
+  SwissMap<StringRef, int> M;
+
+  M["a"] = 1;
+  M["b"] = 2;
+  M["c"] = 3;
+  M[""] = 42;
+
+  EXPECT_EQ(4u, M.size());
+  EXPECT_EQ(1, M.lookup("a"));
+  EXPECT_EQ(2, M.lookup("b"));
+  EXPECT_EQ(3, M.lookup("c"));
+  EXPECT_EQ(0, M.lookup("q"));
+  EXPECT_EQ(42, M.lookup(""));
+}
+
+// Key traits that allows lookup with either an unsigned or char* key;
+// In the latter case, "a" == 0, "b" == 1 and so on.
+struct TestSwissMapInfo {
+  static unsigned getHashValue(const unsigned &Val) { return Val * 37U; }
+  static unsigned getHashValue(const char *Val) {
+    return (unsigned)(Val[0] - 'a') * 37U;
+  }
+  static bool isEqual(const unsigned &LHS, const unsigned &RHS) {
+    return LHS == RHS;
+  }
+  static bool isEqual(const char *LHS, const unsigned &RHS) {
+    return (unsigned)(LHS[0] - 'a') == RHS;
+  }
+};
+
+TEST(SwissMapCustomTest, FindAsTest) {
+  SwissMap<unsigned, unsigned, TestSwissMapInfo> Map;
+  Map[0] = 1;
+  Map[1] = 2;
+  Map[2] = 3;
+
+  EXPECT_EQ(3u, Map.size());
+  EXPECT_EQ(1u, Map.find_as("a")->second);
+  EXPECT_EQ(2u, Map.find_as("b")->second);
+  EXPECT_EQ(3u, Map.find_as("c")->second);
+  EXPECT_TRUE(Map.find_as("d") == Map.end());
+
+  EXPECT_TRUE(Map.insert_as({3, 4}, "d").second);
+  EXPECT_FALSE(Map.insert_as({3, 5}, "d").second);
+  EXPECT_EQ(4u, Map.lookup(3));
+}
+
+TEST(SwissMapCustomTest, TryEmplaceTest) {
+  SwissMap<int, std::unique_ptr<int>> Map;
+  std::unique_ptr<int> P(new int(2));
+  auto Try1 = Map.try_emplace(0, new int(1));
+  EXPECT_TRUE(Try1.second);
+  auto Try2 = Map.try_emplace(0, std::move(P));
+  EXPECT_FALSE(Try2.second);
+  EXPECT_EQ(Try1.first, Try2.first);
+  EXPECT_NE(nullptr, P);
+  EXPECT_EQ(1, *Map[0]);
+}
+
+TEST(SwissMapCustomTest, NoLeakTest) {
+  {
+    SwissMap<CtorTester, CtorTester, CtorTesterMapInfo> Map;
+    for (int I = 0; I < 200; ++I)
+      Map.try_emplace(CtorTester(I), I);
+    for (int I = 0; I < 200; I += 2)
+      Map.erase(CtorTester(I));
+    EXPECT_EQ(200u, CtorTester::getNumConstructed());
+    Map.clear();
+    EXPECT_EQ(0u, CtorTester::getNumConstructed());
+    for (int I = 0; I < 50; ++I)
+      Map.try_emplace(CtorTester(I), I);
+  }
+  EXPECT_EQ(0u, CtorTester::getNumConstructed());
+}
+
+// Keys whose hashes collide must still be found, even after some of them are
+// erased.
+TEST(SwissMapCustomTest, CollidingHashesTest) {
+  struct CollidingInfo {
+    static unsigned getHashValue(const int &) { return 7; }
+    static bool isEqual(const int &LHS, const int &RHS) { return LHS == RHS; }
+  };
+  SwissMap<int, int, CollidingInfo> Map;
+  for (int I = 0; I < 100; ++I)
+    Map[I] = I;
+  for (int I = 0; I < 100; I += 3)
+    Map.erase(I);
+  for (int I = 0; I < 100; ++I)
+    EXPECT_EQ(I % 3 != 0, Map.count(I) == 1);
+}
+
+// Compare a series of random operations with std::map.
+TEST(SwissMapCustomTest, RandomOperationsTest) {
+  std::mt19937 Rng(42);
+  SwissMap<unsigned, unsigned> Map;
+  std::map<unsigned, unsigned> Ref;
+  for (unsigned I = 0; I < 20000; ++I) {
+    unsigned Key = Rng() % 2000;
+    switch (Rng() % 3) {
+    case 0:
+      Map[Key] = I;
+      Ref[Key] = I;
+      break;
+    case 1:
+      EXPECT_EQ(Ref.erase(Key) == 1, Map.erase(Key));
+      break;
+    case 2:
+      EXPECT_EQ(Ref.count(Key), Map.count(Key));
+      break;
+    }
+  }
+  EXPECT_EQ(Ref.size(), Map.size());
+  std::map<unsigned, unsigned> Contents(Map.begin(), Map.end());
+  EXPECT_EQ(Ref, Contents);
+}
+
+} // namespace
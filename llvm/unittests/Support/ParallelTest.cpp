@@ -12,8 +12,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Parallel.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/xxhash.h"
 #include "gtest/gtest.h"
 #include <array>
+#include <atomic>
 #include <random>
 
 uint32_t array[1024 * 1024];
@@ -49,6 +53,65 @@ TEST(Parallel, parallel_for) {
   ASSERT_EQ(range[2049], 1u);
 }
 
+TEST(Parallel, NestedParallelFor) {
+  std::atomic<unsigned> Count{0};
+  parallelFor(0, 64, [&](size_t I) {
+    parallelFor(0, 64, [&](size_t J) { ++Count; });
+  });
+  EXPECT_EQ(Count, 64u * 64u);
+}
+
+static unsigned fib(unsigned N) {
+  if (N < 2)
+    return N;
+  unsigned A, B;
+  {
+    parallel::TaskGroup TG;
+    TG.spawn([&] { A = fib(N - 1); });
+    B = fib(N - 2);
+  }
+  return A + B;
+}
+
+TEST(Parallel, NestedTaskGroup) {
+  parallel::TaskGroup TG;
+  unsigned Result;
+  TG.spawn([&] { Result = fib(16); });
+  TG.sync();
+  EXPECT_EQ(Result, 987u);
+}
+
+#if LLVM_ENABLE_THREADS
+// A thread waiting for a group must not run unrelated tasks on top of the
+// waiting one, since those could e.g. take a lock the waiting task holds.
+static thread_local bool InOuterTask = false;
+
+TEST(Parallel, WaitOnlyRunsTasksOfGroup) {
+  std::atomic<bool> Nested{false};
+  std::atomic<unsigned> Count{0};
+  auto OtherTask = [&] {
+    if (InOuterTask)
+      Nested = true;
+    ++Count;
+  };
+  {
+    parallel::TaskGroup Outer;
+    Outer.spawn([&] {
+      InOuterTask = true;
+      parallel::TaskGroup Inner;
+      Inner.spawn([&] { ++Count; });
+      // Queued after the task of Inner, so a waiter taking the newest task
+      // of its own queue would pick it first.
+      Outer.spawn(OtherTask);
+      Inner.sync();
+      InOuterTask = false;
+    });
+  }
+  EXPECT_FALSE(Nested);
+  EXPECT_EQ(Count, 2u);
+}
+#endif
+
 TEST(Parallel, TransformReduce) {
   // Sum an empty list, check that it works.
   auto identity = [](uint32_t v) { return v; };
@@ -92,4 +155,28 @@ TEST(Parallel, ForEachError) {
   EXPECT_EQ(errText, std::string("asdf\nasdf\nasdf"));
 }
 
+TEST(Parallel, Hash) {
+  auto HashFn = [](uint8_t *Dest, ArrayRef<uint8_t> Bytes) {
+    support::endian::write64le(Dest, xxh3_64bits(Bytes));
+  };
+  // The hash of the hashes of the chunks, the last one being partial.
+  std::vector<uint8_t> Data(10 * 1000 + 3);
+  for (size_t I = 0; I < Data.size(); ++I)
+    Data[I] = I * 7;
+  std::vector<uint8_t> Hashes(11 * 8);
+  for (size_t I = 0; I < 11; ++I)
+    HashFn(&Hashes[I * 8], makeArrayRef(Data).slice(I * 1000).take_front(1000));
+  uint8_t Expected[8];
+  HashFn(Expected, Hashes);
+
+  uint8_t Hash[8];
+  parallelHash(Hash, Data, HashFn, 1000);
+  EXPECT_EQ(makeArrayRef(Expected), makeArrayRef(Hash));
+
+  // Empty data has no chunks.
+  HashFn(Expected, {});
+  parallelHash(Hash, {}, HashFn, 1000);
+  EXPECT_EQ(makeArrayRef(Expected), makeArrayRef(Hash));
+}
+
 #endif
@@ -335,6 +335,111 @@ TEST_F(ThreadPoolTest, RecursiveWaitDeadlock) {
   Group.wait();
 }
 
+// Check that queued tasks of a group with a higher priority run first.
+TEST_F(ThreadPoolTest, GroupPriority) {
+  CHECK_UNSUPPORTED();
+  ThreadPool Pool(hardware_concurrency(1));
+  ThreadPoolTaskGroup Low(Pool);
+  ThreadPoolTaskGroup High(Pool, /*Priority=*/1);
+
+  // Keep the only thread busy until all tasks are queued.
+  Pool.async([this] { waitForMainThread(); });
+  std::mutex Lock;
+  std::vector<int> Order;
+  for (int I = 0; I < 3; ++I) {
+    Low.async([&Lock, &Order] {
+      std::lock_guard<std::mutex> Guard(Lock);
+      Order.push_back(0);
+    });
+    High.async([&Lock, &Order] {
+      std::lock_guard<std::mutex> Guard(Lock);
+      Order.push_back(1);
+    });
+  }
+  setMainThreadReady();
+  Pool.wait();
+  ASSERT_EQ(std::vector<int>({1, 1, 1, 0, 0, 0}), Order);
+}
+
+// Check that a group does not run more tasks at once than it allows.
+TEST_F(ThreadPoolTest, GroupMaxConcurrency) {
+  CHECK_UNSUPPORTED();
+  ThreadPool Pool(hardware_concurrency(4));
+  ThreadPoolTaskGroup Group(Pool, /*Priority=*/0, /*MaxConcurrency=*/2);
+
+  std::atomic_int Active{0};
+  std::atomic_int MaxActive{0};
+  for (size_t I = 0; I < 10; ++I) {
+    Group.async([this, &Active, &MaxActive] {
+      waitForMainThread();
+      int Now = ++Active;
+      int Max = MaxActive;
+      while (Now > Max && !MaxActive.compare_exchange_weak(Max, Now))
+        ;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      --Active;
+    });
+  }
+  setMainThreadReady();
+  Group.wait();
+  ASSERT_LE(MaxActive.load(), 2);
+}
+
+// Check that a task submitted with asyncAfter() waits for the other group
+// without taking a thread away from other tasks.
+TEST_F(ThreadPoolTest, AsyncAfter) {
+  CHECK_UNSUPPORTED();
+  ThreadPoolStrategy S = hardware_concurrency(2);
+  if (S.compute_thread_count() < 2)
+    return;
+  ThreadPool Pool(S);
+  // Leave the second thread free for other tasks.
+  ThreadPoolTaskGroup First(Pool, /*Priority=*/0, /*MaxConcurrency=*/1);
+  ThreadPoolTaskGroup Second(Pool);
+
+  // Nothing to wait for in an empty group.
+  Pool.asyncAfter(First, [] {}).get();
+
+  std::atomic_int checked_in{0};
+  for (size_t I = 0; I < 5; ++I) {
+    First.async([this, &checked_in] {
+      waitForMainThread();
+      ++checked_in;
+    });
+  }
+  auto SeenByDependent =
+      Second.asyncAfter(First, [&checked_in] { return checked_in.load(); });
+  // The waiting task must not prevent the other thread from running this.
+  Pool.async([] {}).get();
+  ASSERT_EQ(0, checked_in);
+  setMainThreadReady();
+  Second.wait();
+  ASSERT_EQ(5, SeenByDependent.get());
+}
+
+// Check that the tasks of a group can see that it was cancelled.
+TEST_F(ThreadPoolTest, GroupCancel) {
+  CHECK_UNSUPPORTED();
+  ThreadPool Pool;
+  ThreadPoolTaskGroup Group(Pool);
+
+  std::atomic_int checked_in{0};
+  for (size_t I = 0; I < 5; ++I) {
+    Group.async([this, &Group, &checked_in] {
+      waitForMainThread();
+      if (Group.isCancelled())
+        return;
+      ++checked_in;
+    });
+  }
+  ASSERT_FALSE(Group.isCancelled());
+  Group.cancel();
+  ASSERT_TRUE(Group.isCancelled());
+  setMainThreadReady();
+  Group.wait();
+  ASSERT_EQ(0, checked_in);
+}
+
 #if LLVM_ENABLE_THREADS == 1
 
 // FIXME: Skip some tests below on non-Windows because multi-socket systems
@@ -54,6 +54,33 @@ TEST(TimeProfiler, Begin_End_Smoke) {
   ASSERT_TRUE(json.find(R"("detail":"detail")") != std::string::npos);
 }
 
+TEST(TimeProfiler, Summary) {
+  // Make sure that even short events are summarized.
+  timeTraceProfilerInitialize(/*TimeTraceGranularity=*/1000000, "test",
+                              /*Summary=*/true);
+
+  {
+    TimeTraceScope Outer("event", "a");
+    // Nested occurrences of the same event and detail are counted once.
+    { TimeTraceScope Inner("event", "a"); }
+    { TimeTraceScope Inner("event", "b"); }
+  }
+  { TimeTraceScope Scope("event", "a"); }
+
+  SmallVector<char, 1024> Buffer;
+  raw_svector_ostream OS(Buffer);
+  timeTraceProfilerWriteSummary(OS);
+  timeTraceProfilerCleanup();
+
+  std::string Json = OS.str().str();
+  EXPECT_NE(Json.find(R"("process":"test")"), std::string::npos);
+  EXPECT_NE(Json.find(R"("name":"event","count":2,)"), std::string::npos);
+  EXPECT_NE(Json.find(R"("name":"event","detail":"a","count":2,)"),
+            std::string::npos);
+  EXPECT_NE(Json.find(R"("name":"event","detail":"b","count":1,)"),
+            std::string::npos);
+}
+
 TEST(TimeProfiler, Begin_End_Disabled) {
   // Nothing should be observable here. The test is really just making sure
   // we've not got a stray nullptr deref.
@@ -8,6 +8,7 @@
 
 #include "llvm/Support/xxhash.h"
 #include "gtest/gtest.h"
+#include <vector>
 
 using namespace llvm;
 
@@ -17,3 +18,78 @@ TEST(xxhashTest, Basic) {
   EXPECT_EQ(0x69196c1b3af0bff9U,
             xxHash64("0123456789abcdefghijklmnopqrstuvwxyz"));
 }
+
+TEST(xxhashTest, xxh3) {
+  EXPECT_EQ(0xab6e5f64077e7d8aU, xxh3_64bits("foo"));
+  EXPECT_EQ(0xd463c860a032d362U, xxh3_64bits("bar"));
+  EXPECT_EQ(0xffb92a87c6306d55U,
+            xxh3_64bits("0123456789abcdefghijklmnopqrstuvwxyz"));
+
+  // Cover all code paths, including the ones of the inputs longer than a
+  // block of 1024 bytes.
+  constexpr size_t Size = 100000;
+  std::vector<uint8_t> A(Size);
+  uint64_t X = 2654435761U;
+  for (uint8_t &C : A) {
+    X = X * 0x5851F42D4C957F2DU + 0x14057B7EF767814FU;
+    C = X >> 56;
+  }
+#define F(Len, Value)                                                          \
+  EXPECT_EQ(uint64_t(Value), xxh3_64bits(makeArrayRef(A).take_front(Len)));
+  F(0, 0x2d06800538d394c2);
+  F(1, 0x77ead0d66864b856);
+  F(3, 0xb8f67bd3f3f82bed);
+  F(4, 0xfa5c7b94115cce8f);
+  F(9, 0xd720d0c6509b9bdc);
+  F(16, 0x1c96388a45b29258);
+  F(17, 0xe9fbf667ae7c2962);
+  F(33, 0xe9caac9d671fcc26);
+  F(65, 0x8408cc8eb8611d54);
+  F(97, 0x7662271b208ffbd7);
+  F(128, 0x68860b4fe115e020);
+  F(129, 0x8c746ec48ad239d2);
+  F(240, 0xc878dfc585f17c5a);
+  F(241, 0xc86d146e69770099);
+  F(1024, 0xa4adb9ece093d3ce);
+  F(1025, 0xeb64e2b2389021b3);
+  F(4096, 0x7ab5bee496819a63);
+  F(Size, 0x8510c5baed6a8d48);
+#undef F
+}
+
+TEST(xxhashTest, xxh3_128bits) {
+  XXH128_hash_t Hash = xxh3_128bits("foo");
+  EXPECT_EQ(0xab6e5f64077e7d8aU, Hash.low64);
+  EXPECT_EQ(0x79aef92e83454121U, Hash.high64);
+
+  constexpr size_t Size = 100000;
+  std::vector<uint8_t> A(Size);
+  uint64_t X = 2654435761U;
+  for (uint8_t &C : A) {
+    X = X * 0x5851F42D4C957F2DU + 0x14057B7EF767814FU;
+    C = X >> 56;
+  }
+#define F(Len, Low, High)                                                      \
+  Hash = xxh3_128bits(makeArrayRef(A).take_front(Len));                        \
+  EXPECT_EQ(uint64_t(Low), Hash.low64);                                        \
+  EXPECT_EQ(uint64_t(High), Hash.high64);
+  F(0, 0x6001c324468d497f, 0x99aa06d3014798d8);
+  F(1, 0x77ead0d66864b856, 0x5475b13fc0b8d7cf);
+  F(3, 0xb8f67bd3f3f82bed, 0x9c612cd9d7508a77);
+  F(4, 0x9b89cdcb481d6cf9, 0x91690504b33d937f);
+  F(9, 0xa04bf88e3d33d6ae, 0xc8e8f855d080b79c);
+  F(16, 0xdb1d81d046b32632, 0x587df746ca04fc48);
+  F(17, 0xdbf32e3ccace8eaf, 0x2f8fbe0bcc0b6804);
+  F(33, 0x527e5c310e3845b9, 0x752d7810a0ff5c55);
+  F(65, 0x243488e3d822414c, 0x832e70afbb0f79db);
+  F(97, 0x4eba85497e54e799, 0x1c1edf3b66b5f403);
+  F(128, 0x8694ac1cdd66259d, 0x5bdfec9eb33e5650);
+  F(129, 0x4fed5d1c8dee4473, 0xcda3379fea2ef6f5);
+  F(240, 0x4924a74ea2fc341b, 0xb021482331caf8f8);
+  F(241, 0xc86d146e69770099, 0xb0a121a8125c96b3);
+  F(1024, 0xa4adb9ece093d3ce, 0x1a511d576eedc1cd);
+  F(1025, 0xeb64e2b2389021b3, 0x8ee1a880076738eb);
+  F(4096, 0x7ab5bee496819a63, 0x434392692f3cd928);
+  F(Size, 0x8510c5baed6a8d48, 0xd197dbc96aadb5f3);
+#undef F
+}